@@ -417,6 +417,80 @@ VLC_API vlc_tick_t decoder_GetDisplayDate( decoder_t *, vlc_tick_t ) VLC_USED;
  */
 VLC_API int decoder_GetDisplayRate( decoder_t * ) VLC_USED;
 
+/**
+ * \defgroup decoder_frame_threads Decoder frame threading
+ * Helper decoding independent units (intra-only frames) in parallel.
+ *
+ * The units submitted from the decoder thread are decoded by worker threads,
+ * and the resulting pictures are queued with decoder_QueueVideo() in the
+ * submission order.
+ * @{
+ */
+typedef struct decoder_frame_threads_t decoder_frame_threads_t;
+
+typedef struct
+{
+    /**
+     * Create the state used by one worker thread (optional)
+     *
+     * \return the state, or NULL on error
+     */
+    void *(*pf_open)( decoder_t * );
+    /** Destroy the state of a worker thread (optional) */
+    void  (*pf_close)( decoder_t *, void *p_thread_sys );
+
+    /**
+     * Decode one unit, called from a worker thread
+     *
+     * The block must be released. The picture, if any, must be allocated
+     * with decoder_FrameThreadsNewPicture().
+     */
+    picture_t *(*pf_decode)( decoder_t *, void *p_thread_sys, block_t * );
+} decoder_frame_threads_cbs_t;
+
+/**
+ * Create the worker threads of a decoder
+ *
+ * It must be called from the decoder open callback, as it reserves extra
+ * picture buffers for the units in flight.
+ *
+ * \param i_threads number of worker threads (0 for the number of CPUs)
+ * \return the helper, or NULL on error
+ */
+VLC_API decoder_frame_threads_t * decoder_FrameThreadsNew( decoder_t *, const decoder_frame_threads_cbs_t *, unsigned i_threads ) VLC_USED;
+
+/**
+ * Stop the worker threads, dropping the units not yet decoded
+ */
+VLC_API void decoder_FrameThreadsDelete( decoder_frame_threads_t * );
+
+/**
+ * Submit one unit, or wait for all the submitted units to be output if
+ * p_block is NULL (drain)
+ *
+ * It blocks while too many units are in flight.
+ *
+ * \return VLCDEC_SUCCESS
+ */
+VLC_API int decoder_FrameThreadsDecode( decoder_frame_threads_t *, block_t *p_block );
+
+/**
+ * Drop all the units in flight, no picture from them is output afterwards
+ */
+VLC_API void decoder_FrameThreadsFlush( decoder_frame_threads_t * );
+
+/**
+ * Allocate the output picture of the unit being decoded, from a worker
+ * thread
+ *
+ * The decoder output format is updated to the given one first. As the
+ * pictures are output in order, a format change waits for all the previous
+ * units to be output.
+ */
+VLC_API picture_t * decoder_FrameThreadsNewPicture( decoder_frame_threads_t *, const video_format_t * ) VLC_USED;
+
+/** @} */
+
 /** @} */
 /** @} */
 #endif /* _VLC_CODEC_H */
@@ -184,6 +184,26 @@ VLC_USED;
  */
 VLC_API unsigned picture_pool_GetSize(const picture_pool_t *);
 
+/**
+ * Picture pool usage statistics
+ */
+typedef struct
+{
+    unsigned long gets;   /**< pictures handed out so far */
+    unsigned long misses; /**< picture_pool_Get() calls without a free picture */
+    unsigned long waits;  /**< picture_pool_Wait() calls that had to block */
+    unsigned      in_use; /**< pictures currently handed out */
+    unsigned      peak;   /**< highest number of pictures handed out at once */
+} picture_pool_stats_t;
+
+/**
+ * Reads the usage statistics of a pool.
+ *
+ * @note This function is thread-safe, but the counters are read
+ * independently from one another.
+ */
+VLC_API void picture_pool_GetStats(picture_pool_t *, picture_pool_stats_t *);
+
 
 #endif /* VLC_PICTURE_POOL_H */
 
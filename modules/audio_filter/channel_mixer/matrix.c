@@ -0,0 +1,344 @@
+/*****************************************************************************
+ * matrix.c : channel mixing matrix
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_cpu.h>
+#include "matrix.h"
+
+#if defined(CAN_COMPILE_SSE) || defined(CAN_COMPILE_AVX2)
+# include <immintrin.h>
+#endif
+
+/*****************************************************************************
+ * Plain C
+ *****************************************************************************/
+static void MixC(const channel_matrix_t *m, float *restrict dst,
+                 const float *restrict src, size_t frames)
+{
+    for (; frames > 0; frames--)
+    {
+        for (unsigned o = 0; o < m->out_channels; o++)
+        {
+            float s = 0.f;
+
+            for (unsigned j = 0; j < m->in_count; j++)
+            {
+                unsigned c = m->in_idx[j];
+                s += m->coefs[o][c] * src[c];
+            }
+            *(dst++) = s;
+        }
+        src += m->in_channels;
+    }
+}
+
+/*****************************************************************************
+ * SSE
+ *****************************************************************************/
+#if defined(CAN_COMPILE_SSE)
+/* Loads n (up to 4) floats, zeroing the other lanes */
+__attribute__ ((__target__ ("sse")))
+static inline __m128 LoadPartial_SSE(const float *p, unsigned n)
+{
+    switch (n)
+    {
+        case 0:
+            return _mm_setzero_ps();
+        case 1:
+            return _mm_load_ss(p);
+        case 2:
+            return _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)p);
+        case 3:
+            return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(),
+                                              (const __m64 *)p),
+                                 _mm_load_ss(p + 2));
+        default:
+            return _mm_loadu_ps(p);
+    }
+}
+
+/* Stereo output from up to 8 input channels: whole frames are loaded and
+ * multiplied by both rows, then the products are summed across. */
+__attribute__ ((__target__ ("sse")))
+static void MixStereoRows_SSE(const channel_matrix_t *m, float *restrict dst,
+                              const float *restrict src, size_t frames)
+{
+    const unsigned in = m->in_channels;
+    const unsigned n_lo = (in > 4) ? 4 : in, n_hi = in - n_lo;
+    const __m128 l_lo = _mm_loadu_ps(m->coefs[0]);
+    const __m128 l_hi = _mm_loadu_ps(m->coefs[0] + 4);
+    const __m128 r_lo = _mm_loadu_ps(m->coefs[1]);
+    const __m128 r_hi = _mm_loadu_ps(m->coefs[1] + 4);
+
+    assert(in <= 8);
+    for (; frames >= 2; frames -= 2, src += 2 * in, dst += 4)
+    {
+        __m128 lo0 = LoadPartial_SSE(src, n_lo);
+        __m128 hi0 = LoadPartial_SSE(src + 4, n_hi);
+        __m128 lo1 = LoadPartial_SSE(src + in, n_lo);
+        __m128 hi1 = LoadPartial_SSE(src + in + 4, n_hi);
+
+        __m128 l0 = _mm_add_ps(_mm_mul_ps(lo0, l_lo), _mm_mul_ps(hi0, l_hi));
+        __m128 r0 = _mm_add_ps(_mm_mul_ps(lo0, r_lo), _mm_mul_ps(hi0, r_hi));
+        __m128 l1 = _mm_add_ps(_mm_mul_ps(lo1, l_lo), _mm_mul_ps(hi1, l_hi));
+        __m128 r1 = _mm_add_ps(_mm_mul_ps(lo1, r_lo), _mm_mul_ps(hi1, r_hi));
+
+        _MM_TRANSPOSE4_PS(l0, r0, l1, r1);
+        _mm_storeu_ps(dst, _mm_add_ps(_mm_add_ps(l0, r0), _mm_add_ps(l1, r1)));
+    }
+    MixC(m, dst, src, frames);
+}
+
+/* Stereo output from 8.1: two frames per vector */
+__attribute__ ((__target__ ("sse")))
+static void MixStereo_SSE(const channel_matrix_t *m, float *restrict dst,
+                          const float *restrict src, size_t frames)
+{
+    const unsigned in = m->in_channels;
+
+    for (; frames >= 2; frames -= 2, src += 2 * in, dst += 4)
+    {
+        __m128 acc = _mm_setzero_ps();
+
+        for (unsigned j = 0; j < m->in_count; j++)
+        {
+            unsigned c = m->in_idx[j];
+            /* s0 s0 s1 s1 */
+            __m128 s = _mm_shuffle_ps(_mm_load_ss(src + c),
+                                      _mm_load_ss(src + in + c), 0);
+            acc = _mm_add_ps(acc, _mm_mul_ps(s, _mm_loadu_ps(m->cols[c])));
+        }
+        _mm_storeu_ps(dst, acc);
+    }
+    MixC(m, dst, src, frames);
+}
+
+/* Up to 8 output channels: one frame per iteration. Whole vectors are
+ * stored while the rest of the buffer is large enough, spilling into the
+ * next frames, which are overwritten afterwards. */
+__attribute__ ((__target__ ("sse")))
+static void Mix_SSE(const channel_matrix_t *m, float *restrict dst,
+                    const float *restrict src, size_t frames)
+{
+    const unsigned in = m->in_channels;
+    const unsigned out = m->out_channels;
+    const unsigned width = (out > 4) ? 8 : 4;
+
+    assert(out <= 8);
+    for (; frames > 0; frames--, src += in, dst += out)
+    {
+        __m128 lo = _mm_setzero_ps(), hi = _mm_setzero_ps();
+
+        for (unsigned j = 0; j < m->in_count; j++)
+        {
+            unsigned c = m->in_idx[j];
+            __m128 s = _mm_load1_ps(src + c);
+
+            lo = _mm_add_ps(lo, _mm_mul_ps(s, _mm_loadu_ps(m->cols[c])));
+            if (out > 4)
+                hi = _mm_add_ps(hi, _mm_mul_ps(s, _mm_loadu_ps(m->cols[c] + 4)));
+        }
+
+        if (frames * out >= width)
+        {
+            _mm_storeu_ps(dst, lo);
+            if (out > 4)
+                _mm_storeu_ps(dst + 4, hi);
+        }
+        else
+        {
+            float buf[8];
+
+            _mm_storeu_ps(buf, lo);
+            _mm_storeu_ps(buf + 4, hi);
+            memcpy(dst, buf, out * sizeof (float));
+        }
+    }
+}
+#endif
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#if defined(CAN_COMPILE_AVX2)
+/* Stereo output from up to 8 input channels, see MixStereoRows_SSE() */
+__attribute__ ((__target__ ("avx2")))
+static void MixStereoRows_AVX2(const channel_matrix_t *m, float *restrict dst,
+                               const float *restrict src, size_t frames)
+{
+    const unsigned in = m->in_channels;
+    const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(in),
+                                    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256 l = _mm256_loadu_ps(m->coefs[0]);
+    const __m256 r = _mm256_loadu_ps(m->coefs[1]);
+
+    assert(in <= 8);
+    for (; frames >= 2; frames -= 2, src += 2 * in, dst += 4)
+    {
+        __m256 f0 = _mm256_maskload_ps(src, mask);
+        __m256 f1 = _mm256_maskload_ps(src + in, mask);
+        __m256 a = _mm256_hadd_ps(_mm256_mul_ps(f0, l), _mm256_mul_ps(f0, r));
+        __m256 b = _mm256_hadd_ps(_mm256_mul_ps(f1, l), _mm256_mul_ps(f1, r));
+        /* L0 R0 L1 R1, partial sums in each 128-bits lane */
+        __m256 s = _mm256_hadd_ps(a, b);
+
+        _mm_storeu_ps(dst, _mm_add_ps(_mm256_castps256_ps128(s),
+                                      _mm256_extractf128_ps(s, 1)));
+    }
+    MixC(m, dst, src, frames);
+}
+
+/* Stereo output from 8.1: four frames per vector */
+__attribute__ ((__target__ ("avx2")))
+static void MixStereo_AVX2(const channel_matrix_t *m, float *restrict dst,
+                           const float *restrict src, size_t frames)
+{
+    const unsigned in = m->in_channels;
+
+    for (; frames >= 4; frames -= 4, src += 4 * in, dst += 8)
+    {
+        __m256 acc = _mm256_setzero_ps();
+
+        for (unsigned j = 0; j < m->in_count; j++)
+        {
+            unsigned c = m->in_idx[j];
+            __m128 s01 = _mm_shuffle_ps(_mm_load_ss(src + c),
+                                        _mm_load_ss(src + in + c), 0);
+            __m128 s23 = _mm_shuffle_ps(_mm_load_ss(src + 2 * in + c),
+                                        _mm_load_ss(src + 3 * in + c), 0);
+            __m256 s = _mm256_insertf128_ps(_mm256_castps128_ps256(s01),
+                                            s23, 1);
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(s,
+                                                   _mm256_loadu_ps(m->cols[c])));
+        }
+        _mm256_storeu_ps(dst, acc);
+    }
+    MixC(m, dst, src, frames);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void Mix_AVX2(const channel_matrix_t *m, float *restrict dst,
+                     const float *restrict src, size_t frames)
+{
+    const unsigned in = m->in_channels;
+    const unsigned out = m->out_channels;
+
+    assert(out <= 8);
+    for (; frames > 0; frames--, src += in, dst += out)
+    {
+        __m256 acc = _mm256_setzero_ps();
+
+        for (unsigned j = 0; j < m->in_count; j++)
+        {
+            unsigned c = m->in_idx[j];
+            acc = _mm256_add_ps(acc,
+                                _mm256_mul_ps(_mm256_broadcast_ss(src + c),
+                                              _mm256_loadu_ps(m->cols[c])));
+        }
+
+        if (frames * out >= 8)
+            _mm256_storeu_ps(dst, acc);
+        else
+        {
+            float buf[8];
+
+            _mm256_storeu_ps(buf, acc);
+            memcpy(dst, buf, out * sizeof (float));
+        }
+    }
+}
+#endif
+
+void channel_matrix_Init(channel_matrix_t *m, const float *coefs,
+                         unsigned in_channels, unsigned out_channels,
+                         unsigned cpu)
+{
+    assert(in_channels > 0 && in_channels <= AOUT_CHAN_MAX);
+    assert(out_channels > 0 && out_channels <= AOUT_CHAN_MAX);
+
+    m->in_channels = in_channels;
+    m->out_channels = out_channels;
+    m->in_count = 0;
+    memset(m->coefs, 0, sizeof (m->coefs));
+    memset(m->cols, 0, sizeof (m->cols));
+
+    for (unsigned c = 0; c < in_channels; c++)
+    {
+        bool used = false;
+
+        for (unsigned o = 0; o < out_channels; o++)
+        {
+            float w = coefs[o * in_channels + c];
+
+            m->coefs[o][c] = w;
+            if (w != 0.f)
+                used = true;
+        }
+        if (!used)
+            continue;
+
+        m->in_idx[m->in_count++] = c;
+        /* The stereo kernels compute several frames at once and need the
+         * weights repeated. */
+        for (unsigned i = 0; i < 8; i++)
+            if (out_channels == 2)
+                m->cols[c][i] = m->coefs[i & 1][c];
+            else if (i < out_channels)
+                m->cols[c][i] = m->coefs[i][c];
+    }
+
+    m->name = "C";
+    m->mix = MixC;
+    /* A mono output is a plain dot product, and a 8.1 output does not fit
+     * the vectors: keep the C code. */
+    if (out_channels == 1 || out_channels > 8)
+        return;
+
+#if defined(CAN_COMPILE_AVX2)
+    if (cpu & VLC_CPU_AVX2)
+    {
+        m->name = "AVX2";
+        if (out_channels == 2)
+            m->mix = (in_channels <= 8) ? MixStereoRows_AVX2 : MixStereo_AVX2;
+        else
+            m->mix = Mix_AVX2;
+        return;
+    }
+#endif
+#if defined(CAN_COMPILE_SSE)
+    if (cpu & VLC_CPU_SSE)
+    {
+        m->name = "SSE";
+        if (out_channels == 2)
+            m->mix = (in_channels <= 8) ? MixStereoRows_SSE : MixStereo_SSE;
+        else
+            m->mix = Mix_SSE;
+        return;
+    }
+#endif
+    (void) cpu;
+}
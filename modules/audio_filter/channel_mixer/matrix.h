@@ -0,0 +1,68 @@
+/*****************************************************************************
+ * matrix.h : channel mixing matrix
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_CHANNEL_MIXER_MATRIX_H
+#define VLC_CHANNEL_MIXER_MATRIX_H 1
+
+typedef struct channel_matrix channel_matrix_t;
+
+/**
+ * Linear mix of interleaved FL32 frames: each output channel is a weighted
+ * sum of the input channels. Upmixing, downmixing and remapping are all
+ * expressed this way.
+ */
+struct channel_matrix
+{
+    const char *name; /**< Kernel name, for debugging */
+    void (*mix)(const channel_matrix_t *, float *restrict,
+                const float *restrict, size_t);
+
+    unsigned in_channels;
+    unsigned out_channels;
+    /** Input channels with at least one non-zero weight */
+    unsigned in_count;
+    uint8_t in_idx[AOUT_CHAN_MAX];
+
+    /** Weights, per output then per input channel */
+    float coefs[AOUT_CHAN_MAX][AOUT_CHAN_MAX];
+    /** Weights per input channel, laid out for the vector kernels */
+    float cols[AOUT_CHAN_MAX][8];
+};
+
+/**
+ * Prepares a matrix.
+ *
+ * @param coefs out_channels rows of in_channels weights
+ * @param cpu CPU capabilities the kernel may use (typically vlc_CPU())
+ */
+void channel_matrix_Init(channel_matrix_t *, const float *coefs,
+                         unsigned in_channels, unsigned out_channels,
+                         unsigned cpu);
+
+/**
+ * Mixes frames. The buffers must not overlap.
+ */
+static inline void channel_matrix_Mix(const channel_matrix_t *m, float *dst,
+                                      const float *src, size_t frames)
+{
+    m->mix(m, dst, src, frames);
+}
+
+#endif
@@ -32,8 +32,11 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 #include <vlc_block.h>
+#include <vlc_cpu.h>
 #include <assert.h>
 
+#include "matrix.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -110,6 +113,7 @@ struct filter_sys_t
     int nb_in_ch[AOUT_CHAN_MAX];
     int8_t map_ch[AOUT_CHAN_MAX];
     bool b_normalize;
+    channel_matrix_t matrix;
 };
 
 static const uint32_t valid_channels[] = {
@@ -223,6 +227,18 @@ DEFINE_REMAP( FL64, double   )
 
 #undef DEFINE_REMAP
 
+static void RemapMatrixFL32( filter_t *p_filter,
+                             const void *p_src, void *p_dest,
+                             int i_nb_samples,
+                             unsigned i_nb_in_channels,
+                             unsigned i_nb_out_channels )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    VLC_UNUSED(i_nb_in_channels); VLC_UNUSED(i_nb_out_channels);
+    channel_matrix_Mix( &p_sys->matrix, p_dest, p_src, i_nb_samples );
+}
+
 static inline remap_fun_t GetRemapFun( audio_format_t *p_format, bool b_add )
 {
     if( b_add )
@@ -351,7 +367,25 @@ static int OpenFilter( vlc_object_t *p_this )
             b_multiple = true;
     }
 
-    p_sys->pf_remap = GetRemapFun( audio_in, b_multiple );
+    if( audio_in->i_format == VLC_CODEC_FL32 )
+    {
+        /* Copies and sums are both a matrix with FL32 */
+        float coefs[AOUT_CHAN_MAX * AOUT_CHAN_MAX] = { 0.f };
+
+        for( uint8_t i = 0; i < audio_in->i_channels; i++ )
+        {
+            int8_t out_ch = p_sys->map_ch[i];
+            if( out_ch < 0 )
+                continue;
+            coefs[out_ch * audio_in->i_channels + i] = p_sys->b_normalize
+                ? 1.f / p_sys->nb_in_ch[out_ch] : 1.f;
+        }
+        channel_matrix_Init( &p_sys->matrix, coefs, audio_in->i_channels,
+                             i_channels, vlc_CPU() );
+        p_sys->pf_remap = RemapMatrixFL32;
+    }
+    else
+        p_sys->pf_remap = GetRemapFun( audio_in, b_multiple );
     if( !p_sys->pf_remap )
     {
         msg_Err( p_filter, "Could not decide on %s remap function", b_multiple ? "an add" : "a copy" );
@@ -413,7 +447,9 @@ static block_t *Remap( filter_t *p_filter, block_t *p_block )
     p_out->i_pts = p_block->i_pts;
     p_out->i_length = p_block->i_length;
 
-    memset( p_out->p_buffer, 0, i_out_size );
+    /* The matrix writes all the output channels */
+    if( p_sys->pf_remap != RemapMatrixFL32 )
+        memset( p_out->p_buffer, 0, i_out_size );
 
     p_sys->pf_remap( p_filter,
                 (const void *)p_block->p_buffer, (void *)p_out->p_buffer,
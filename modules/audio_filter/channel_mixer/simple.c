@@ -33,245 +33,145 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 #include <vlc_block.h>
+#include <vlc_cpu.h>
+
+#include <assert.h>
+
+#include "matrix.h"
 
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
 static int  OpenFilter( vlc_object_t * );
+static void CloseFilter( vlc_object_t * );
 
 vlc_module_begin ()
     set_description( N_("Audio filter for simple channel mixing") )
     set_category( CAT_AUDIO )
     set_subcategory( SUBCAT_AUDIO_MISC )
     set_capability( "audio converter", 10 )
-    set_callbacks( OpenFilter, NULL );
+    set_callbacks( OpenFilter, CloseFilter );
 vlc_module_end ()
 
 static block_t *Filter( filter_t *, block_t * );
 
-static void DoWork_7_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        float ctr = p_src[6] * 0.7071f;
-        *p_dest++ = ctr + p_src[0] + p_src[2] / 4 + p_src[4] / 4;
-        *p_dest++ = ctr + p_src[1] + p_src[3] / 4 + p_src[5] / 4;
-
-        p_src += 7;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_6_1_to_2_0( filter_t *p_filter, block_t *p_in_buf,
-                               block_t *p_out_buf )
+/*****************************************************************************
+ * Downmix matrices
+ *****************************************************************************
+ * Weights of the input channels (LFE excluded) for each output channel (LFE
+ * excluded), in the VLC channel order. The LFE is dropped, unless both the
+ * input and the output have one.
+ *****************************************************************************/
+typedef struct
 {
-    VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        float ctr = (p_src[2] + p_src[5]) * 0.7071f;
-        *p_dest++ = p_src[0] + p_src[3] + ctr;
-        *p_dest++ = p_src[1] + p_src[4] + ctr;
-
-        p_src += 6;
-
-        /* We always have LFE here */
-        p_src++;
-    }
-}
-
-static void DoWork_5_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[0] + 0.7071f * (p_src[4] + p_src[2]);
-        *p_dest++ = p_src[1] + 0.7071f * (p_src[4] + p_src[3]);
-
-        p_src += 5;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_4_0_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[2] + p_src[3] + 0.5f * p_src[0];
-        *p_dest++ = p_src[2] + p_src[3] + 0.5f * p_src[1];
-        p_src += 4;
-    }
-}
-
-static void DoWork_3_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[2] + 0.5f * p_src[0];
-        *p_dest++ = p_src[2] + 0.5f * p_src[1];
-
-        p_src += 3;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_7_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[6] + p_src[0] / 4 + p_src[1] / 4 + p_src[2] / 8 + p_src[3] / 8 + p_src[4] / 8 + p_src[5] / 8;
-
-        p_src += 7;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_5_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = 0.7071f * (p_src[0] + p_src[1]) + p_src[4]
-                     + 0.5f * (p_src[2] + p_src[3]);
-
-        p_src += 5;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_4_0_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[2] + p_src[3] + p_src[0] / 4 + p_src[1] / 4;
-        p_src += 4;
-    }
-}
-
-static void DoWork_3_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[2] + p_src[0] / 4 + p_src[1] / 4;
-
-        p_src += 3;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_2_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[0] / 2 + p_src[1] / 2;
-
-        p_src += 2;
-    }
-}
-
-static void DoWork_7_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[6] + 0.5f * p_src[0] + p_src[2] / 6;
-        *p_dest++ = p_src[6] + 0.5f * p_src[1] + p_src[3] / 6;
-        *p_dest++ = p_src[2] / 6 +  p_src[4];
-        *p_dest++ = p_src[3] / 6 +  p_src[5];
-
-        p_src += 7;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_5_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        float ctr = p_src[4] * 0.7071f;
-        *p_dest++ = p_src[0] + ctr;
-        *p_dest++ = p_src[1] + ctr;
-        *p_dest++ = p_src[2];
-        *p_dest++ = p_src[3];
-
-        p_src += 5;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_7_x_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[0];
-        *p_dest++ = p_src[1];
-        *p_dest++ = (p_src[2] + p_src[4]) * 0.5f;
-        *p_dest++ = (p_src[3] + p_src[5]) * 0.5f;
-        *p_dest++ = p_src[6];
-
-        p_src += 7;
-
-        if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE &&
-            p_filter->fmt_out.audio.i_physical_channels & AOUT_CHAN_LFE )
-            *p_dest++ = *p_src++;
-        else if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
-    }
-}
-
-static void DoWork_6_1_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
-    {
-        *p_dest++ = p_src[0];
-        *p_dest++ = p_src[1];
-        *p_dest++ = (p_src[2] + p_src[4]) * 0.5f;
-        *p_dest++ = (p_src[3] + p_src[4]) * 0.5f;
-        *p_dest++ = p_src[5];
-
-        p_src += 6;
-
-        /* We always have LFE here */
-        *p_dest++ = *p_src++;
-    }
-}
+    unsigned i_in;
+    unsigned i_out;
+    float coefs[5][7];
+} downmix_t;
+
+static const downmix_t downmix_7_x_to_2_0 = { 7, 2, {
+    { 1.f, 0.f, .25f, 0.f, .25f, 0.f, .7071f },
+    { 0.f, 1.f, 0.f, .25f, 0.f, .25f, .7071f },
+} };
+
+static const downmix_t downmix_6_1_to_2_0 = { 6, 2, {
+    { 1.f, 0.f, .7071f, 1.f, 0.f, .7071f },
+    { 0.f, 1.f, .7071f, 0.f, 1.f, .7071f },
+} };
+
+static const downmix_t downmix_5_x_to_2_0 = { 5, 2, {
+    { 1.f, 0.f, .7071f, 0.f, .7071f },
+    { 0.f, 1.f, 0.f, .7071f, .7071f },
+} };
+
+static const downmix_t downmix_4_0_to_2_0 = { 4, 2, {
+    { .5f, 0.f, 1.f, 1.f },
+    { 0.f, .5f, 1.f, 1.f },
+} };
+
+static const downmix_t downmix_3_x_to_2_0 = { 3, 2, {
+    { .5f, 0.f, 1.f },
+    { 0.f, .5f, 1.f },
+} };
+
+static const downmix_t downmix_7_x_to_1_0 = { 7, 1, {
+    { .25f, .25f, .125f, .125f, .125f, .125f, 1.f },
+} };
+
+static const downmix_t downmix_5_x_to_1_0 = { 5, 1, {
+    { .7071f, .7071f, .5f, .5f, 1.f },
+} };
+
+static const downmix_t downmix_4_0_to_1_0 = { 4, 1, {
+    { .25f, .25f, 1.f, 1.f },
+} };
+
+static const downmix_t downmix_3_x_to_1_0 = { 3, 1, {
+    { .25f, .25f, 1.f },
+} };
+
+static const downmix_t downmix_2_x_to_1_0 = { 2, 1, {
+    { .5f, .5f },
+} };
+
+static const downmix_t downmix_7_x_to_4_0 = { 7, 4, {
+    { .5f, 0.f, 1.f / 6, 0.f, 0.f, 0.f, 1.f },
+    { 0.f, .5f, 0.f, 1.f / 6, 0.f, 0.f, 1.f },
+    { 0.f, 0.f, 1.f / 6, 0.f, 1.f, 0.f, 0.f },
+    { 0.f, 0.f, 0.f, 1.f / 6, 0.f, 1.f, 0.f },
+} };
+
+static const downmix_t downmix_5_x_to_4_0 = { 5, 4, {
+    { 1.f, 0.f, 0.f, 0.f, .7071f },
+    { 0.f, 1.f, 0.f, 0.f, .7071f },
+    { 0.f, 0.f, 1.f, 0.f, 0.f },
+    { 0.f, 0.f, 0.f, 1.f, 0.f },
+} };
+
+static const downmix_t downmix_7_x_to_5_x = { 7, 5, {
+    { 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f },
+    { 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f },
+    { 0.f, 0.f, .5f, 0.f, .5f, 0.f, 0.f },
+    { 0.f, 0.f, 0.f, .5f, 0.f, .5f, 0.f },
+    { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f },
+} };
+
+static const downmix_t downmix_6_1_to_5_x = { 6, 5, {
+    { 1.f, 0.f, 0.f, 0.f, 0.f, 0.f },
+    { 0.f, 1.f, 0.f, 0.f, 0.f, 0.f },
+    { 0.f, 0.f, .5f, 0.f, .5f, 0.f },
+    { 0.f, 0.f, 0.f, .5f, .5f, 0.f },
+    { 0.f, 0.f, 0.f, 0.f, 0.f, 1.f },
+} };
+
+typedef void (*do_work_t)( filter_t *, block_t *, block_t * );
+
+struct filter_sys_t
+{
+    do_work_t do_work;
+    channel_matrix_t matrix;
+};
 
 #if defined (CAN_COMPILE_NEON)
 #include "simple_neon.h"
 #define GET_WORK(in, out) GET_WORK_##in##_to_##out##_neon()
 #else
-#define GET_WORK(in, out) DoWork_##in##_to_##out
+#define GET_WORK(in, out) NULL
 #endif
 
+#define SET_DOWNMIX(in, out) do { \
+    p_downmix = &downmix_##in##_to_##out; \
+    do_work = GET_WORK(in, out); \
+} while(0)
+
 /*****************************************************************************
  * OpenFilter:
  *****************************************************************************/
 static int OpenFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
-    void (*do_work)(filter_t *, block_t *, block_t *) = NULL;
+    const downmix_t *p_downmix = NULL;
+    do_work_t do_work = NULL;
 
     if( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32 ||
         p_filter->fmt_in.audio.i_format != p_filter->fmt_out.audio.i_format ||
@@ -304,59 +204,92 @@ static int OpenFilter( vlc_object_t *p_this )
     if( output == AOUT_CHAN_CENTER )
     {
         if( b_input_7_x )
-            do_work = GET_WORK(7_x,1_0);
+            SET_DOWNMIX(7_x,1_0);
         else if( b_input_5_x )
-            do_work = GET_WORK(5_x,1_0);
+            SET_DOWNMIX(5_x,1_0);
         else if( b_input_4_center_rear )
-            do_work = GET_WORK(4_0,1_0);
+            SET_DOWNMIX(4_0,1_0);
         else if( b_input_3_x )
-            do_work = GET_WORK(3_x,1_0);
+            SET_DOWNMIX(3_x,1_0);
         else
-            do_work = GET_WORK(2_x,1_0);
+            SET_DOWNMIX(2_x,1_0);
     }
     else if( output == AOUT_CHANS_2_0 )
     {
         if( b_input_7_x )
-            do_work = GET_WORK(7_x,2_0);
+            SET_DOWNMIX(7_x,2_0);
         else if( b_input_6_1 )
-            do_work = GET_WORK(6_1,2_0);
+            SET_DOWNMIX(6_1,2_0);
         else if( b_input_5_x )
-            do_work = GET_WORK(5_x,2_0);
+            SET_DOWNMIX(5_x,2_0);
         else if( b_input_4_center_rear )
-            do_work = GET_WORK(4_0,2_0);
+            SET_DOWNMIX(4_0,2_0);
         else if( b_input_3_x )
-            do_work = GET_WORK(3_x,2_0);
+            SET_DOWNMIX(3_x,2_0);
     }
     else if( output == AOUT_CHANS_4_0 )
     {
         if( b_input_7_x )
-            do_work = GET_WORK(7_x,4_0);
+            SET_DOWNMIX(7_x,4_0);
         else if( b_input_5_x )
-            do_work = GET_WORK(5_x,4_0);
+            SET_DOWNMIX(5_x,4_0);
     }
     else if( (output & ~AOUT_CHAN_LFE) == AOUT_CHANS_5_0 ||
              (output & ~AOUT_CHAN_LFE) == AOUT_CHANS_5_0_MIDDLE )
     {
         if( b_input_7_x )
-            do_work = GET_WORK(7_x,5_x);
+            SET_DOWNMIX(7_x,5_x);
         else if( b_input_6_1 )
-            do_work = GET_WORK(6_1,5_x);
+            SET_DOWNMIX(6_1,5_x);
     }
 
-    if( do_work == NULL )
+    if( p_downmix == NULL )
         return VLC_EGENERIC;
 
+    filter_sys_t *p_sys = malloc( sizeof(*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    /* Expand the matrix to the actual layouts */
+    const unsigned i_in = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    const unsigned i_out = aout_FormatNbChannels( &p_filter->fmt_out.audio );
+    float coefs[AOUT_CHAN_MAX * AOUT_CHAN_MAX] = { 0.f };
+
+    assert( p_downmix->i_in <= i_in && p_downmix->i_out <= i_out );
+    for( unsigned o = 0; o < p_downmix->i_out; o++ )
+        for( unsigned c = 0; c < p_downmix->i_in; c++ )
+            coefs[o * i_in + c] = p_downmix->coefs[o][c];
+    /* The LFE is the last channel, if any */
+    if( (p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE)
+     && (output & AOUT_CHAN_LFE) )
+        coefs[(i_out - 1) * i_in + i_in - 1] = 1.f;
+
+    channel_matrix_Init( &p_sys->matrix, coefs, i_in, i_out, vlc_CPU() );
+    p_sys->do_work = do_work;
+
+    msg_Dbg( p_filter, "%s to %s with %s kernel",
+             aout_FormatPrintChannels( &p_filter->fmt_in.audio ),
+             aout_FormatPrintChannels( &p_filter->fmt_out.audio ),
+             do_work != NULL ? "NEON" : p_sys->matrix.name );
+
     p_filter->pf_audio_filter = Filter;
-    p_filter->p_sys = (void *)do_work;
+    p_filter->p_sys = p_sys;
     return VLC_SUCCESS;
 }
 
+static void CloseFilter( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
+
 /*****************************************************************************
  * Filter:
  *****************************************************************************/
 static block_t *Filter( filter_t *p_filter, block_t *p_block )
 {
-    void (*work)(filter_t *, block_t *, block_t *) = (void *)p_filter->p_sys;
+    filter_sys_t *p_sys = p_filter->p_sys;
 
     if( !p_block || !p_block->i_nb_samples )
     {
@@ -387,10 +320,14 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
     p_out->i_nb_samples = p_block->i_nb_samples;
     p_out->i_buffer = p_block->i_buffer * i_output_nb / i_input_nb;
 
-    work( p_filter, p_block, p_out );
+    if( p_sys->do_work != NULL )
+        p_sys->do_work( p_filter, p_block, p_out );
+    else
+        channel_matrix_Mix( &p_sys->matrix, (float *)p_out->p_buffer,
+                            (const float *)p_block->p_buffer,
+                            p_block->i_nb_samples );
 
     block_Release( p_block );
 
     return p_out;
 }
-
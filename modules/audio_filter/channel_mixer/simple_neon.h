@@ -44,7 +44,7 @@
     } \
     static inline void (*GET_WORK_##in##_to_##out##_neon())(filter_t*, block_t*, block_t*) \
     { \
-        return vlc_CPU_ARM_NEON() ? DoWork_##in##_to_##out##_neon : DoWork_##in##_to_##out; \
+        return vlc_CPU_ARM_NEON() ? DoWork_##in##_to_##out##_neon : NULL; \
     }
 
 NEON_WRAPPER(7_x,2_0)
@@ -56,12 +56,13 @@ NEON_WRAPPER(5_x,1_0)
 NEON_WRAPPER(7_x,4_0)
 NEON_WRAPPER(5_x,4_0)
 
-/* TODO: the following conversions are not handled in NEON */
+/* TODO: the following conversions are not handled in NEON, the generic
+ * matrix is used instead */
 
 #define C_WRAPPER(in, out) \
     static inline void (*GET_WORK_##in##_to_##out##_neon())(filter_t*, block_t*, block_t*) \
     { \
-        return DoWork_##in##_to_##out; \
+        return NULL; \
     }
 
 C_WRAPPER(4_0,1_0)
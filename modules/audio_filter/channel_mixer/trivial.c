@@ -34,6 +34,9 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#include "matrix.h"
 
 static int Create( vlc_object_t * );
 static void Destroy( vlc_object_t * );
@@ -48,21 +51,18 @@ vlc_module_end ()
 
 struct filter_sys_t
 {
-    int channel_map[AOUT_CHAN_MAX];
+    channel_matrix_t matrix;
 };
 
 /**
- * Trivially upmixes
+ * Trivially upmixes or downmixes (i.e. duplicate or drop channels)
  */
-static block_t *Upmix( filter_t *p_filter, block_t *p_in_buf )
+static block_t *Mix( filter_t *p_filter, block_t *p_in_buf )
 {
-    unsigned i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
     unsigned i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
 
-    assert( i_input_nb < i_output_nb );
-
     block_t *p_out_buf = block_Alloc(
-                              p_in_buf->i_buffer * i_output_nb / i_input_nb );
+                              p_in_buf->i_nb_samples * i_output_nb * sizeof(float) );
     if( unlikely(p_out_buf == NULL) )
     {
         block_Release( p_in_buf );
@@ -74,53 +74,15 @@ static block_t *Upmix( filter_t *p_filter, block_t *p_in_buf )
     p_out_buf->i_pts        = p_in_buf->i_pts;
     p_out_buf->i_length     = p_in_buf->i_length;
 
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (float *)p_in_buf->p_buffer;
-    const int *channel_map = p_filter->p_sys->channel_map;
-
-    for( size_t i = 0; i < p_in_buf->i_nb_samples; i++ )
-    {
-        for( unsigned j = 0; j < i_output_nb; j++ )
-            p_dest[j] = channel_map[j] == -1 ? 0.f : p_src[channel_map[j]];
-
-        p_src += i_input_nb;
-        p_dest += i_output_nb;
-    }
+    channel_matrix_Mix( &p_filter->p_sys->matrix,
+                        (float *)p_out_buf->p_buffer,
+                        (const float *)p_in_buf->p_buffer,
+                        p_in_buf->i_nb_samples );
 
     block_Release( p_in_buf );
     return p_out_buf;
 }
 
-/**
- * Trivially downmixes (i.e. drop extra channels)
- */
-static block_t *Downmix( filter_t *p_filter, block_t *p_buf )
-{
-    unsigned i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
-    unsigned i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
-
-    assert( i_input_nb >= i_output_nb );
-
-    float *p_dest = (float *)p_buf->p_buffer;
-    const float *p_src = p_dest;
-    const int *channel_map = p_filter->p_sys->channel_map;
-    /* Use an extra buffer to avoid overlapping */
-    float buffer[i_output_nb];
-
-    for( size_t i = 0; i < p_buf->i_nb_samples; i++ )
-    {
-        for( unsigned j = 0; j < i_output_nb; j++ )
-            buffer[j] = channel_map[j] == -1 ? 0.f : p_src[channel_map[j]];
-        memcpy( p_dest, buffer, i_output_nb * sizeof(float) );
-
-        p_src += i_input_nb;
-        p_dest += i_output_nb;
-    }
-    p_buf->i_buffer = p_buf->i_buffer * i_output_nb / i_input_nb;
-
-    return p_buf;
-}
-
 static block_t *Equals( filter_t *p_filter, block_t *p_buf )
 {
     (void) p_filter;
@@ -297,12 +259,19 @@ static int Create( vlc_object_t *p_this )
     p_filter->p_sys = malloc( sizeof(*p_filter->p_sys) );
     if(! p_filter->p_sys )
         return VLC_ENOMEM;
-    memcpy( p_filter->p_sys->channel_map, channel_map, sizeof(channel_map) );
 
-    if( aout_FormatNbChannels( outfmt ) > aout_FormatNbChannels( infmt ) )
-        p_filter->pf_audio_filter = Upmix;
-    else
-        p_filter->pf_audio_filter = Downmix;
+    /* Each output channel is a copy of one input channel, or silence */
+    const unsigned i_in = aout_FormatNbChannels( infmt );
+    const unsigned i_out = aout_FormatNbChannels( outfmt );
+    float coefs[AOUT_CHAN_MAX * AOUT_CHAN_MAX] = { 0.f };
+
+    for( unsigned i = 0; i < i_out; ++i )
+        if( channel_map[i] != -1 )
+            coefs[i * i_in + channel_map[i]] = 1.f;
+    channel_matrix_Init( &p_filter->p_sys->matrix, coefs, i_in, i_out,
+                         vlc_CPU() );
+
+    p_filter->pf_audio_filter = Mix;
 
     return VLC_SUCCESS;
 }
@@ -0,0 +1,544 @@
+/*****************************************************************************
+ * polyphase.c : windowed-sinc polyphase resampler
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The input is low-pass filtered and interpolated with a Kaiser-windowed
+ * sinc. The filter is precomputed for a fixed number of fractional
+ * positions (the phases of the filter bank); the filter for an output sample
+ * is linearly interpolated between the two nearest phases. The input
+ * position is tracked in 32.32 fixed point, so any pair of rates, including
+ * the slowly varying ones of the audio output drift compensation, is
+ * supported without rebuilding the bank.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#if defined(CAN_COMPILE_SSE) || defined(CAN_COMPILE_AVX2)
+# include <immintrin.h>
+#endif
+#if defined(__aarch64__) || (defined(__arm__) && defined(__ARM_NEON__))
+# define POLYPHASE_NEON 1
+# include <arm_neon.h>
+#endif
+
+#define QUALITY_TEXT N_("Resampling quality")
+#define QUALITY_LONGTEXT N_( \
+    "Resampling quality, from the shortest filter (lowest latency and CPU " \
+    "usage) to the longest one (best stop band attenuation)." )
+
+static int Open (vlc_object_t *);
+static int OpenResampler (vlc_object_t *);
+static void Close (vlc_object_t *);
+
+vlc_module_begin ()
+    set_shortname (N_("Polyphase"))
+    set_description (N_("Polyphase windowed-sinc resampler"))
+    set_category (CAT_AUDIO)
+    set_subcategory (SUBCAT_AUDIO_RESAMPLER)
+    add_integer ("polyphase-quality", 2, QUALITY_TEXT, QUALITY_LONGTEXT, true)
+        change_integer_range (0, 4)
+    set_capability ("audio converter", 0)
+    set_callbacks (Open, Close)
+
+    add_submodule ()
+    set_capability ("audio resampler", 0)
+    set_callbacks (OpenResampler, Close)
+    add_shortcut ("polyphase")
+vlc_module_end ()
+
+static const struct
+{
+    unsigned taps; /**< Filter length (multiple of 8) */
+    unsigned phase_bits; /**< Log2 of the filter bank size */
+    float beta; /**< Kaiser window shape */
+    float cutoff; /**< Pass band edge, relative to the Nyquist frequency */
+} qualities[] = {
+    {  8,  6, 5.0f, .85f },
+    { 16,  7, 6.0f, .90f },
+    { 32,  8, 7.5f, .94f },
+    { 48,  9, 8.5f, .95f },
+    { 64, 10, 9.5f, .96f },
+};
+
+/*****************************************************************************
+ * Inner loops
+ *****************************************************************************/
+/** Dot product of n (multiple of 8) samples */
+typedef float (*dot_t)(const float *, const float *, unsigned);
+/** Interpolates n (multiple of 8) coefficients between two phases */
+typedef void (*interp_t)(float *, const float *, const float *, float,
+                         unsigned);
+
+static float Dot(const float *x, const float *h, unsigned n)
+{
+    float a0 = 0.f, a1 = 0.f, a2 = 0.f, a3 = 0.f;
+
+    for (unsigned i = 0; i < n; i += 4)
+    {
+        a0 += x[i] * h[i];
+        a1 += x[i + 1] * h[i + 1];
+        a2 += x[i + 2] * h[i + 2];
+        a3 += x[i + 3] * h[i + 3];
+    }
+    return (a0 + a1) + (a2 + a3);
+}
+
+static void Interp(float *h, const float *a, const float *b, float w,
+                   unsigned n)
+{
+    for (unsigned i = 0; i < n; i++)
+        h[i] = a[i] + w * (b[i] - a[i]);
+}
+
+#if defined(CAN_COMPILE_SSE)
+__attribute__ ((__target__ ("sse")))
+static float Dot_SSE(const float *x, const float *h, unsigned n)
+{
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+
+    for (unsigned i = 0; i < n; i += 8)
+    {
+        a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(x + i),
+                                       _mm_load_ps(h + i)));
+        a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(x + i + 4),
+                                       _mm_load_ps(h + i + 4)));
+    }
+
+    __m128 s = _mm_add_ps(a0, a1);
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+__attribute__ ((__target__ ("sse")))
+static void Interp_SSE(float *h, const float *a, const float *b, float w,
+                       unsigned n)
+{
+    const __m128 vw = _mm_set1_ps(w);
+
+    for (unsigned i = 0; i < n; i += 4)
+    {
+        __m128 va = _mm_load_ps(a + i);
+        __m128 vb = _mm_load_ps(b + i);
+        _mm_store_ps(h + i, _mm_add_ps(va, _mm_mul_ps(vw, _mm_sub_ps(vb, va))));
+    }
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX2)
+__attribute__ ((__target__ ("avx2")))
+static float Dot_AVX2(const float *x, const float *h, unsigned n)
+{
+    __m256 a = _mm256_setzero_ps();
+
+    for (unsigned i = 0; i < n; i += 8)
+        a = _mm256_add_ps(a, _mm256_mul_ps(_mm256_loadu_ps(x + i),
+                                           _mm256_load_ps(h + i)));
+
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(a),
+                          _mm256_extractf128_ps(a, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void Interp_AVX2(float *h, const float *a, const float *b, float w,
+                        unsigned n)
+{
+    const __m256 vw = _mm256_set1_ps(w);
+
+    for (unsigned i = 0; i < n; i += 8)
+    {
+        __m256 va = _mm256_load_ps(a + i);
+        __m256 vb = _mm256_load_ps(b + i);
+        _mm256_store_ps(h + i,
+                        _mm256_add_ps(va, _mm256_mul_ps(vw, _mm256_sub_ps(vb, va))));
+    }
+}
+#endif
+
+#if defined(POLYPHASE_NEON)
+static float Dot_NEON(const float *x, const float *h, unsigned n)
+{
+    float32x4_t a0 = vdupq_n_f32(0.f), a1 = vdupq_n_f32(0.f);
+
+    for (unsigned i = 0; i < n; i += 8)
+    {
+        a0 = vmlaq_f32(a0, vld1q_f32(x + i), vld1q_f32(h + i));
+        a1 = vmlaq_f32(a1, vld1q_f32(x + i + 4), vld1q_f32(h + i + 4));
+    }
+
+    float32x4_t s = vaddq_f32(a0, a1);
+    float32x2_t d = vadd_f32(vget_low_f32(s), vget_high_f32(s));
+    return vget_lane_f32(vpadd_f32(d, d), 0);
+}
+
+static void Interp_NEON(float *h, const float *a, const float *b, float w,
+                        unsigned n)
+{
+    for (unsigned i = 0; i < n; i += 4)
+    {
+        float32x4_t va = vld1q_f32(a + i);
+        float32x4_t vb = vld1q_f32(b + i);
+        vst1q_f32(h + i, vmlaq_n_f32(va, vsubq_f32(vb, va), w));
+    }
+}
+#endif
+
+/*****************************************************************************
+ * Filter bank
+ *****************************************************************************/
+struct filter_sys_t
+{
+    dot_t dot;
+    interp_t interp;
+
+    unsigned channels;
+    unsigned taps;
+    unsigned phase_bits;
+    float beta;
+    float cutoff;
+    float ratio; /**< Bandwidth reduction the bank was designed for */
+    float *bank; /**< (phases + 1) filters of taps coefficients */
+    float *coefs; /**< Filter of the current output sample */
+
+    float *hist; /**< Planar input, hist_size frames per channel */
+    size_t hist_size;
+    size_t hist_len; /**< Buffered input frames */
+    uint64_t pos; /**< Position of the next output in hist (32.32) */
+};
+
+/** Zero-order modified Bessel function of the first kind */
+static double BesselI0(double x)
+{
+    double sum = 1., term = 1.;
+
+    for (unsigned k = 1; term > sum * 1e-12; k++)
+    {
+        term *= (x * x) / (4. * k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+static void BuildBank(filter_sys_t *sys, float ratio)
+{
+    const unsigned phases = 1 << sys->phase_bits;
+    const unsigned taps = sys->taps;
+    const double fc = sys->cutoff * ratio;
+    const double i0beta = BesselI0(sys->beta);
+
+    for (unsigned k = 0; k <= phases; k++)
+    {
+        float *h = sys->bank + k * taps;
+        double sum = 0.;
+
+        for (unsigned j = 0; j < taps; j++)
+        {
+            /* Distance from the output sample, in input samples */
+            double d = (double)j - (taps / 2 - 1) - (double)k / phases;
+            double x = d / (taps / 2);
+            double v = fc;
+
+            if (d != 0.)
+                v = sin(M_PI * fc * d) / (M_PI * d);
+            if (x * x < 1.)
+                v *= BesselI0(sys->beta * sqrt(1. - x * x)) / i0beta;
+            else
+                v /= i0beta;
+            h[j] = v;
+            sum += v;
+        }
+        /* Unity gain at DC for every phase */
+        for (unsigned j = 0; j < taps; j++)
+            h[j] /= sum;
+    }
+    sys->ratio = ratio;
+}
+
+static void Reset(filter_sys_t *sys)
+{
+    /* Leading silence, so that the first output is centered on the first
+     * input sample. */
+    sys->hist_len = sys->taps / 2 - 1;
+    for (unsigned c = 0; c < sys->channels; c++)
+        memset(sys->hist + c * sys->hist_size, 0,
+               sys->hist_len * sizeof (float));
+    sys->pos = 0;
+}
+
+/** Appends interleaved input to the planar history */
+static int Append(filter_sys_t *sys, const float *in, size_t frames)
+{
+    const unsigned channels = sys->channels;
+
+    if (sys->hist_len + frames > sys->hist_size)
+    {
+        size_t size = (sys->hist_len + frames) * 2;
+        float *hist = vlc_alloc(size * channels, sizeof (float));
+        if (unlikely(hist == NULL))
+            return VLC_ENOMEM;
+
+        for (unsigned c = 0; c < channels; c++)
+            memcpy(hist + c * size, sys->hist + c * sys->hist_size,
+                   sys->hist_len * sizeof (float));
+        free(sys->hist);
+        sys->hist = hist;
+        sys->hist_size = size;
+    }
+
+    for (unsigned c = 0; c < channels; c++)
+    {
+        float *dst = sys->hist + c * sys->hist_size + sys->hist_len;
+
+        for (size_t i = 0; i < frames; i++)
+            dst[i] = in[i * channels + c];
+    }
+    sys->hist_len += frames;
+    return VLC_SUCCESS;
+}
+
+/** Computes all the outputs available from the buffered input */
+static block_t *Process(filter_t *filter, vlc_tick_t pts, size_t new_frames)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const unsigned irate = filter->fmt_in.audio.i_rate;
+    const unsigned orate = filter->fmt_out.audio.i_rate;
+    const unsigned channels = sys->channels;
+    const unsigned taps = sys->taps;
+
+    /* Down-sampling: the pass band shrinks with the output rate. The drift
+     * compensation moves the rates slightly; ignore tiny changes. The filter
+     * length is kept, only the coefficients are recomputed. */
+    float ratio = (orate < irate) ? (float)orate / irate : 1.f;
+    if (fabsf(ratio - sys->ratio) > sys->ratio * .01f)
+        BuildBank(sys, ratio);
+
+    if (sys->hist_len < taps)
+        return NULL;
+
+    const uint64_t step = ((uint64_t)irate << 32) / orate;
+    const uint64_t limit = (uint64_t)(sys->hist_len - taps + 1) << 32;
+    if (sys->pos >= limit)
+        return NULL;
+
+    const size_t count = (limit - sys->pos + step - 1) / step;
+    block_t *out = block_Alloc(count * filter->fmt_out.audio.i_bytes_per_frame);
+    if (unlikely(out == NULL))
+        return NULL;
+
+    if (pts != VLC_TS_INVALID)
+    {   /* Date of the first output, relative to the first new input */
+        double offset = (double)sys->pos / 4294967296.
+                      + (taps / 2 - 1) - (double)(sys->hist_len - new_frames);
+        pts += llround(offset * CLOCK_FREQ / irate);
+    }
+
+    const unsigned shift = 32 - sys->phase_bits;
+    float *dst = (float *)out->p_buffer;
+    uint64_t pos = sys->pos;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const size_t idx = pos >> 32;
+        const uint32_t frac = pos;
+        const float *h = sys->bank + (frac >> shift) * taps;
+
+        sys->interp(sys->coefs, h, h + taps,
+                    (float)(uint32_t)(frac << sys->phase_bits) * 0x1.p-32f,
+                    taps);
+        for (unsigned c = 0; c < channels; c++)
+            *(dst++) = sys->dot(sys->hist + c * sys->hist_size + idx,
+                                sys->coefs, taps);
+        pos += step;
+    }
+
+    /* Drop the input that is no longer needed */
+    const size_t consumed = pos >> 32;
+    assert(consumed <= sys->hist_len);
+    sys->hist_len -= consumed;
+    for (unsigned c = 0; c < channels; c++)
+    {
+        float *hist = sys->hist + c * sys->hist_size;
+        memmove(hist, hist + consumed, sys->hist_len * sizeof (float));
+    }
+    sys->pos = pos - ((uint64_t)consumed << 32);
+
+    out->i_nb_samples = count;
+    out->i_pts = out->i_dts = pts;
+    out->i_length = count * CLOCK_FREQ / orate;
+    return out;
+}
+
+static block_t *Resample(filter_t *filter, block_t *in)
+{
+    filter_sys_t *sys = filter->p_sys;
+    block_t *out = NULL;
+
+    if (in->i_flags & BLOCK_FLAG_DISCONTINUITY)
+        Reset(sys);
+
+    if (Append(sys, (const float *)in->p_buffer, in->i_nb_samples) == 0)
+        out = Process(filter, in->i_pts, in->i_nb_samples);
+    if (out != NULL)
+        out->i_flags = in->i_flags;
+    block_Release(in);
+    return out;
+}
+
+static block_t *Drain(filter_t *filter)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const size_t frames = sys->taps / 2;
+    float silence[frames * sys->channels];
+
+    memset(silence, 0, sizeof (silence));
+    if (Append(sys, silence, frames))
+        return NULL;
+
+    block_t *out = Process(filter, VLC_TS_INVALID, frames);
+    Reset(sys);
+    return out;
+}
+
+static void Flush(filter_t *filter)
+{
+    Reset(filter->p_sys);
+}
+
+/*****************************************************************************
+ * Open/Close
+ *****************************************************************************/
+static int OpenResampler(vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+
+    if (filter->fmt_in.audio.i_format != VLC_CODEC_FL32
+     || filter->fmt_out.audio.i_format != VLC_CODEC_FL32
+    /* Cannot remix */
+     || filter->fmt_in.audio.i_channels != filter->fmt_out.audio.i_channels
+     || filter->fmt_in.audio.i_physical_channels == 0
+     || filter->fmt_in.audio.i_rate == 0 || filter->fmt_out.audio.i_rate == 0)
+        return VLC_EGENERIC;
+
+    filter_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    unsigned q = var_InheritInteger(obj, "polyphase-quality");
+    if (q >= ARRAY_SIZE(qualities))
+        q = 2;
+
+    const unsigned irate = filter->fmt_in.audio.i_rate;
+    const unsigned orate = filter->fmt_out.audio.i_rate;
+    const float ratio = (orate < irate) ? (float)orate / irate : 1.f;
+
+    /* When down-sampling, the filter must span as many output samples as it
+     * would at the same rate, within reason. */
+    unsigned taps = ceilf(qualities[q].taps / ratio);
+    if (taps > qualities[q].taps * 8)
+        taps = qualities[q].taps * 8;
+
+    sys->channels = filter->fmt_in.audio.i_channels;
+    sys->taps = (taps + 7) & ~7;
+    sys->phase_bits = qualities[q].phase_bits;
+    sys->beta = qualities[q].beta;
+    sys->cutoff = qualities[q].cutoff;
+    sys->bank = aligned_alloc(32, (((1 << sys->phase_bits) + 1) * sys->taps)
+                                  * sizeof (float));
+    sys->coefs = aligned_alloc(32, sys->taps * sizeof (float));
+    sys->hist_size = 4096;
+    sys->hist = vlc_alloc(sys->hist_size * sys->channels, sizeof (float));
+    if (unlikely(sys->bank == NULL || sys->coefs == NULL || sys->hist == NULL))
+    {
+        aligned_free(sys->bank);
+        aligned_free(sys->coefs);
+        free(sys->hist);
+        free(sys);
+        return VLC_ENOMEM;
+    }
+
+    sys->dot = Dot;
+    sys->interp = Interp;
+#if defined(CAN_COMPILE_AVX2)
+    if (vlc_CPU_AVX2())
+    {
+        sys->dot = Dot_AVX2;
+        sys->interp = Interp_AVX2;
+    }
+    else
+#endif
+#if defined(CAN_COMPILE_SSE)
+    if (vlc_CPU_SSE())
+    {
+        sys->dot = Dot_SSE;
+        sys->interp = Interp_SSE;
+    }
+#endif
+#if defined(POLYPHASE_NEON)
+    sys->dot = Dot_NEON;
+    sys->interp = Interp_NEON;
+#endif
+
+    BuildBank(sys, ratio);
+    Reset(sys);
+
+    msg_Dbg(obj, "%u taps, %u phases, %u to %u Hz", sys->taps,
+            1u << sys->phase_bits, irate, orate);
+
+    filter->p_sys = sys;
+    filter->pf_audio_filter = Resample;
+    filter->pf_audio_drain = Drain;
+    filter->pf_flush = Flush;
+    return VLC_SUCCESS;
+}
+
+static int Open(vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+
+    /* Will change rate */
+    if (filter->fmt_in.audio.i_rate == filter->fmt_out.audio.i_rate)
+        return VLC_EGENERIC;
+    return OpenResampler(obj);
+}
+
+static void Close(vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+    filter_sys_t *sys = filter->p_sys;
+
+    free(sys->hist);
+    aligned_free(sys->coefs);
+    aligned_free(sys->bank);
+    free(sys);
+}
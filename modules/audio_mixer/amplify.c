@@ -0,0 +1,280 @@
+/*****************************************************************************
+ * amplify.c : audio volume kernels
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdint.h>
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include "amplify.h"
+
+#if defined(CAN_COMPILE_SSE2) || defined(CAN_COMPILE_AVX2)
+# include <immintrin.h>
+#endif
+
+/*****************************************************************************
+ * Plain C
+ *****************************************************************************/
+static void AmplifyFL32(float *p, size_t n, float mult)
+{
+    for (; n > 0; n--)
+        *(p++) *= mult;
+}
+
+static void AmplifyFL64(double *p, size_t n, double mult)
+{
+    for (; n > 0; n--)
+        *(p++) *= mult;
+}
+
+static void AmplifyS16(int16_t *p, size_t n, int_fast32_t mult)
+{
+    for (; n > 0; n--)
+    {
+        int_fast32_t s = (*p * mult) >> 8;
+        if (s > INT16_MAX)
+            s = INT16_MAX;
+        else
+        if (s < INT16_MIN)
+            s = INT16_MIN;
+        *(p++) = s;
+    }
+}
+
+static void AmplifyS32(int32_t *p, size_t n, int_fast32_t mult)
+{
+    for (; n > 0; n--)
+    {
+        int_fast64_t s = (*p * (int_fast64_t)mult) >> INT64_C(24);
+        if (s > INT32_MAX)
+            s = INT32_MAX;
+        else
+        if (s < INT32_MIN)
+            s = INT32_MIN;
+        *(p++) = s;
+    }
+}
+
+static const amplify_ops_t ops_c = {
+    "C", AmplifyFL32, AmplifyFL64, AmplifyS16, AmplifyS32,
+};
+
+/*****************************************************************************
+ * SSE2 and SSE4.1
+ *****************************************************************************/
+#if defined(CAN_COMPILE_SSE2)
+__attribute__ ((__target__ ("sse2")))
+static void AmplifyFL32_SSE2(float *p, size_t n, float mult)
+{
+    const __m128 m = _mm_set1_ps(mult);
+
+    for (; n >= 8; n -= 8, p += 8)
+    {
+        __m128 a = _mm_loadu_ps(p);
+        __m128 b = _mm_loadu_ps(p + 4);
+        _mm_storeu_ps(p, _mm_mul_ps(a, m));
+        _mm_storeu_ps(p + 4, _mm_mul_ps(b, m));
+    }
+    AmplifyFL32(p, n, mult);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void AmplifyFL64_SSE2(double *p, size_t n, double mult)
+{
+    const __m128d m = _mm_set1_pd(mult);
+
+    for (; n >= 4; n -= 4, p += 4)
+    {
+        __m128d a = _mm_loadu_pd(p);
+        __m128d b = _mm_loadu_pd(p + 2);
+        _mm_storeu_pd(p, _mm_mul_pd(a, m));
+        _mm_storeu_pd(p + 2, _mm_mul_pd(b, m));
+    }
+    AmplifyFL64(p, n, mult);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void AmplifyS16_SSE2(int16_t *p, size_t n, int_fast32_t mult)
+{
+    if (mult > INT16_MAX || mult < INT16_MIN)
+    {
+        AmplifyS16(p, n, mult);
+        return;
+    }
+
+    const __m128i m = _mm_set1_epi16(mult);
+
+    for (; n >= 8; n -= 8, p += 8)
+    {
+        __m128i s = _mm_loadu_si128((__m128i *)p);
+        __m128i lo = _mm_mullo_epi16(s, m);
+        __m128i hi = _mm_mulhi_epi16(s, m);
+        /* 32-bits products, scaled down then packed with saturation */
+        __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 8);
+        __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 8);
+        _mm_storeu_si128((__m128i *)p, _mm_packs_epi32(a, b));
+    }
+    AmplifyS16(p, n, mult);
+}
+
+static const amplify_ops_t ops_sse2 = {
+    "SSE2", AmplifyFL32_SSE2, AmplifyFL64_SSE2, AmplifyS16_SSE2, AmplifyS32,
+};
+
+# if defined(CAN_COMPILE_SSE4_1)
+__attribute__ ((__target__ ("sse4.1")))
+static void AmplifyS32_SSE4_1(int32_t *p, size_t n, int_fast32_t mult)
+{
+    /* Without gain, the result cannot overflow, and only the bits 24 to 55
+     * of the 64-bits products are needed. */
+    if (mult < 0 || mult > (1 << 24))
+    {
+        AmplifyS32(p, n, mult);
+        return;
+    }
+
+    const __m128i m = _mm_set1_epi32(mult);
+
+    for (; n >= 4; n -= 4, p += 4)
+    {
+        __m128i s = _mm_loadu_si128((__m128i *)p);
+        __m128i even = _mm_mul_epi32(s, m);
+        __m128i odd = _mm_mul_epi32(_mm_srli_epi64(s, 32), m);
+        even = _mm_srli_epi64(even, 24);
+        odd = _mm_slli_epi64(odd, 8);
+        _mm_storeu_si128((__m128i *)p, _mm_blend_epi16(even, odd, 0xCC));
+    }
+    AmplifyS32(p, n, mult);
+}
+
+static const amplify_ops_t ops_sse4_1 = {
+    "SSE4.1", AmplifyFL32_SSE2, AmplifyFL64_SSE2, AmplifyS16_SSE2,
+    AmplifyS32_SSE4_1,
+};
+# endif
+#endif
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#if defined(CAN_COMPILE_AVX2)
+__attribute__ ((__target__ ("avx2")))
+static void AmplifyFL32_AVX2(float *p, size_t n, float mult)
+{
+    const __m256 m = _mm256_set1_ps(mult);
+
+    for (; n >= 16; n -= 16, p += 16)
+    {
+        __m256 a = _mm256_loadu_ps(p);
+        __m256 b = _mm256_loadu_ps(p + 8);
+        _mm256_storeu_ps(p, _mm256_mul_ps(a, m));
+        _mm256_storeu_ps(p + 8, _mm256_mul_ps(b, m));
+    }
+    AmplifyFL32(p, n, mult);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AmplifyFL64_AVX2(double *p, size_t n, double mult)
+{
+    const __m256d m = _mm256_set1_pd(mult);
+
+    for (; n >= 8; n -= 8, p += 8)
+    {
+        __m256d a = _mm256_loadu_pd(p);
+        __m256d b = _mm256_loadu_pd(p + 4);
+        _mm256_storeu_pd(p, _mm256_mul_pd(a, m));
+        _mm256_storeu_pd(p + 4, _mm256_mul_pd(b, m));
+    }
+    AmplifyFL64(p, n, mult);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AmplifyS16_AVX2(int16_t *p, size_t n, int_fast32_t mult)
+{
+    if (mult > INT16_MAX || mult < INT16_MIN)
+    {
+        AmplifyS16(p, n, mult);
+        return;
+    }
+
+    const __m256i m = _mm256_set1_epi16(mult);
+
+    /* Unpacking and packing both work per 128-bits lane: the order of the
+     * samples is preserved. */
+    for (; n >= 16; n -= 16, p += 16)
+    {
+        __m256i s = _mm256_loadu_si256((__m256i *)p);
+        __m256i lo = _mm256_mullo_epi16(s, m);
+        __m256i hi = _mm256_mulhi_epi16(s, m);
+        __m256i a = _mm256_srai_epi32(_mm256_unpacklo_epi16(lo, hi), 8);
+        __m256i b = _mm256_srai_epi32(_mm256_unpackhi_epi16(lo, hi), 8);
+        _mm256_storeu_si256((__m256i *)p, _mm256_packs_epi32(a, b));
+    }
+    AmplifyS16(p, n, mult);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AmplifyS32_AVX2(int32_t *p, size_t n, int_fast32_t mult)
+{
+    if (mult < 0 || mult > (1 << 24))
+    {
+        AmplifyS32(p, n, mult);
+        return;
+    }
+
+    const __m256i m = _mm256_set1_epi32(mult);
+
+    for (; n >= 8; n -= 8, p += 8)
+    {
+        __m256i s = _mm256_loadu_si256((__m256i *)p);
+        __m256i even = _mm256_mul_epi32(s, m);
+        __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(s, 32), m);
+        even = _mm256_srli_epi64(even, 24);
+        odd = _mm256_slli_epi64(odd, 8);
+        _mm256_storeu_si256((__m256i *)p, _mm256_blend_epi32(even, odd, 0xAA));
+    }
+    AmplifyS32(p, n, mult);
+}
+
+static const amplify_ops_t ops_avx2 = {
+    "AVX2", AmplifyFL32_AVX2, AmplifyFL64_AVX2, AmplifyS16_AVX2,
+    AmplifyS32_AVX2,
+};
+#endif
+
+const amplify_ops_t *amplify_GetOps(unsigned cpu)
+{
+#if defined(CAN_COMPILE_AVX2)
+    if (cpu & VLC_CPU_AVX2)
+        return &ops_avx2;
+#endif
+#if defined(CAN_COMPILE_SSE2)
+# if defined(CAN_COMPILE_SSE4_1)
+    if ((cpu & (VLC_CPU_SSE2|VLC_CPU_SSE4_1)) == (VLC_CPU_SSE2|VLC_CPU_SSE4_1))
+        return &ops_sse4_1;
+# endif
+    if (cpu & VLC_CPU_SSE2)
+        return &ops_sse2;
+#endif
+    (void) cpu;
+    return &ops_c;
+}
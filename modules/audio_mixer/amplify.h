@@ -0,0 +1,46 @@
+/*****************************************************************************
+ * amplify.h : audio volume kernels
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_MIXER_AMPLIFY_H
+#define VLC_AUDIO_MIXER_AMPLIFY_H 1
+
+/**
+ * Sample scaling kernels, in place.
+ *
+ * The integer kernels take a fixed point multiplier: 8 fractional bits for
+ * S16N and 24 for S32N. They saturate, and all variants of a kernel give
+ * exactly the same output.
+ */
+typedef struct
+{
+    const char *name;
+    void (*fl32)(float *, size_t, float);
+    void (*fl64)(double *, size_t, double);
+    void (*s16)(int16_t *, size_t, int_fast32_t);
+    void (*s32)(int32_t *, size_t, int_fast32_t);
+} amplify_ops_t;
+
+/**
+ * Returns the fastest kernels using only the given CPU capabilities
+ * (VLC_CPU_* flags, typically vlc_CPU()).
+ */
+const amplify_ops_t *amplify_GetOps(unsigned cpu);
+
+#endif
@@ -32,8 +32,10 @@
 #include <stddef.h>
 #include <vlc_common.h>
 #include <vlc_plugin.h>
+#include <vlc_cpu.h>
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
+#include "amplify.h"
 
 /*****************************************************************************
  * Local prototypes
@@ -61,8 +63,8 @@ static void FilterFL32( audio_volume_t *p_volume, block_t *p_buffer,
         return; /* nothing to do */
 
     float *p = (float *)p_buffer->p_buffer;
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
-        *(p++) *= f_multiplier;
+    amplify_GetOps( vlc_CPU() )->fl32( p, p_buffer->i_buffer / sizeof(*p),
+                                       f_multiplier );
 
     (void) p_volume;
 }
@@ -75,8 +77,8 @@ static void FilterFL64( audio_volume_t *p_volume, block_t *p_buffer,
     if( mult == 1. )
         return; /* nothing to do */
 
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
-        *(p++) *= mult;
+    amplify_GetOps( vlc_CPU() )->fl64( p, p_buffer->i_buffer / sizeof(*p),
+                                       mult );
 
     (void) p_volume;
 }
@@ -27,8 +27,10 @@
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
+#include <vlc_cpu.h>
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
+#include "amplify.h"
 
 static int Activate (vlc_object_t *);
 
@@ -48,16 +50,7 @@ static void FilterS32N (audio_volume_t *vol, block_t *block, float volume)
     if (mult == (1 << 24))
         return;
 
-    for (size_t n = block->i_buffer / sizeof (*p); n > 0; n--)
-    {
-        int_fast64_t s = (*p * (int_fast64_t)mult) >> INT64_C(24);
-        if (s > INT32_MAX)
-            s = INT32_MAX;
-        else
-        if (s < INT32_MIN)
-            s = INT32_MIN;
-        *(p++) = s;
-    }
+    amplify_GetOps (vlc_CPU ())->s32 (p, block->i_buffer / sizeof (*p), mult);
     (void) vol;
 }
 
@@ -69,16 +62,7 @@ static void FilterS16N (audio_volume_t *vol, block_t *block, float volume)
     if (mult == (1 << 8))
         return;
 
-    for (size_t n = block->i_buffer / sizeof (*p); n > 0; n--)
-    {
-        int_fast32_t s = (*p * (int_fast32_t)mult) >> 8;
-        if (s > INT16_MAX)
-            s = INT16_MAX;
-        else
-        if (s < INT16_MIN)
-            s = INT16_MIN;
-        *(p++) = s;
-    }
+    amplify_GetOps (vlc_CPU ())->s16 (p, block->i_buffer / sizeof (*p), mult);
     (void) vol;
 }
 
@@ -47,6 +47,10 @@
                                                             \
 /**@}*/                                                     \
 
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of frames decoded in parallel " \
+    "(0 = auto, 1 = disabled).")
+
 #define ENC_CFG_PREFIX "sout-jpeg-"
 #define ENC_QUALITY_TEXT N_("Quality level")
 #define ENC_QUALITY_LONGTEXT N_("Quality level " \
@@ -64,19 +68,31 @@ struct jpeg_sys_t
 typedef struct jpeg_sys_t jpeg_sys_t;
 
 /*
- * jpeg decoder descriptor
+ * jpeg decompression context, one per decoding thread
  */
-struct decoder_sys_t
+typedef struct
 {
     JPEG_SYS_COMMON_MEMBERS
 
     struct jpeg_decompress_struct p_jpeg;
+} jpeg_dec_t;
+
+/*
+ * jpeg decoder descriptor
+ */
+struct decoder_sys_t
+{
+    jpeg_dec_t dec; /* when not threaded */
+
+    decoder_frame_threads_t *p_threads;
+    video_format_t fmt; /* output format common to all frames */
 };
 
 static int  OpenDecoder(vlc_object_t *);
 static void CloseDecoder(vlc_object_t *);
 
 static int DecodeBlock(decoder_t *, block_t *);
+static void Flush(decoder_t *);
 
 /*
  * jpeg encoder descriptor
@@ -112,6 +128,8 @@ vlc_module_begin()
     set_capability("video decoder", 1000)
     set_callbacks(OpenDecoder, CloseDecoder)
     add_shortcut("jpeg")
+    add_integer("jpeg-threads", 1, THREADS_TEXT, THREADS_LONGTEXT, true)
+        change_integer_range(0, 32)
 
     /* encoder submodule */
     add_submodule()
@@ -147,6 +165,36 @@ static void user_error_message(j_common_ptr p_jpeg)
     msg_Err(p_sys->p_obj, "%s", error_msg);
 }
 
+static void InitDecompress(jpeg_dec_t *p_ctx, vlc_object_t *p_obj)
+{
+    p_ctx->p_obj = p_obj;
+
+    p_ctx->p_jpeg.err = jpeg_std_error(&p_ctx->err);
+    p_ctx->err.error_exit = user_error_exit;
+    p_ctx->err.output_message = user_error_message;
+}
+
+static picture_t *DecodeFrame(decoder_t *, jpeg_dec_t *, block_t *);
+
+static void *OpenThread(decoder_t *p_dec)
+{
+    jpeg_dec_t *p_ctx = malloc(sizeof(*p_ctx));
+    if (p_ctx != NULL)
+        InitDecompress(p_ctx, VLC_OBJECT(p_dec));
+    return p_ctx;
+}
+
+static void CloseThread(decoder_t *p_dec, void *p_ctx)
+{
+    VLC_UNUSED(p_dec);
+    free(p_ctx);
+}
+
+static picture_t *DecodeThread(decoder_t *p_dec, void *p_ctx, block_t *p_block)
+{
+    return DecodeFrame(p_dec, p_ctx, p_block);
+}
+
 /*
  * Probe the decoder and return score
  */
@@ -168,14 +216,11 @@ static int OpenDecoder(vlc_object_t *p_this)
 
     p_dec->p_sys = p_sys;
 
-    p_sys->p_obj = p_this;
-
-    p_sys->p_jpeg.err = jpeg_std_error(&p_sys->err);
-    p_sys->err.error_exit = user_error_exit;
-    p_sys->err.output_message = user_error_message;
+    InitDecompress(&p_sys->dec, p_this);
 
     /* Set callbacks */
     p_dec->pf_decode = DecodeBlock;
+    p_dec->pf_flush  = Flush;
 
     p_dec->fmt_out.i_codec = VLC_CODEC_RGB24;
     p_dec->fmt_out.video.transfer  = TRANSFER_FUNC_SRGB;
@@ -183,6 +228,25 @@ static int OpenDecoder(vlc_object_t *p_this)
     p_dec->fmt_out.video.primaries = COLOR_PRIMARIES_SRGB;
     p_dec->fmt_out.video.b_color_range_full = true;
 
+    video_format_Init(&p_sys->fmt, VLC_CODEC_RGB24);
+    p_sys->fmt.transfer  = TRANSFER_FUNC_SRGB;
+    p_sys->fmt.space     = COLOR_SPACE_SRGB;
+    p_sys->fmt.primaries = COLOR_PRIMARIES_SRGB;
+    p_sys->fmt.b_color_range_full = true;
+
+    /* Every frame is independent: decode several of them at once */
+    p_sys->p_threads = NULL;
+    int i_threads = var_InheritInteger(p_dec, "jpeg-threads");
+    if (i_threads != 1)
+    {
+        static const decoder_frame_threads_cbs_t cbs = {
+            .pf_open = OpenThread,
+            .pf_close = CloseThread,
+            .pf_decode = DecodeThread,
+        };
+        p_sys->p_threads = decoder_FrameThreadsNew(p_dec, &cbs, i_threads);
+    }
+
     return VLC_SUCCESS;
 }
 
@@ -462,23 +526,32 @@ static int jpeg_GetOrientation( j_decompress_ptr cinfo )
 }
 
 /*
- * This function must be fed with a complete compressed frame.
+ * Allocate the output picture, through the frame threads if any
  */
-static int DecodeBlock(decoder_t *p_dec, block_t *p_block)
+static picture_t *NewPicture(decoder_t *p_dec, const video_format_t *p_fmt)
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
-    picture_t *p_pic = 0;
 
-    JSAMPARRAY p_row_pointers = NULL;
+    if (p_sys->p_threads != NULL)
+        return decoder_FrameThreadsNewPicture(p_sys->p_threads, p_fmt);
 
-    if (!p_block) /* No Drain */
-        return VLCDEC_SUCCESS;
+    video_format_Clean(&p_dec->fmt_out.video);
+    if (video_format_Copy(&p_dec->fmt_out.video, p_fmt))
+        return NULL;
+    if (decoder_UpdateVideoFormat(p_dec))
+        return NULL;
+    return decoder_NewPicture(p_dec);
+}
 
-    if (p_block->i_flags & BLOCK_FLAG_CORRUPTED )
-    {
-        block_Release(p_block);
-        return VLCDEC_SUCCESS;
-    }
+/*
+ * This function must be fed with a complete compressed frame.
+ */
+static picture_t *DecodeFrame(decoder_t *p_dec, jpeg_dec_t *p_sys, block_t *p_block)
+{
+    picture_t *volatile p_pic = NULL;
+    video_format_t fmt = ((decoder_sys_t *)p_dec->p_sys)->fmt;
+
+    JSAMPARRAY p_row_pointers = NULL;
 
     /* libjpeg longjmp's there in case of error */
     if (setjmp(p_sys->setjmp_buffer))
@@ -496,26 +569,22 @@ static int DecodeBlock(decoder_t *p_dec, block_t *p_block)
     jpeg_start_decompress(&p_sys->p_jpeg);
 
     /* Set output properties */
-    p_dec->fmt_out.video.i_visible_width  = p_dec->fmt_out.video.i_width  = p_sys->p_jpeg.output_width;
-    p_dec->fmt_out.video.i_visible_height = p_dec->fmt_out.video.i_height = p_sys->p_jpeg.output_height;
-    p_dec->fmt_out.video.i_sar_num = 1;
-    p_dec->fmt_out.video.i_sar_den = 1;
+    fmt.i_visible_width  = fmt.i_width  = p_sys->p_jpeg.output_width;
+    fmt.i_visible_height = fmt.i_height = p_sys->p_jpeg.output_height;
+    fmt.i_sar_num = 1;
+    fmt.i_sar_den = 1;
 
     int i_otag; /* Orientation tag has valid range of 1-8. 1 is normal orientation, 0 = unspecified = normal */
     i_otag = jpeg_GetOrientation( &p_sys->p_jpeg );
     if ( i_otag > 1 )
     {
         msg_Dbg( p_dec, "Jpeg orientation is %d", i_otag );
-        p_dec->fmt_out.video.orientation = ORIENT_FROM_EXIF( i_otag );
+        fmt.orientation = ORIENT_FROM_EXIF( i_otag );
     }
-    jpeg_FillProjection(&p_sys->p_jpeg, &p_dec->fmt_out.video);
+    jpeg_FillProjection(&p_sys->p_jpeg, &fmt);
 
     /* Get a new picture */
-    if (decoder_UpdateVideoFormat(p_dec))
-    {
-        goto error;
-    }
-    p_pic = decoder_NewPicture(p_dec);
+    p_pic = NewPicture(p_dec, &fmt);
     if (!p_pic)
     {
         goto error;
@@ -545,18 +614,56 @@ static int DecodeBlock(decoder_t *p_dec, block_t *p_block)
     p_pic->date = p_block->i_pts > VLC_TICK_INVALID ? p_block->i_pts : p_block->i_dts;
 
     block_Release(p_block);
-    decoder_QueueVideo( p_dec, p_pic );
-    return VLCDEC_SUCCESS;
+    return p_pic;
 
 error:
 
     jpeg_destroy_decompress(&p_sys->p_jpeg);
     free(p_row_pointers);
+    if (p_pic != NULL)
+        picture_Release(p_pic);
 
     block_Release(p_block);
+    return NULL;
+}
+
+static int DecodeBlock(decoder_t *p_dec, block_t *p_block)
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    if (p_sys->p_threads != NULL)
+    {
+        if (p_block != NULL && (p_block->i_flags & BLOCK_FLAG_CORRUPTED))
+        {
+            block_Release(p_block);
+            return VLCDEC_SUCCESS;
+        }
+        return decoder_FrameThreadsDecode(p_sys->p_threads, p_block);
+    }
+
+    if (!p_block) /* No Drain */
+        return VLCDEC_SUCCESS;
+
+    if (p_block->i_flags & BLOCK_FLAG_CORRUPTED )
+    {
+        block_Release(p_block);
+        return VLCDEC_SUCCESS;
+    }
+
+    picture_t *p_pic = DecodeFrame(p_dec, &p_sys->dec, p_block);
+    if (p_pic != NULL)
+        decoder_QueueVideo(p_dec, p_pic);
     return VLCDEC_SUCCESS;
 }
 
+static void Flush(decoder_t *p_dec)
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    if (p_sys->p_threads != NULL)
+        decoder_FrameThreadsFlush(p_sys->p_threads);
+}
+
 /*
  * jpeg decoder destruction
  */
@@ -565,6 +672,8 @@ static void CloseDecoder(vlc_object_t *p_this)
     decoder_t *p_dec = (decoder_t *)p_this;
     decoder_sys_t *p_sys = p_dec->p_sys;
 
+    if (p_sys->p_threads != NULL)
+        decoder_FrameThreadsDelete(p_sys->p_threads);
     free(p_sys);
 }
 
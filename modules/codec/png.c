@@ -57,7 +57,8 @@ typedef struct png_sys_t png_sys_t;
  *****************************************************************************/
 struct decoder_sys_t
 {
-    PNG_SYS_COMMON_MEMBERS
+    decoder_frame_threads_t *p_threads;
+    video_format_t fmt; /* output format common to all frames */
 };
 
 /*****************************************************************************
@@ -67,6 +68,8 @@ static int  OpenDecoder   ( vlc_object_t * );
 static void CloseDecoder  ( vlc_object_t * );
 
 static int DecodeBlock  ( decoder_t *, block_t * );
+static void Flush       ( decoder_t * );
+static picture_t *DecodeThread( decoder_t *, void *, block_t * );
 
 /*
  * png encoder descriptor
@@ -82,6 +85,10 @@ static void CloseEncoder(vlc_object_t *);
 
 static block_t *EncodeBlock(encoder_t *, picture_t *);
 
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of frames decoded in parallel " \
+    "(0 = auto, 1 = disabled).")
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -92,6 +99,8 @@ vlc_module_begin ()
     set_capability( "video decoder", 1000 )
     set_callbacks( OpenDecoder, CloseDecoder )
     add_shortcut( "png" )
+    add_integer( "png-threads", 1, THREADS_TEXT, THREADS_LONGTEXT, true )
+        change_integer_range( 0, 32 )
 
     /* encoder submodule */
     add_submodule()
@@ -116,11 +125,10 @@ static int OpenDecoder( vlc_object_t *p_this )
     }
 
     /* Allocate the memory needed to store the decoder's structure */
-    p_dec->p_sys = malloc( sizeof(decoder_sys_t) );
-    if( p_dec->p_sys == NULL )
+    decoder_sys_t *p_sys = malloc( sizeof(decoder_sys_t) );
+    if( p_sys == NULL )
         return VLC_ENOMEM;
-
-    p_dec->p_sys->p_obj = p_this;
+    p_dec->p_sys = p_sys;
 
     /* Set output properties */
     p_dec->fmt_out.i_codec = VLC_CODEC_RGBA;
@@ -129,8 +137,26 @@ static int OpenDecoder( vlc_object_t *p_this )
     p_dec->fmt_out.video.primaries = COLOR_PRIMARIES_SRGB;
     p_dec->fmt_out.video.b_color_range_full = true;
 
+    video_format_Init( &p_sys->fmt, VLC_CODEC_RGBA );
+    p_sys->fmt.transfer  = TRANSFER_FUNC_SRGB;
+    p_sys->fmt.space     = COLOR_SPACE_SRGB;
+    p_sys->fmt.primaries = COLOR_PRIMARIES_SRGB;
+    p_sys->fmt.b_color_range_full = true;
+
     /* Set callbacks */
     p_dec->pf_decode = DecodeBlock;
+    p_dec->pf_flush  = Flush;
+
+    /* Every frame is independent: decode several of them at once */
+    p_sys->p_threads = NULL;
+    int i_threads = var_InheritInteger( p_dec, "png-threads" );
+    if( i_threads != 1 )
+    {
+        static const decoder_frame_threads_cbs_t cbs = {
+            .pf_decode = DecodeThread,
+        };
+        p_sys->p_threads = decoder_FrameThreadsNew( p_dec, &cbs, i_threads );
+    }
 
     return VLC_SUCCESS;
 }
@@ -184,15 +210,38 @@ static void user_warning( png_structp p_png, png_const_charp warning_msg )
     msg_Warn( p_sys->p_obj, "%s", warning_msg );
 }
 
+/*****************************************************************************
+ * NewPicture: allocate the output picture, through the frame threads if any
+ *****************************************************************************/
+static picture_t *NewPicture( decoder_t *p_dec, const video_format_t *p_fmt )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    if( p_sys->p_threads != NULL )
+        return decoder_FrameThreadsNewPicture( p_sys->p_threads, p_fmt );
+
+    video_format_Clean( &p_dec->fmt_out.video );
+    if( video_format_Copy( &p_dec->fmt_out.video, p_fmt ) )
+        return NULL;
+    p_dec->fmt_out.i_codec = p_fmt->i_chroma;
+    if( decoder_UpdateVideoFormat( p_dec ) )
+        return NULL;
+    return decoder_NewPicture( p_dec );
+}
+
 /****************************************************************************
- * DecodeBlock: the whole thing
+ * DecodeFrame: the whole thing
  ****************************************************************************
  * This function must be fed with a complete compressed frame.
  ****************************************************************************/
-static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
+static picture_t *DecodeFrame( decoder_t *p_dec, block_t *p_block )
 {
-    decoder_sys_t *p_sys = p_dec->p_sys;
-    picture_t *p_pic = 0;
+    picture_t *volatile p_pic = NULL;
+    video_format_t fmt = p_dec->p_sys->fmt;
+
+    /* Error state of this frame only, frames may be decoded in parallel */
+    png_sys_t sys = { .b_error = false, .p_obj = VLC_OBJECT(p_dec) };
+    png_sys_t *p_sys = &sys;
 
     png_uint_32 i_width, i_height;
     int i_color_type, i_interlace_type, i_compression_type, i_filter_type;
@@ -202,22 +251,11 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     png_infop p_info, p_end_info;
     png_bytep *volatile p_row_pointers = NULL;
 
-    if( !p_block ) /* No Drain */
-        return VLCDEC_SUCCESS;
-
-    p_sys->b_error = false;
-
-    if( p_block->i_flags & BLOCK_FLAG_CORRUPTED )
-    {
-        block_Release( p_block );
-        return VLCDEC_SUCCESS;
-    }
-
     p_png = png_create_read_struct( PNG_LIBPNG_VER_STRING, 0, 0, 0 );
     if( p_png == NULL )
     {
         block_Release( p_block );
-        return VLCDEC_SUCCESS;
+        return NULL;
     }
 
     p_info = png_create_info_struct( p_png );
@@ -225,7 +263,7 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     {
         png_destroy_read_struct( &p_png, NULL, NULL );
         block_Release( p_block );
-        return VLCDEC_SUCCESS;
+        return NULL;
     }
 
     p_end_info = png_create_info_struct( p_png );
@@ -233,7 +271,7 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     {
         png_destroy_read_struct( &p_png, &p_info, NULL );
         block_Release( p_block );
-        return VLCDEC_SUCCESS;
+        return NULL;
     }
 
     /* libpng longjmp's there in case of error */
@@ -241,7 +279,7 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
         goto error;
 
     png_set_read_fn( p_png, (void *)p_block, user_read );
-    png_set_error_fn( p_png, (void *)p_dec, user_error, user_warning );
+    png_set_error_fn( p_png, (void *)p_sys, user_error, user_warning );
 
     png_read_info( p_png, p_info );
     if( p_sys->b_error ) goto error;
@@ -252,11 +290,11 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     if( p_sys->b_error ) goto error;
 
     /* Set output properties */
-    p_dec->fmt_out.i_codec = VLC_CODEC_RGBA;
-    p_dec->fmt_out.video.i_visible_width = p_dec->fmt_out.video.i_width = i_width;
-    p_dec->fmt_out.video.i_visible_height = p_dec->fmt_out.video.i_height = i_height;
-    p_dec->fmt_out.video.i_sar_num = 1;
-    p_dec->fmt_out.video.i_sar_den = 1;
+    fmt.i_chroma = VLC_CODEC_RGBA;
+    fmt.i_visible_width = fmt.i_width = i_width;
+    fmt.i_visible_height = fmt.i_height = i_height;
+    fmt.i_sar_num = 1;
+    fmt.i_sar_den = 1;
 
     if( i_color_type == PNG_COLOR_TYPE_PALETTE )
         png_set_palette_to_rgb( p_png );
@@ -283,13 +321,11 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     }
     else if( !(i_color_type & PNG_COLOR_MASK_ALPHA) )
     {
-        p_dec->fmt_out.i_codec = VLC_CODEC_RGB24;
+        fmt.i_chroma = VLC_CODEC_RGB24;
     }
 
     /* Get a new picture */
-    if( decoder_UpdateVideoFormat( p_dec ) )
-        goto error;
-    p_pic = decoder_NewPicture( p_dec );
+    p_pic = NewPicture( p_dec, &fmt );
     if( !p_pic ) goto error;
 
     /* Decode picture */
@@ -310,17 +346,57 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     p_pic->date = p_block->i_pts > VLC_TICK_INVALID ? p_block->i_pts : p_block->i_dts;
 
     block_Release( p_block );
-    decoder_QueueVideo( p_dec, p_pic );
-    return VLCDEC_SUCCESS;
+    return p_pic;
 
  error:
 
     free( p_row_pointers );
     png_destroy_read_struct( &p_png, &p_info, &p_end_info );
+    if( p_pic != NULL )
+        picture_Release( p_pic );
     block_Release( p_block );
+    return NULL;
+}
+
+static picture_t *DecodeThread( decoder_t *p_dec, void *p_thread_sys, block_t *p_block )
+{
+    VLC_UNUSED( p_thread_sys );
+    return DecodeFrame( p_dec, p_block );
+}
+
+/****************************************************************************
+ * DecodeBlock: decode a complete compressed frame
+ ****************************************************************************/
+static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    if( p_block != NULL && (p_block->i_flags & BLOCK_FLAG_CORRUPTED) )
+    {
+        block_Release( p_block );
+        return VLCDEC_SUCCESS;
+    }
+
+    if( p_sys->p_threads != NULL )
+        return decoder_FrameThreadsDecode( p_sys->p_threads, p_block );
+
+    if( !p_block ) /* No Drain */
+        return VLCDEC_SUCCESS;
+
+    picture_t *p_pic = DecodeFrame( p_dec, p_block );
+    if( p_pic != NULL )
+        decoder_QueueVideo( p_dec, p_pic );
     return VLCDEC_SUCCESS;
 }
 
+static void Flush( decoder_t *p_dec )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    if( p_sys->p_threads != NULL )
+        decoder_FrameThreadsFlush( p_sys->p_threads );
+}
+
 /*****************************************************************************
  * CloseDecoder: png decoder destruction
  *****************************************************************************/
@@ -329,6 +405,8 @@ static void CloseDecoder( vlc_object_t *p_this )
     decoder_t *p_dec = (decoder_t *)p_this;
     decoder_sys_t *p_sys = p_dec->p_sys;
 
+    if( p_sys->p_threads != NULL )
+        decoder_FrameThreadsDelete( p_sys->p_threads );
     free( p_sys );
 }
 
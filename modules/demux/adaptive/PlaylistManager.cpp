@@ -932,6 +932,9 @@ AbstractBufferingLogic *PlaylistManager::createBufferingLogic() const
         v = var_InheritInteger(p_demux, "adaptive-maxbuffer");
         if(v)
             bl->setUserMaxBuffering(CLOCK_FREQ / 1000 * v);
+        v = var_InheritInteger(p_demux, "adaptive-prefetch");
+        if(v)
+            bl->setPrefetch(v, (size_t)var_InheritInteger(p_demux, "adaptive-prefetch-maxsize") * 1024);
     }
     return bl;
 }
@@ -32,6 +32,7 @@
 #include "logic/AbstractAdaptationLogic.h"
 #include "logic/BufferingLogic.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <limits>
 
@@ -142,11 +143,18 @@ SegmentTracker::SegmentTracker(SharedResources *res,
     adaptationSet = adaptSet;
     synchronizationReferences = refs;
     format = StreamFormat::Type::Unknown;
+    prefetchStats.hits = 0;
+    prefetchStats.cancelled = 0;
 }
 
 SegmentTracker::~SegmentTracker()
 {
     reset();
+    vlc_object_t *obj = adaptationSet ? adaptationSet->getPlaylist()->getVLCObject() : nullptr;
+    if(obj && (prefetchStats.hits || prefetchStats.cancelled))
+        msg_Dbg(obj, "%s prefetched segments: %u used, %u cancelled",
+                adaptationSet->getID().str().c_str(),
+                prefetchStats.hits, prefetchStats.cancelled);
 }
 
 SegmentTracker::Position::Position()
@@ -233,6 +241,7 @@ void SegmentTracker::reset()
 SegmentTracker::ChunkEntry::ChunkEntry()
 {
     chunk = nullptr;
+    prefetched = false;
 }
 
 SegmentTracker::ChunkEntry::ChunkEntry(SegmentChunk *c, Position p, vlc_tick_t s, vlc_tick_t d, vlc_tick_t dt)
@@ -242,6 +251,7 @@ SegmentTracker::ChunkEntry::ChunkEntry(SegmentChunk *c, Position p, vlc_tick_t s
     duration = d;
     starttime = s;
     displaytime = dt;
+    prefetched = false;
 }
 
 bool SegmentTracker::ChunkEntry::isValid() const
@@ -250,7 +260,7 @@ bool SegmentTracker::ChunkEntry::isValid() const
 }
 
 SegmentTracker::ChunkEntry
-SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
+SegmentTracker::prepareChunk(bool switch_allowed, Position pos, bool prefetch) const
 {
     if(!adaptationSet)
         return ChunkEntry();
@@ -318,7 +328,7 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
     if(!segment)
         segment = datasegment;
 
-    SegmentChunk *segmentChunk = segment->toChunk(resources, pos.number, pos.rep);
+    SegmentChunk *segmentChunk = segment->toChunk(resources, pos.number, pos.rep, prefetch);
     if(!segmentChunk)
         return ChunkEntry();
 
@@ -339,6 +349,8 @@ void SegmentTracker::resetChunksSequence()
 {
     while(!chunkssequence.empty())
     {
+        if(chunkssequence.front().prefetched)
+            prefetchStats.cancelled++;
         delete chunkssequence.front().chunk;
         chunkssequence.pop_front();
     }
@@ -349,6 +361,17 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed)
     if(!adaptationSet || !next.isValid())
         return nullptr;
 
+    /* Prefetched chunks were prepared without switching,
+     * drop them if the logic now wants another representation */
+    if(!chunkssequence.empty() && chunkssequence.front().prefetched &&
+       switch_allowed && adaptationSet->isSegmentAligned() &&
+       next.init_sent && next.index_sent)
+    {
+        BaseRepresentation *rep = logic->getNextRepresentation(adaptationSet, next.rep);
+        if(rep && rep != chunkssequence.front().pos.rep)
+            resetChunksSequence();
+    }
+
     if(chunkssequence.empty())
     {
         ChunkEntry chunk = prepareChunk(switch_allowed, next);
@@ -415,6 +438,8 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed)
     /* pop position and return our chunk */
     chunkssequence.pop_front();
     chunk.chunk = nullptr;
+    if(chunk.prefetched)
+        prefetchStats.hits++;
 
     if(initializing)
     {
@@ -437,10 +462,69 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed)
 
     if(!b_gap)
         ++next;
+    else /* following prefetched positions no longer match */
+        resetChunksSequence();
+
+    prefetchChunks();
 
     return returnedChunk;
 }
 
+size_t SegmentTracker::getPrefetchedCount() const
+{
+    return std::count_if(chunkssequence.cbegin(), chunkssequence.cend(),
+                         [](const ChunkEntry &e) { return e.prefetched; });
+}
+
+const SegmentTracker::PrefetchStats & SegmentTracker::getPrefetchStats() const
+{
+    return prefetchStats;
+}
+
+size_t SegmentTracker::estimateChunkSize(const ChunkEntry &entry) const
+{
+    /* sizes are only known once downloaded, rely on the advertised bitrate */
+    return entry.pos.rep->getBandwidth() * entry.duration / CLOCK_FREQ / 8;
+}
+
+void SegmentTracker::prefetchChunks()
+{
+    const unsigned depth = bufferingLogic->getPrefetchDepth();
+    if(!depth || !next.isValid())
+        return;
+
+    size_t size = 0;
+    for(const ChunkEntry &entry : chunkssequence)
+        size += estimateChunkSize(entry);
+
+    /* Chunks are scheduled on the downloader as soon as they are created,
+     * with a lower priority than the ones being read */
+    while(chunkssequence.size() < depth &&
+          size < bufferingLogic->getPrefetchMaxSize())
+    {
+        Position pos = next;
+        if(!chunkssequence.empty())
+        {
+            pos = chunkssequence.back().pos;
+            ++pos;
+        }
+
+        ChunkEntry entry = prepareChunk(false, pos, true);
+        if(!entry.isValid())
+        {
+            delete entry.chunk;
+            break;
+        }
+        entry.prefetched = true;
+        size += estimateChunkSize(entry);
+        chunkssequence.push_back(entry);
+
+        /* gap: the position following it is decided on consumption */
+        if(entry.pos.number != pos.number)
+            break;
+    }
+}
+
 bool SegmentTracker::setPositionByTime(vlc_tick_t time, bool restarted, bool tryonly)
 {
     Position pos = Position(current.rep, current.number);
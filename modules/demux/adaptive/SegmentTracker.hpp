@@ -219,6 +219,13 @@ namespace adaptive
                     bool index_sent;
             };
 
+            class PrefetchStats
+            {
+                public:
+                    unsigned hits;      /* prefetched chunks that were read */
+                    unsigned cancelled; /* dropped on seek or switch */
+            };
+
             void getCodecsDesc(CodecDescriptionList *) const;
             const Role & getStreamRole() const;
             void reset();
@@ -237,6 +244,8 @@ namespace adaptive
             void registerListener(SegmentTrackerListenerInterface *);
             bool updateSelected();
             bool bufferingAvailable() const;
+            size_t getPrefetchedCount() const;
+            const PrefetchStats & getPrefetchStats() const;
 
         private:
             class ChunkEntry
@@ -250,10 +259,13 @@ namespace adaptive
                     vlc_tick_t displaytime;
                     vlc_tick_t starttime;
                     vlc_tick_t duration;
+                    bool prefetched;
             };
             std::list<ChunkEntry> chunkssequence;
-            ChunkEntry prepareChunk(bool switch_allowed, Position pos) const;
+            ChunkEntry prepareChunk(bool switch_allowed, Position pos, bool prefetch = false) const;
             void resetChunksSequence();
+            void prefetchChunks();
+            size_t estimateChunkSize(const ChunkEntry &) const;
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const TrackerEvent &) const;
             bool first;
@@ -267,6 +279,7 @@ namespace adaptive
             const AbstractBufferingLogic *bufferingLogic;
             BaseAdaptationSet *adaptationSet;
             std::list<SegmentTrackerListenerInterface *> listeners;
+            PrefetchStats prefetchStats;
     };
 }
 
@@ -77,6 +77,14 @@ static void Close   (vlc_object_t *);
 
 #define ADAPT_MAXBUFFER_TEXT N_("Max buffering (ms)")
 
+#define ADAPT_PREFETCH_TEXT N_("Prefetched segments")
+#define ADAPT_PREFETCH_LONGTEXT N_("Number of segments downloaded ahead of the " \
+                                   "one being demuxed (0 to disable)")
+
+#define ADAPT_PREFETCHSIZE_TEXT N_("Max prefetch size (KiB)")
+#define ADAPT_PREFETCHSIZE_LONGTEXT N_("Estimated size above which no more " \
+                                       "segments are prefetched, per stream")
+
 #define ADAPT_LOGIC_TEXT N_("Adaptive Logic")
 
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
@@ -143,6 +151,11 @@ vlc_module_begin ()
         add_integer( "adaptive-maxbuffer",
                      AbstractBufferingLogic::DEFAULT_MAX_BUFFERING  / 1000,
                      ADAPT_MAXBUFFER_TEXT, nullptr, true );
+        add_integer_with_range( "adaptive-prefetch", 0, 0, 8,
+                     ADAPT_PREFETCH_TEXT, ADAPT_PREFETCH_LONGTEXT, true );
+        add_integer( "adaptive-prefetch-maxsize",
+                     AbstractBufferingLogic::DEFAULT_PREFETCH_MAXSIZE / 1024,
+                     ADAPT_PREFETCHSIZE_TEXT, ADAPT_PREFETCHSIZE_LONGTEXT, true );
         add_integer( "adaptive-lowlatency", -1, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT, true );
             change_integer_list(rgi_latency, ppsz_latency)
         set_callbacks( Open, Close )
@@ -343,6 +343,7 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     done = false;
     eof = false;
     held = false;
+    lowpriority = false;
     p_read = nullptr;
     inblockreadoffset = 0;
 }
@@ -389,6 +390,16 @@ void HTTPChunkBufferedSource::release()
     vlc_cond_signal(&avail);
 }
 
+void HTTPChunkBufferedSource::prioritize()
+{
+    /* Prefetched and now read: stop waiting for the downloader to be idle */
+    if(lowpriority)
+    {
+        lowpriority = false;
+        connManager->start(this);
+    }
+}
+
 void HTTPChunkBufferedSource::bufferize(size_t readsize)
 {
     vlc_mutex_lock(&lock);
@@ -483,6 +494,8 @@ block_t * HTTPChunkBufferedSource::readBlock()
 {
     block_t *p_block = nullptr;
 
+    prioritize();
+
     vlc_mutex_locker locker(&lock);
 
     while(!p_read && !done)
@@ -509,6 +522,8 @@ block_t * HTTPChunkBufferedSource::readBlock()
 
 block_t * HTTPChunkBufferedSource::read(size_t readsize)
 {
+    prioritize();
+
     vlc_mutex_locker locker(&lock);
 
     while(readsize > (buffered - consumed) && !done)
@@ -173,6 +173,7 @@ namespace adaptive
                 bool               isDone() const;
                 void               hold();
                 void               release();
+                void               prioritize();
 
             private:
                 block_t            *p_head; /* read cache buffer */
@@ -184,6 +185,7 @@ namespace adaptive
                 bool                eof;
                 vlc_cond_t          avail;
                 bool                held;
+                bool                lowpriority; /* reader side only */
         };
 
         class HTTPChunk : public AbstractChunk
@@ -26,6 +26,8 @@
 #include <vlc_threads.h>
 #include <vlc_atomic.h>
 
+#include <algorithm>
+
 using namespace adaptive::http;
 
 Downloader::Downloader()
@@ -63,11 +65,28 @@ Downloader::~Downloader()
     vlc_mutex_destroy(&lock);
     vlc_cond_destroy(&waitcond);
 }
-void Downloader::schedule(HTTPChunkBufferedSource *source)
+void Downloader::schedule(HTTPChunkBufferedSource *source, bool lowpriority)
 {
     vlc_mutex_lock(&lock);
-    source->hold();
-    chunks.push_back(source);
+    auto it = std::find(lowchunks.begin(), lowchunks.end(), source);
+    if(it != lowchunks.end())
+    {
+        /* queued ahead of time, but needed now */
+        if(!lowpriority)
+        {
+            lowchunks.erase(it);
+            chunks.push_back(source);
+        }
+    }
+    else if(!source->isDone() &&
+            std::find(chunks.begin(), chunks.end(), source) == chunks.end())
+    {
+        source->hold();
+        if(lowpriority)
+            lowchunks.push_back(source);
+        else
+            chunks.push_back(source);
+    }
     vlc_cond_signal(&waitcond);
     vlc_mutex_unlock(&lock);
 }
@@ -84,6 +103,7 @@ void Downloader::cancel(HTTPChunkBufferedSource *source)
     if(!source->isDone())
     {
         chunks.remove(source);
+        lowchunks.remove(source);
         source->release();
     }
     vlc_mutex_unlock(&lock);
@@ -101,19 +121,23 @@ void Downloader::Run()
     vlc_mutex_lock(&lock);
     while(1)
     {
-        while(chunks.empty() && !killed)
+        while(chunks.empty() && lowchunks.empty() && !killed)
             vlc_cond_wait(&waitcond, &lock);
 
         if(killed)
             break;
 
-        current = chunks.front();
+        /* Sources are downloaded by CHUNK_SIZE steps: any pending regular
+         * source preempts the low priority ones between two steps */
+        current = chunks.empty() ? lowchunks.front() : chunks.front();
         vlc_mutex_unlock(&lock);
         current->bufferize(HTTPChunkSource::CHUNK_SIZE);
         vlc_mutex_lock(&lock);
         if(current->isDone() || cancel_current)
         {
-            chunks.pop_front();
+            /* could have been moved to the regular queue meanwhile */
+            chunks.remove(current);
+            lowchunks.remove(current);
             current->release();
         }
         cancel_current = false;
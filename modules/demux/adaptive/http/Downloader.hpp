@@ -37,7 +37,7 @@ namespace adaptive
                 Downloader();
                 ~Downloader();
                 bool start();
-                void schedule(HTTPChunkBufferedSource *);
+                void schedule(HTTPChunkBufferedSource *, bool = false);
                 void cancel(HTTPChunkBufferedSource *);
 
             private:
@@ -51,6 +51,7 @@ namespace adaptive
                 bool         killed;
                 bool         cancel_current;
                 std::list<HTTPChunkBufferedSource *> chunks;
+                std::list<HTTPChunkBufferedSource *> lowchunks; /* only when idle */
                 HTTPChunkBufferedSource *current;
         };
 
@@ -251,6 +251,16 @@ void HTTPConnectionManager::start(AbstractChunkSource *source)
         getDownloadQueue(src)->schedule(src);
 }
 
+void HTTPConnectionManager::prefetch(AbstractChunkSource *source)
+{
+    HTTPChunkBufferedSource *src = dynamic_cast<HTTPChunkBufferedSource *>(source);
+    if(src && !src->isDone())
+    {
+        src->lowpriority = true;
+        getDownloadQueue(src)->schedule(src, true);
+    }
+}
+
 void HTTPConnectionManager::cancel(AbstractChunkSource *source)
 {
     HTTPChunkBufferedSource *src = dynamic_cast<HTTPChunkBufferedSource *>(source);
@@ -59,6 +59,7 @@ namespace adaptive
                 virtual void recycleSource(AbstractChunkSource *) = 0;
 
                 virtual void start(AbstractChunkSource *) = 0;
+                virtual void prefetch(AbstractChunkSource *) = 0;
                 virtual void cancel(AbstractChunkSource *) = 0;
 
                 virtual void updateDownloadRate(const ID &, size_t,
@@ -87,6 +88,7 @@ namespace adaptive
                 virtual void recycleSource(AbstractChunkSource *) override;
 
                 virtual void start(AbstractChunkSource *)  override;
+                virtual void prefetch(AbstractChunkSource *)  override;
                 virtual void cancel(AbstractChunkSource *)  override;
                 void         setLocalConnectionsAllowed();
                 void         addFactory(AbstractConnectionFactory *);
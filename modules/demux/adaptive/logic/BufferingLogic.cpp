@@ -41,12 +41,15 @@ const vlc_tick_t AbstractBufferingLogic::BUFFERING_LOWEST_LIMIT = CLOCK_FREQ * 2
 const vlc_tick_t AbstractBufferingLogic::DEFAULT_MIN_BUFFERING = CLOCK_FREQ * 6;
 const vlc_tick_t AbstractBufferingLogic::DEFAULT_MAX_BUFFERING = CLOCK_FREQ * 30;
 const vlc_tick_t AbstractBufferingLogic::DEFAULT_LIVE_BUFFERING = CLOCK_FREQ * 15;
+const size_t AbstractBufferingLogic::DEFAULT_PREFETCH_MAXSIZE = 16 * 1024 * 1024;
 
 AbstractBufferingLogic::AbstractBufferingLogic()
 {
     userMinBuffering = 0;
     userMaxBuffering = 0;
     userLiveDelay = 0;
+    prefetchDepth = 0;
+    prefetchMaxSize = DEFAULT_PREFETCH_MAXSIZE;
 }
 
 void AbstractBufferingLogic::setLowDelay(bool b)
@@ -69,6 +72,22 @@ void AbstractBufferingLogic::setUserLiveDelay(vlc_tick_t v)
     userLiveDelay = v;
 }
 
+void AbstractBufferingLogic::setPrefetch(unsigned depth, size_t maxsize)
+{
+    prefetchDepth = depth;
+    prefetchMaxSize = maxsize;
+}
+
+unsigned AbstractBufferingLogic::getPrefetchDepth() const
+{
+    return prefetchDepth;
+}
+
+size_t AbstractBufferingLogic::getPrefetchMaxSize() const
+{
+    return prefetchMaxSize;
+}
+
 /* Try to never buffer up to really end */
 /* Enforce no overlap for demuxers segments 3.0.0 */
 /* FIXME: check duration instead ? */
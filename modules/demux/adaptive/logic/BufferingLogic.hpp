@@ -51,16 +51,22 @@ namespace adaptive
                 void setUserMaxBuffering(vlc_tick_t);
                 void setUserLiveDelay(vlc_tick_t);
                 void setLowDelay(bool);
+                void setPrefetch(unsigned, size_t);
+                unsigned getPrefetchDepth() const;
+                size_t getPrefetchMaxSize() const;
                 static const vlc_tick_t BUFFERING_LOWEST_LIMIT;
                 static const vlc_tick_t DEFAULT_MIN_BUFFERING;
                 static const vlc_tick_t DEFAULT_MAX_BUFFERING;
                 static const vlc_tick_t DEFAULT_LIVE_BUFFERING;
+                static const size_t DEFAULT_PREFETCH_MAXSIZE;
 
             protected:
                 vlc_tick_t userMinBuffering;
                 vlc_tick_t userMaxBuffering;
                 vlc_tick_t userLiveDelay;
                 Undef<bool> userLowLatency;
+                unsigned prefetchDepth;
+                size_t prefetchMaxSize;
         };
 
         class DefaultBufferingLogic : public AbstractBufferingLogic
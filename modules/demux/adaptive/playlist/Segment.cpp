@@ -77,7 +77,8 @@ bool ISegment::prepareChunk(SharedResources *res, SegmentChunk *chunk, BaseRepre
     return true;
 }
 
-SegmentChunk* ISegment::toChunk(SharedResources *res, size_t index, BaseRepresentation *rep)
+SegmentChunk* ISegment::toChunk(SharedResources *res, size_t index, BaseRepresentation *rep,
+                                bool prefetch)
 {
     const std::string url = getUrlSegment().toString(index, rep);
     BytesRange range;
@@ -107,7 +108,10 @@ SegmentChunk* ISegment::toChunk(SharedResources *res, size_t index, BaseRepresen
                 delete chunk;
                 return nullptr;
             }
-            res->getConnManager()->start(source);
+            if(prefetch)
+                res->getConnManager()->prefetch(source);
+            else
+                res->getConnManager()->start(source);
             return chunk;
         }
         else
@@ -58,7 +58,8 @@ namespace adaptive
                  *          That is basically true when using an Url, and false
                  *          when using an UrlTemplate
                  */
-                virtual SegmentChunk*                   toChunk         (SharedResources *, size_t, BaseRepresentation *);
+                virtual SegmentChunk*                   toChunk         (SharedResources *, size_t, BaseRepresentation *,
+                                                                         bool = false);
                 virtual SegmentChunk*                   createChunk     (AbstractChunkSource *, BaseRepresentation *) = 0;
                 virtual void                            setByteRange    (size_t start, size_t end);
                 virtual void                            setSequenceNumber(uint64_t);
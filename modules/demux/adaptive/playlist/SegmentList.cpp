@@ -30,6 +30,7 @@
 #include "SegmentInformation.hpp"
 #include "SegmentTimeline.h"
 
+#include <algorithm>
 #include <limits>
 #include <cassert>
 
@@ -96,11 +97,23 @@ void SegmentList::updateWith(AbstractMultipleSegmentBaseType *updated_,
     AbstractMultipleSegmentBaseType::updateWith(updated_);
 
     SegmentList *updated = dynamic_cast<SegmentList *>(updated_);
-    if(!updated || updated->segments.empty())
+    if(!updated)
         return;
 
     b_restamp = b_relative_mediatimes;
 
+    /* Incremental updates only carry the segments we don't know yet,
+     * with the start of the update window set as start number */
+    const StartnumberAttr *windowStart =
+            static_cast<const StartnumberAttr *>(updated->getAttribute(Type::StartNumber));
+
+    if(updated->segments.empty())
+    {
+        if(b_restamp && windowStart)
+            pruneBySegmentNumber(*windowStart);
+        return;
+    }
+
     if(!b_restamp || segments.empty())
     {
         if(!segments.empty())
@@ -113,7 +126,9 @@ void SegmentList::updateWith(AbstractMultipleSegmentBaseType *updated_,
     else
     {
         const Segment * prevSegment = segments.back();
-        const uint64_t oldest = updated->segments.front()->getSequenceNumber();
+        uint64_t oldest = updated->segments.front()->getSequenceNumber();
+        if(windowStart)
+            oldest = std::min(oldest, static_cast<const uint64_t &>(*windowStart));
 
         /* filter out known segments from the update */
         updated->pruneBySegmentNumber(prevSegment->getSequenceNumber() + 1);
@@ -164,8 +179,10 @@ void SegmentList::pruneBySegmentNumber(uint64_t tobelownum)
 
         totalLength -= (*it)->duration.Get();
         delete *it;
-        it = segments.erase(it);
+        ++it;
     }
+    /* single erase, as it can be the whole list */
+    segments.erase(segments.begin(), it);
 }
 
 bool SegmentList::getPlaybackTimeDurationBySegmentNumber(uint64_t number,
@@ -132,6 +132,7 @@ class DummyConnectionManager : public AbstractConnectionManager
         }
         virtual void recycleSource(AbstractChunkSource *) override {}
         virtual void start(AbstractChunkSource *) override {}
+        virtual void prefetch(AbstractChunkSource *) override {}
         virtual void cancel(AbstractChunkSource *) override {}
 
         std::map<std::string, std::vector<uint8_t>> data;
@@ -731,9 +732,105 @@ static int SegmentTracker_check_HLSseeks(BaseAdaptationSet *adaptSet,
     return 0;
 }
 
+/****** check chunks queued ahead ******/
+static int SegmentTracker_check_prefetch(BaseAdaptationSet *adaptSet,
+                                         DummyLogic *logic,
+                                         SegmentTracker *tracker,
+                                         SegmentTrackerListener &events)
+{
+    const stime_t START = 1337;
+    Timescale timescale(100);
+
+    ChunkInterface *currentChunk = nullptr;
+    try
+    {
+        for(int r=0; r<2; r++)
+        {
+            DummyRepresentation *rep = new DummyRepresentation(adaptSet);
+            adaptSet->addRepresentation(rep);
+            rep->setID(ID(r ? "1" : "0"));
+
+            SegmentList *segmentList = nullptr;
+            try
+            {
+                segmentList = new SegmentList(rep);
+                segmentList->addAttribute(new TimescaleAttr(timescale));
+                for(int i=0; i<10; i++)
+                {
+                    Segment *seg = new Segment(rep);
+                    seg->setSequenceNumber(123 + i);
+                    seg->setDiscontinuitySequenceNumber(456);
+                    seg->startTime.Set(START + 100 * i);
+                    seg->duration.Set(100);
+                    seg->setSourceUrl("sample/aac");
+                    segmentList->addSegment(seg);
+                }
+            } catch (...) {
+                delete segmentList;
+                std::rethrow_exception(std::current_exception());
+            }
+            rep->addAttribute(segmentList);
+        }
+
+        /* first chunk is not prefetched, the following ones are */
+        Expect(tracker->setStartPosition() == true);
+        Expect(tracker->getPrefetchedCount() == 0);
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(tracker->getPrefetchedCount() == 2);
+        Expect(tracker->getPrefetchStats().hits == 0);
+        Expect(tracker->getPrefetchStats().cancelled == 0);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        /* consume a prefetched chunk, and refill */
+        events.reset();
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(events.segmentchanged.starttime == timescale.ToTime(START + 100) + VLC_TICK_0);
+        Expect(tracker->getPrefetchedCount() == 2);
+        Expect(tracker->getPrefetchStats().hits == 1);
+        Expect(tracker->getPrefetchStats().cancelled == 0);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        /* switching drops the chunks prefetched on the previous variant */
+        logic->repindex = 1;
+        events.reset();
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(events.occured(TrackerEvent::Type::RepresentationSwitch) == true);
+        Expect(events.segmentchanged.starttime == timescale.ToTime(START + 200) + VLC_TICK_0);
+        Expect(tracker->getPrefetchedCount() == 2);
+        Expect(tracker->getPrefetchStats().hits == 1);
+        Expect(tracker->getPrefetchStats().cancelled == 2);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        /* seeking too */
+        Expect(tracker->setPositionByTime(VLC_TICK_0 + timescale.ToTime(START + 550), false, false) == true);
+        Expect(tracker->getPrefetchedCount() == 0);
+        Expect(tracker->getPrefetchStats().cancelled == 4);
+        events.reset();
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(events.segmentchanged.starttime == timescale.ToTime(START + 500) + VLC_TICK_0);
+        Expect(tracker->getPrefetchedCount() == 2);
+        Expect(tracker->getPrefetchStats().hits == 1);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+    } catch( ... ) {
+        delete currentChunk;
+        return 1;
+    }
+
+    return 0;
+}
+
 typedef decltype(SegmentTracker_check_formats) testfunc;
 
-static int Prepare_test(testfunc func)
+static int Prepare_test(testfunc func, unsigned prefetch = 0)
 {
     DummyConnectionManager *connManager = nullptr;
     try
@@ -747,6 +844,7 @@ static int Prepare_test(testfunc func)
 
     SharedResources sharedRes(nullptr, nullptr, connManager);
     DefaultBufferingLogic bufLogic;
+    bufLogic.setPrefetch(prefetch, AbstractBufferingLogic::DEFAULT_PREFETCH_MAXSIZE);
     SynchronizationReferences syncRefs;
 
     BaseAdaptationSet *adaptSet = CreatePlaylistPeriodAdaptationSet();
@@ -786,5 +884,9 @@ int SegmentTracker_test()
         Prepare_test(SegmentTracker_check_seeks) ||
         Prepare_test(SegmentTracker_check_switches) ||
         Prepare_test(SegmentTracker_check_HLSseeks) ||
+        /* same sequences with segments queued ahead */
+        Prepare_test(SegmentTracker_check_seeks, 2) ||
+        Prepare_test(SegmentTracker_check_switches, 2) ||
+        Prepare_test(SegmentTracker_check_prefetch, 2) ||
         0;
 }
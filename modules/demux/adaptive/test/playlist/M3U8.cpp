@@ -546,5 +546,119 @@ int M3U8Playlist_test()
         return 1;
     }
 
+    /* Manifest 6: live updates */
+    const char manifest6[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4\n"
+    "#EXT-X-BYTERANGE:1000@0\n"
+    "foobar.ts\n"
+    "#EXTINF:4\n"
+    "#EXT-X-BYTERANGE:1000\n"
+    "foobar.ts\n"
+    "#EXT-X-DISCONTINUITY\n"
+    "#EXTINF:4\n"
+    "#EXT-X-BYTERANGE:500\n"
+    "foobar.ts\n";
+
+    /* window moved by one, with known segments carrying the byte
+     * range offset and discontinuity state of the new ones */
+    const char manifest6update0[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-MEDIA-SEQUENCE:11\n"
+    "#EXTINF:4\n"
+    "#EXT-X-BYTERANGE:1000@1000\n"
+    "foobar.ts\n"
+    "#EXT-X-DISCONTINUITY\n"
+    "#EXTINF:4\n"
+    "#EXT-X-BYTERANGE:500\n"
+    "foobar.ts\n"
+    "#EXTINF:4\n"
+    "#EXT-X-BYTERANGE:700\n"
+    "foobar.ts\n"
+    "#EXT-X-DISCONTINUITY\n"
+    "#EXTINF:4\n"
+    "foobar2.ts\n";
+
+    /* window moved, without any new segment */
+    const char manifest6update1[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-MEDIA-SEQUENCE:13\n"
+    "#EXT-X-DISCONTINUITY-SEQUENCE:1\n"
+    "#EXTINF:4\n"
+    "#EXT-X-BYTERANGE:700@2500\n"
+    "foobar.ts\n"
+    "#EXT-X-DISCONTINUITY\n"
+    "#EXTINF:4\n"
+    "foobar2.ts\n";
+
+    m3u = ParseM3U8(obj, manifest6, sizeof(manifest6));
+    try
+    {
+        Expect(m3u);
+        Expect(m3u->isLive() == true);
+        HLSRepresentation *rep = static_cast<HLSRepresentation *>(
+                    m3u->getFirstPeriod()->getAdaptationSets().front()->
+                    getRepresentations().front());
+        Timescale timescale = rep->inheritTimescale();
+        Segment *known = rep->getMediaSegment(12);
+        Expect(known);
+        Expect(known->discontinuity);
+        Expect(known->getDiscontinuitySequenceNumber() == 1);
+
+        M3U8Parser parser(nullptr);
+        stream_t *substream = vlc_stream_MemoryNew(obj, (uint8_t *)manifest6update0,
+                                                   sizeof(manifest6update0), true);
+        Expect(substream);
+        parser.appendSegmentsFromPlaylist(obj, substream, rep);
+        vlc_stream_Delete(substream);
+
+        /* expired by the window start */
+        Expect(rep->getMediaSegment(10) == nullptr);
+        Expect(rep->getProfile()->getStartSegmentNumber() == 11);
+
+        /* known segments are kept, not recreated */
+        Expect(rep->getMediaSegment(12) == known);
+        Expect(known->discontinuity);
+
+        Segment *seg = rep->getMediaSegment(13);
+        Expect(seg);
+        Expect(seg->getOffset() == 2500);
+        Expect(seg->contains(2500 + 699));
+        Expect(!seg->contains(2500 + 700));
+        Expect(!seg->discontinuity);
+        Expect(seg->getDiscontinuitySequenceNumber() == 1);
+        Expect(seg->startTime.Get() == timescale.ToScaled(vlc_tick_from_sec(12)));
+
+        seg = rep->getMediaSegment(14);
+        Expect(seg);
+        Expect(seg->discontinuity);
+        Expect(seg->getDiscontinuitySequenceNumber() == 2);
+        Expect(seg->startTime.Get() == timescale.ToScaled(vlc_tick_from_sec(16)));
+
+        substream = vlc_stream_MemoryNew(obj, (uint8_t *)manifest6update1,
+                                         sizeof(manifest6update1), true);
+        Expect(substream);
+        parser.appendSegmentsFromPlaylist(obj, substream, rep);
+        vlc_stream_Delete(substream);
+
+        Expect(rep->getMediaSegment(12) == nullptr);
+        Expect(rep->getProfile()->getStartSegmentNumber() == 13);
+        seg = rep->getMediaSegment(13);
+        Expect(seg);
+        Expect(seg->startTime.Get() == timescale.ToScaled(vlc_tick_from_sec(12)));
+        Expect(rep->getMediaSegment(14));
+
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete m3u;
+        return 1;
+    }
+
     return 0;
 }
@@ -205,6 +205,48 @@ int SegmentList_test()
 	delete segmentList2;
         segmentList2 = nullptr;
 
+        /* incremental updates, relative timings */
+        segmentList = new SegmentList(nullptr, true);
+        segmentList->addAttribute(new TimescaleAttr(timescale));
+        segmentList->addAttribute(new DurationAttr(100));
+        for(int i=0; i<4; i++)
+        {
+            seg = new Segment(nullptr);
+            seg->setSequenceNumber(123 + i);
+            seg->startTime.Set(START + 100 * i);
+            seg->duration.Set(100);
+            segmentList->addSegment(seg);
+        }
+        segmentList2 = new SegmentList(nullptr, true);
+        segmentList2->addAttribute(new StartnumberAttr(125));
+        for(int i=0; i<2; i++)
+        {
+            seg = new Segment(nullptr);
+            seg->setSequenceNumber(127 + i);
+            seg->startTime.Set(100 * i);
+            seg->duration.Set(100);
+            segmentList2->addSegment(seg);
+        }
+        segmentList->updateWith(segmentList2);
+        Expect(segmentList->getStartSegmentNumber() == 125);
+        Expect(segmentList->getSegments().size() == 4);
+        Expect(segmentList->getSegments().at(3)->getSequenceNumber() == 128);
+        Expect(segmentList->getSegments().at(3)->startTime.Get() == START + 100 * (128 - 123));
+        Expect(segmentList->getTotalLength() == 100 * 4);
+
+        /* nothing new, window moved */
+        delete segmentList2;
+        segmentList2 = new SegmentList(nullptr, true);
+        segmentList2->addAttribute(new StartnumberAttr(127));
+        segmentList->updateWith(segmentList2);
+        Expect(segmentList->getStartSegmentNumber() == 127);
+        Expect(segmentList->getSegments().size() == 2);
+        Expect(segmentList->getTotalLength() == 100 * 2);
+
+        delete segmentList;
+        delete segmentList2;
+        segmentList2 = nullptr;
+
         /* gap updates, absolute media timings */
         segmentList = new SegmentList(nullptr, false);
         segmentList->addAttribute(new TimescaleAttr(timescale));
@@ -44,9 +44,12 @@
 #include <vlc_codecs.h>
 #include <vlc_charset.h>
 #include <vlc_memory.h>
+#include <vlc_atomic.h>
+#include <vlc_interrupt.h>
 
 #include "libavi.h"
 #include "../rawdv.h"
+#include "../index_cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -59,6 +62,17 @@
     "Recreate a index for the AVI file. Use this if your AVI file is damaged "\
     "or incomplete (not seekable)." )
 
+#define INDEX_BACKGROUND_TEXT N_("Create indexes in the background")
+#define INDEX_BACKGROUND_LONGTEXT N_( \
+    "Start playing damaged AVI files immediately, while their index is " \
+    "created by a separate thread." )
+
+#define INDEX_CACHE_TEXT N_("Cache created indexes")
+#define INDEX_CACHE_LONGTEXT N_( \
+    "Keep the index built for a damaged AVI file in the cache directory, " \
+    "so that it does not need to be created again the next time the same " \
+    "file is opened." )
+
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
@@ -81,6 +95,10 @@ vlc_module_begin ()
     add_integer( "avi-index", 0,
               INDEX_TEXT, INDEX_LONGTEXT, false )
         change_integer_list( pi_index, ppsz_indexes )
+    add_bool( "avi-index-background", true,
+              INDEX_BACKGROUND_TEXT, INDEX_BACKGROUND_LONGTEXT, true )
+    add_bool( "avi-index-cache", false,
+              INDEX_CACHE_TEXT, INDEX_CACHE_LONGTEXT, true )
 
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -135,6 +153,24 @@ typedef struct
     avi_entry_t     *p_entry;
 
 } avi_index_t;
+
+typedef struct
+{
+    demux_t         *p_demux;
+    stream_t        *s;
+    vlc_thread_t    thread;
+    atomic_bool     b_stop;
+
+    unsigned int    i_track;
+    uint64_t        i_movi_end;
+
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait;
+    avi_index_t     *p_pending; /* entries not merged yet, per track */
+    bool            b_complete;
+    bool            b_done;
+
+} avi_index_builder_t;
 static void avi_index_Init( avi_index_t * );
 static void avi_index_Clean( avi_index_t * );
 static int64_t avi_index_Append( avi_index_t *, uint64_t *, avi_entry_t * );
@@ -189,6 +225,12 @@ struct demux_sys_t
     uint64_t i_movi_begin;
     uint64_t i_movi_lastchunk_pos;   /* XXX position of last valid chunk */
 
+    avi_index_builder_t *p_builder;
+
+    /* persistent index cache */
+    bool     b_index_cache;
+    uint8_t  p_index_key[INDEX_CACHE_KEY_SIZE];
+
     /* number of streams and information */
     unsigned int i_track;
     avi_track_t  **track;
@@ -219,12 +261,19 @@ static int AVI_StreamBytesSet ( demux_t *, avi_track_t *, uint64_t i_byte );
 vlc_fourcc_t AVI_FourccGetCodec( unsigned int i_cat, vlc_fourcc_t );
 static int   AVI_GetKeyFlag    ( const avi_track_t *, const uint8_t * );
 
-static int AVI_PacketGetHeader( demux_t *, avi_packet_t *p_pk );
-static int AVI_PacketNext     ( demux_t * );
-static int AVI_PacketSearch   ( demux_t * );
+static int AVI_PacketGetHeader( stream_t *, avi_packet_t *p_pk );
+static int AVI_PacketNext     ( stream_t * );
+static int AVI_PacketSearch   ( demux_t *, stream_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static int  AVI_IndexBuilderStart( demux_t * );
+static void AVI_IndexBuilderStop ( demux_t * );
+static void AVI_IndexBuilderMerge( demux_t * );
+static void AVI_FixBeOSMediaKit( demux_t * );
+static void AVI_IndexBuilderWait ( demux_t *, vlc_tick_t );
+static bool AVI_IndexCacheLoad ( demux_t * );
+static void AVI_IndexCacheStore( demux_t * );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
@@ -278,6 +327,8 @@ static void Close ( vlc_object_t * p_this )
     demux_t *    p_demux = (demux_t *)p_this;
     demux_sys_t *p_sys = p_demux->p_sys  ;
 
+    AVI_IndexBuilderStop( p_demux );
+
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         if( p_sys->track[i] )
@@ -851,13 +902,27 @@ static int Open( vlc_object_t * p_this )
         goto error;
     }
 
+    if( p_sys->b_fastseekable &&
+        var_InheritBool( p_demux, "avi-index-cache" ) )
+        p_sys->b_index_cache =
+            index_cache_Key( VLC_OBJECT(p_demux), p_demux->s, "avi",
+                             p_sys->p_index_key ) == VLC_SUCCESS;
+
     i_do_index = var_InheritInteger( p_demux, "avi-index" );
-    if( i_do_index == 1 ) /* Always fix */
+    const bool b_index_background =
+        var_InheritBool( p_demux, "avi-index-background" );
+    if( AVI_IndexCacheLoad( p_demux ) )
+    {
+        /* Created by a previous session, do not ask again */
+        b_index = true;
+    }
+    else if( i_do_index == 1 ) /* Always fix */
     {
 aviindex:
         if( p_sys->b_fastseekable )
         {
-            AVI_IndexCreate( p_demux );
+            if( !b_index_background || AVI_IndexBuilderStart( p_demux ) )
+                AVI_IndexCreate( p_demux );
         }
         else if( p_sys->b_seekable )
         {
@@ -875,6 +940,12 @@ aviindex:
 
     /* *** movie length in sec *** */
     p_sys->i_length = AVI_MovieGetLength( p_demux );
+    if( p_sys->p_builder != NULL )
+    {
+        /* Trust the header until the index is complete */
+        p_sys->i_length = (vlc_tick_t)p_avih->i_totalframes *
+                          (vlc_tick_t)p_avih->i_microsecperframe / CLOCK_FREQ;
+    }
 
     /* Check the index completeness */
     unsigned int i_idx_totalframes = 0;
@@ -897,7 +968,8 @@ aviindex:
                 b_index = true;
                 goto aviindex;
             }
-            if( i_do_index == 0 )
+            /* Nothing to ask if playback does not wait for the index */
+            if( i_do_index == 0 && !b_index_background )
             {
                 const char *psz_msg = _(
                     "Because this file index is broken or missing, "
@@ -932,7 +1004,38 @@ aviindex:
         }
     }
 
-    /* fix some BeOS MediaKit generated file */
+    AVI_FixBeOSMediaKit( p_demux );
+
+    if( p_sys->b_seekable )
+    {
+        /* we have read all chunk so go back to movi */
+        if( vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos ) )
+            goto error;
+    }
+    /* Skip movi header */
+    if( vlc_stream_Read( p_demux->s, NULL, 12 ) < 12 )
+        goto error;
+
+    p_sys->i_movi_begin = p_movi->i_chunk_pos;
+    return VLC_SUCCESS;
+
+error:
+    Close( p_this );
+    return b_aborted ? VLC_ETIMEOUT : VLC_EGENERIC;
+}
+
+/* Fixes the audio tracks of some BeOS MediaKit generated files, once their
+ * index is complete */
+static void AVI_FixBeOSMediaKit( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    avi_chunk_list_t *p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
+    avi_chunk_list_t *p_hdrl = AVI_ChunkFind( p_riff, AVIFOURCC_hdrl, 0, true );
+    avi_chunk_avih_t *p_avih = AVI_ChunkFind( p_hdrl, AVIFOURCC_avih, 0, false );
+    if( !p_avih )
+        return;
+
     for( unsigned i = 0 ; i < p_sys->i_track; i++ )
     {
         avi_track_t         *tk = p_sys->track[i];
@@ -968,23 +1071,6 @@ aviindex:
             msg_Warn( p_demux, "track[%u] fixed with rate=%u scale=%u (BeOS MediaKit generated)", i, tk->i_rate, tk->i_scale );
         }
     }
-
-    if( p_sys->b_seekable )
-    {
-        /* we have read all chunk so go back to movi */
-        if( vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos ) )
-            goto error;
-    }
-    /* Skip movi header */
-    if( vlc_stream_Read( p_demux->s, NULL, 12 ) < 12 )
-        goto error;
-
-    p_sys->i_movi_begin = p_movi->i_chunk_pos;
-    return VLC_SUCCESS;
-
-error:
-    Close( p_this );
-    return b_aborted ? VLC_ETIMEOUT : VLC_EGENERIC;
 }
 
 /*****************************************************************************
@@ -1164,6 +1250,7 @@ static int Demux_Seekable( demux_t *p_demux )
     /* cannot be more than 100 stream (dcXX or wbXX) */
     avi_track_toread_t toread[100];
 
+    AVI_IndexBuilderMerge( p_demux );
 
     /* detect new selected/unselected streams */
     for( i_track = 0; i_track < p_sys->i_track; i_track++ )
@@ -1308,7 +1395,7 @@ static int Demux_Seekable( demux_t *p_demux )
             if( p_sys->b_seekable && p_sys->i_movi_lastchunk_pos >= p_sys->i_movi_begin + 12 )
             {
                 vlc_stream_Seek( p_demux->s, p_sys->i_movi_lastchunk_pos );
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return( AVI_TrackStopFinishedStreams( p_demux ) ? 0 : 1 );
                 }
@@ -1322,7 +1409,7 @@ static int Demux_Seekable( demux_t *p_demux )
             {
                 avi_packet_t avi_pk;
 
-                if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+                if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
                 {
                     msg_Warn( p_demux,
                              "cannot get packet header, track disabled" );
@@ -1331,7 +1418,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if( avi_pk.i_stream >= p_sys->i_track ||
                     ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
                 {
-                    if( AVI_PacketNext( p_demux ) )
+                    if( AVI_PacketNext( p_demux->s ) )
                     {
                         msg_Warn( p_demux,
                                   "cannot skip packet, track disabled" );
@@ -1375,7 +1462,7 @@ static int Demux_Seekable( demux_t *p_demux )
                     }
                     else
                     {
-                        if( AVI_PacketNext( p_demux ) )
+                        if( AVI_PacketNext( p_demux->s ) )
                         {
                             msg_Warn( p_demux,
                                       "cannot skip packet, track disabled" );
@@ -1554,7 +1641,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
 
         avi_packet_t    avi_pk;
 
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -1571,18 +1658,18 @@ static int Demux_UnSeekable( demux_t *p_demux )
                 case AVIFOURCC_JUNK:
                 case AVIFOURCC_LIST:
                 case AVIFOURCC_RIFF:
-                    return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                    return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                 case AVIFOURCC_idx1:
                     if( p_sys->b_odml )
                     {
-                        return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                        return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                     }
                     return VLC_DEMUXER_EOF;
                 default:
                     msg_Warn( p_demux,
                               "seems to have lost position @%"PRIu64", resync",
                               vlc_stream_Tell(p_demux->s) );
-                    if( AVI_PacketSearch( p_demux ) )
+                    if( AVI_PacketSearch( p_demux, p_demux->s ) )
                     {
                         msg_Err( p_demux, "resync failed" );
                         return VLC_DEMUXER_EGENERIC;
@@ -1608,7 +1695,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
             }
             else
             {
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return VLC_DEMUXER_EOF;
                 }
@@ -1734,6 +1821,8 @@ static int Seek( demux_t *p_demux, vlc_tick_t i_date, int i_percent, bool b_accu
             msg_Dbg( p_demux, "estimate date %"PRId64, i_date );
         }
 
+        AVI_IndexBuilderWait( p_demux, i_date );
+
         /* */
         vlc_tick_t i_wanted = i_date;
         vlc_tick_t i_start = i_date;
@@ -2013,7 +2102,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
     if( p_sys->i_movi_lastchunk_pos >= p_sys->i_movi_begin + 12 )
     {
         vlc_stream_Seek( p_demux->s, p_sys->i_movi_lastchunk_pos );
-        if( AVI_PacketNext( p_demux ) )
+        if( AVI_PacketNext( p_demux->s ) )
         {
             return VLC_EGENERIC;
         }
@@ -2025,7 +2114,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
 
     for( ;; )
     {
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             msg_Warn( p_demux, "cannot get packet header" );
             return VLC_EGENERIC;
@@ -2033,7 +2122,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
         if( avi_pk.i_stream >= p_sys->i_track ||
             ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
         {
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -2067,7 +2156,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
                 return VLC_SUCCESS;
             }
 
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -2349,17 +2438,17 @@ static void AVI_ParseStreamHeader( vlc_fourcc_t i_id,
 /****************************************************************************
  *
  ****************************************************************************/
-static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
+static int AVI_PacketGetHeader( stream_t *s, avi_packet_t *p_pk )
 {
     const uint8_t *p_peek;
 
-    if( vlc_stream_Peek( p_demux->s, &p_peek, 16 ) < 16 )
+    if( vlc_stream_Peek( s, &p_peek, 16 ) < 16 )
     {
         return VLC_EGENERIC;
     }
     p_pk->i_fourcc  = VLC_FOURCC( p_peek[0], p_peek[1], p_peek[2], p_peek[3] );
     p_pk->i_size    = GetDWLE( p_peek + 4 );
-    p_pk->i_pos     = vlc_stream_Tell( p_demux->s );
+    p_pk->i_pos     = vlc_stream_Tell( s );
     if( p_pk->i_fourcc == AVIFOURCC_LIST || p_pk->i_fourcc == AVIFOURCC_RIFF )
     {
         p_pk->i_type = VLC_FOURCC( p_peek[8],  p_peek[9],
@@ -2376,12 +2465,12 @@ static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketNext( demux_t *p_demux )
+static int AVI_PacketNext( stream_t *s )
 {
     avi_packet_t    avi_ck;
     size_t          i_skip = 0;
 
-    if( AVI_PacketGetHeader( p_demux, &avi_ck ) )
+    if( AVI_PacketGetHeader( s, &avi_ck ) )
     {
         return VLC_EGENERIC;
     }
@@ -2406,7 +2495,7 @@ static int AVI_PacketNext( demux_t *p_demux )
     if( i_skip > SSIZE_MAX )
         return VLC_EGENERIC;
 
-    ssize_t i_ret = vlc_stream_Read( p_demux->s, NULL, i_skip );
+    ssize_t i_ret = vlc_stream_Read( s, NULL, i_skip );
     if( i_ret < 0 || (size_t) i_ret != i_skip )
     {
         return VLC_EGENERIC;
@@ -2414,7 +2503,7 @@ static int AVI_PacketNext( demux_t *p_demux )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketSearch( demux_t *p_demux )
+static int AVI_PacketSearch( demux_t *p_demux, stream_t *s )
 {
     demux_sys_t     *p_sys = p_demux->p_sys;
     avi_packet_t    avi_pk;
@@ -2422,11 +2511,11 @@ static int AVI_PacketSearch( demux_t *p_demux )
 
     for( ;; )
     {
-        if( vlc_stream_Read( p_demux->s, NULL, 1 ) != 1 )
+        if( vlc_stream_Read( s, NULL, 1 ) != 1 )
         {
             return VLC_EGENERIC;
         }
-        AVI_PacketGetHeader( p_demux, &avi_pk );
+        AVI_PacketGetHeader( s, &avi_pk );
         if( avi_pk.i_stream < p_sys->i_track &&
             ( avi_pk.i_cat == AUDIO_ES || avi_pk.i_cat == VIDEO_ES ) )
         {
@@ -2788,68 +2877,42 @@ static void AVI_IndexLoad( demux_t *p_demux )
     }
 }
 
-static void AVI_IndexCreate( demux_t *p_demux )
+/* Positions s at the start of LIST-movi */
+static int AVI_IndexScanStart( demux_t *p_demux, stream_t *s,
+                               uint64_t *pi_movi_end )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    avi_chunk_list_t *p_riff;
-    avi_chunk_list_t *p_movi;
-
-    unsigned int i_stream;
-    uint32_t i_movi_end;
-
-    vlc_tick_t i_dialog_update;
-    vlc_dialog_id *p_dialog_id = NULL;
-
-    p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
-    p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0, true );
-
+    avi_chunk_list_t *p_riff = AVI_ChunkFind( &p_sys->ck_root,
+                                              AVIFOURCC_RIFF, 0, true );
+    avi_chunk_list_t *p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0, true );
     if( !p_movi )
     {
         msg_Err( p_demux, "cannot find p_movi" );
-        return;
+        return VLC_EGENERIC;
     }
 
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
-        avi_index_Init( &p_sys->track[i_stream]->idx );
-
-    i_movi_end = __MIN( (uint32_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
-                        stream_Size( p_demux->s ) );
-
-    vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos + 12 );
-    msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
+    *pi_movi_end = __MIN( (uint32_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
+                          stream_Size( s ) );
 
+    return vlc_stream_Seek( s, p_movi->i_chunk_pos + 12 );
+}
 
-    /* Only show dialog if AVI is > 10MB */
-    i_dialog_update = mdate();
-    if( stream_Size( p_demux->s ) > 10000000 )
-    {
-        p_dialog_id =
-            vlc_dialog_display_progress( p_demux, false, 0.0, _("Cancel"),
-                                         _("Broken or missing AVI Index"),
-                                         _("Fixing AVI Index...") );
-    }
+/* Indexes up to i_count chunks from the current position of s into p_idx
+ * (one index per track).
+ * Returns VLC_SUCCESS as long as the end of the movie was not reached. */
+static int AVI_IndexScan( demux_t *p_demux, stream_t *s, avi_index_t *p_idx,
+                          uint64_t *pi_last_pos, uint64_t i_movi_end,
+                          unsigned i_count )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
 
-    for( ;; )
+    while( i_count-- > 0 )
     {
         avi_packet_t pk;
 
-        /* Don't update/check dialog too often */
-        if( p_dialog_id != NULL && mdate() - i_dialog_update > 100000 )
-        {
-            if( vlc_dialog_is_cancelled( p_demux, p_dialog_id ) )
-                break;
-
-            double f_current = vlc_stream_Tell( p_demux->s );
-            double f_size    = stream_Size( p_demux->s );
-            double f_pos     = f_current / f_size;
-            vlc_dialog_update_progress( p_demux, p_dialog_id, f_pos );
-
-            i_dialog_update = mdate();
-        }
-
-        if( AVI_PacketGetHeader( p_demux, &pk ) )
-            break;
+        if( AVI_PacketGetHeader( s, &pk ) )
+            return VLC_EGENERIC;
 
         if( pk.i_stream < p_sys->i_track &&
             pk.i_cat == p_sys->track[pk.i_stream]->fmt.i_cat )
@@ -2862,7 +2925,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
             index.i_pos     = pk.i_pos;
             index.i_length  = pk.i_size;
             index.i_lengthtotal = pk.i_size;
-            avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
+            avi_index_Append( &p_idx[pk.i_stream], pi_last_pos, &index );
         }
         else
         {
@@ -2876,12 +2939,12 @@ static void AVI_IndexCreate( demux_t *p_demux )
                                             AVIFOURCC_RIFF, 1, true );
 
                     msg_Dbg( p_demux, "looking for new RIFF chunk" );
-                    if( !p_sysx || vlc_stream_Seek( p_demux->s,
+                    if( !p_sysx || vlc_stream_Seek( s,
                                          p_sysx->i_chunk_pos + 24 ) )
-                        goto print_stat;
+                        return VLC_EGENERIC;
                     break;
                 }
-                goto print_stat;
+                return VLC_EGENERIC;
 
             case AVIFOURCC_RIFF:
                     msg_Dbg( p_demux, "new RIFF chunk found" );
@@ -2893,30 +2956,433 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
             default:
                 msg_Warn( p_demux, "need resync, probably broken avi" );
-                if( AVI_PacketSearch( p_demux ) )
+                if( AVI_PacketSearch( p_demux, s ) )
                 {
                     msg_Warn( p_demux, "lost sync, abord index creation" );
-                    goto print_stat;
+                    return VLC_EGENERIC;
                 }
             }
         }
 
         if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= i_movi_end ) ||
-            AVI_PacketNext( p_demux ) )
+            AVI_PacketNext( s ) )
         {
-            break;
+            return VLC_EGENERIC;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+static void AVI_IndexCreate( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    unsigned int i_stream;
+    uint64_t i_movi_end;
+
+    vlc_tick_t i_dialog_update;
+    vlc_dialog_id *p_dialog_id = NULL;
+    bool b_cancelled = false;
+
+    if( AVI_IndexScanStart( p_demux, p_demux->s, &i_movi_end ) )
+        return;
+
+    assert( p_sys->i_track <= 100 );
+    avi_index_t p_idx[p_sys->i_track];
+    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+        avi_index_Init( &p_idx[i_stream] );
+
+    msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
+
+
+    /* Only show dialog if AVI is > 10MB */
+    i_dialog_update = mdate();
+    if( stream_Size( p_demux->s ) > 10000000 )
+    {
+        p_dialog_id =
+            vlc_dialog_display_progress( p_demux, false, 0.0, _("Cancel"),
+                                         _("Broken or missing AVI Index"),
+                                         _("Fixing AVI Index...") );
+    }
+
+    for( ;; )
+    {
+        /* Don't update/check dialog too often */
+        if( p_dialog_id != NULL && mdate() - i_dialog_update > 100000 )
+        {
+            if( vlc_dialog_is_cancelled( p_demux, p_dialog_id ) )
+            {
+                b_cancelled = true;
+                break;
+            }
+
+            double f_current = vlc_stream_Tell( p_demux->s );
+            double f_size    = stream_Size( p_demux->s );
+            double f_pos     = f_current / f_size;
+            vlc_dialog_update_progress( p_demux, p_dialog_id, f_pos );
+
+            i_dialog_update = mdate();
         }
+
+        if( AVI_IndexScan( p_demux, p_demux->s, p_idx,
+                           &p_sys->i_movi_lastchunk_pos, i_movi_end, 1 ) )
+            break;
     }
 
-print_stat:
     if( p_dialog_id != NULL )
         vlc_dialog_release( p_demux, p_dialog_id );
 
     for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
     {
+        avi_index_Clean( &p_sys->track[i_stream]->idx );
+        p_sys->track[i_stream]->idx = p_idx[i_stream];
         msg_Dbg( p_demux, "stream[%d] creating %d index entries",
-                i_stream, p_sys->track[i_stream]->idx.i_size );
+                i_stream, p_idx[i_stream].i_size );
+    }
+
+    /* A partial index must be completed next time */
+    if( !b_cancelled )
+        AVI_IndexCacheStore( p_demux );
+}
+
+/*****************************************************************************
+ * Background index creation: a thread scans LIST-movi with its own stream
+ * while playback starts. Its entries are handed over to the tracks by the
+ * demux thread, which only has to skip the ones it already found itself.
+ *****************************************************************************/
+#define AVI_INDEX_BUILDER_STEP 1024
+
+static void *AVI_IndexBuilderThread( void *data )
+{
+    avi_index_builder_t *p_builder = data;
+    demux_t *p_demux = p_builder->p_demux;
+    const unsigned i_track = p_builder->i_track;
+
+    avi_index_t p_idx[i_track];
+    for( unsigned i = 0; i < i_track; i++ )
+        avi_index_Init( &p_idx[i] );
+
+    uint64_t i_last_pos = 0;
+    bool b_complete = false;
+    unsigned i_entries = 0;
+
+    while( !atomic_load( &p_builder->b_stop ) )
+    {
+        b_complete = AVI_IndexScan( p_demux, p_builder->s, p_idx, &i_last_pos,
+                                    p_builder->i_movi_end,
+                                    AVI_INDEX_BUILDER_STEP ) != VLC_SUCCESS;
+
+        vlc_mutex_lock( &p_builder->lock );
+        for( unsigned i = 0; i < i_track; i++ )
+        {
+            for( uint32_t j = 0; j < p_idx[i].i_size; j++ )
+                avi_index_Append( &p_builder->p_pending[i], &i_last_pos,
+                                  &p_idx[i].p_entry[j] );
+            i_entries += p_idx[i].i_size;
+            p_idx[i].i_size = 0;
+        }
+        p_builder->b_complete = b_complete;
+        vlc_cond_signal( &p_builder->wait );
+        vlc_mutex_unlock( &p_builder->lock );
+
+        if( b_complete )
+            break;
+    }
+
+    vlc_mutex_lock( &p_builder->lock );
+    p_builder->b_done = true;
+    vlc_cond_signal( &p_builder->wait );
+    vlc_mutex_unlock( &p_builder->lock );
+
+    for( unsigned i = 0; i < i_track; i++ )
+        avi_index_Clean( &p_idx[i] );
+
+    msg_Dbg( p_demux, "background index %s after %u entries",
+             b_complete ? "completed" : "stopped", i_entries );
+    return NULL;
+}
+
+static int AVI_IndexBuilderStart( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_demux->s->psz_url == NULL )
+        return VLC_EGENERIC;
+
+    avi_index_builder_t *p_builder = malloc( sizeof(*p_builder) );
+    if( unlikely(p_builder == NULL) )
+        return VLC_ENOMEM;
+
+    p_builder->p_pending = vlc_alloc( p_sys->i_track, sizeof(avi_index_t) );
+    p_builder->s = vlc_stream_NewURL( p_demux, p_demux->s->psz_url );
+    if( p_builder->p_pending == NULL || p_builder->s == NULL ||
+        AVI_IndexScanStart( p_demux, p_builder->s, &p_builder->i_movi_end ) )
+        goto error;
+
+    p_builder->p_demux = p_demux;
+    p_builder->i_track = p_sys->i_track;
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Init( &p_builder->p_pending[i] );
+    vlc_mutex_init( &p_builder->lock );
+    vlc_cond_init( &p_builder->wait );
+    atomic_init( &p_builder->b_stop, false );
+    p_builder->b_complete = false;
+    p_builder->b_done = false;
+
+    if( vlc_clone( &p_builder->thread, AVI_IndexBuilderThread, p_builder,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_cond_destroy( &p_builder->wait );
+        vlc_mutex_destroy( &p_builder->lock );
+        goto error;
+    }
+
+    /* Playback indexes what it reads until the thread catches up */
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_Clean( &p_sys->track[i]->idx );
+        avi_index_Init( &p_sys->track[i]->idx );
+    }
+    p_sys->i_movi_lastchunk_pos = 0;
+    p_sys->p_builder = p_builder;
+
+    msg_Dbg( p_demux, "creating index from LIST-movi in the background" );
+    return VLC_SUCCESS;
+
+error:
+    if( p_builder->s != NULL )
+        vlc_stream_Delete( p_builder->s );
+    free( p_builder->p_pending );
+    free( p_builder );
+    return VLC_EGENERIC;
+}
+
+static void AVI_IndexBuilderStop( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_index_builder_t *p_builder = p_sys->p_builder;
+
+    if( p_builder == NULL )
+        return;
+
+    atomic_store( &p_builder->b_stop, true );
+    vlc_join( p_builder->thread, NULL );
+
+    for( unsigned i = 0; i < p_builder->i_track; i++ )
+        avi_index_Clean( &p_builder->p_pending[i] );
+    free( p_builder->p_pending );
+    vlc_stream_Delete( p_builder->s );
+    vlc_cond_destroy( &p_builder->wait );
+    vlc_mutex_destroy( &p_builder->lock );
+    free( p_builder );
+    p_sys->p_builder = NULL;
+}
+
+/* Moves the entries found by the thread to the tracks */
+static void AVI_IndexBuilderMerge( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_index_builder_t *p_builder = p_sys->p_builder;
+
+    if( p_builder == NULL )
+        return;
+
+    vlc_mutex_lock( &p_builder->lock );
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_t *p_pending = &p_builder->p_pending[i];
+        avi_index_t *p_index = &p_sys->track[i]->idx;
+
+        for( uint32_t j = 0; j < p_pending->i_size; j++ )
+        {
+            avi_entry_t *p_entry = &p_pending->p_entry[j];
+
+            /* Skip the chunks playback has indexed on its own */
+            if( p_index->i_size > 0 &&
+                p_entry->i_pos <= p_index->p_entry[p_index->i_size - 1].i_pos )
+                continue;
+            avi_index_Append( p_index, &p_sys->i_movi_lastchunk_pos, p_entry );
+        }
+        p_pending->i_size = 0;
     }
+    const bool b_complete = p_builder->b_complete;
+    vlc_mutex_unlock( &p_builder->lock );
+
+    if( b_complete )
+    {
+        AVI_IndexBuilderStop( p_demux );
+        /* skipped at opening, as the index was still empty */
+        AVI_FixBeOSMediaKit( p_demux );
+        p_sys->i_length = AVI_MovieGetLength( p_demux );
+        AVI_IndexCacheStore( p_demux );
+    }
+}
+
+static bool AVI_IndexCovers( demux_t *p_demux, vlc_tick_t i_date )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_track_t *tk = p_sys->track[i];
+        const avi_index_t *p_index = &tk->idx;
+
+        if( !tk->b_activated )
+            continue;
+        if( p_index->i_size == 0 )
+            return false;
+
+        if( !tk->i_samplesize )
+        {
+            if( AVI_PTSToChunk( tk, i_date ) >= p_index->i_size )
+                return false;
+        }
+        else
+        {
+            const avi_entry_t *p_last = &p_index->p_entry[p_index->i_size - 1];
+            if( AVI_PTSToByte( tk, i_date ) >=
+                (int64_t)(p_last->i_lengthtotal + p_last->i_length) )
+                return false;
+        }
+    }
+    return true;
+}
+
+/* Waits for the thread to index up to a date, rather than reading the same
+ * chunks a second time with the playback stream */
+static void AVI_IndexBuilderWait( demux_t *p_demux, vlc_tick_t i_date )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    AVI_IndexBuilderMerge( p_demux );
+    while( p_sys->p_builder != NULL && !AVI_IndexCovers( p_demux, i_date ) )
+    {
+        avi_index_builder_t *p_builder = p_sys->p_builder;
+
+        vlc_mutex_lock( &p_builder->lock );
+        vlc_cond_timedwait( &p_builder->wait, &p_builder->lock,
+                            mdate() + CLOCK_FREQ / 10 );
+        const bool b_done = p_builder->b_done;
+        vlc_mutex_unlock( &p_builder->lock );
+
+        AVI_IndexBuilderMerge( p_demux );
+        if( b_done || vlc_killed() )
+            break;
+    }
+}
+
+/* The cached index is an array of 64-bits words: the number of tracks, the
+ * last chunk position, then for each track its number of entries followed by
+ * the entries themselves. */
+#define AVI_INDEX_CACHE_ENTRY 5
+
+static bool AVI_IndexCacheLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->b_index_cache )
+        return false;
+
+    size_t i_size;
+    uint64_t *p_data = index_cache_Load( VLC_OBJECT(p_demux),
+                                         p_sys->p_index_key, &i_size );
+    if( p_data == NULL )
+        return false;
+
+    const size_t i_count = i_size / sizeof(*p_data);
+    size_t i = 2;
+    if( i_size % sizeof(*p_data) || i_count < 2 || p_data[0] != p_sys->i_track )
+        goto error;
+
+    for( unsigned i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    {
+        avi_index_t *p_index = &p_sys->track[i_stream]->idx;
+
+        avi_index_Clean( p_index );
+        avi_index_Init( p_index );
+
+        if( i >= i_count ||
+            p_data[i] > (i_count - i - 1) / AVI_INDEX_CACHE_ENTRY )
+            goto error;
+
+        const uint32_t i_entries = p_data[i++];
+        if( i_entries == 0 )
+            continue;
+
+        p_index->p_entry = vlc_alloc( i_entries, sizeof(avi_entry_t) );
+        if( unlikely(p_index->p_entry == NULL) )
+            goto error;
+        p_index->i_size = p_index->i_max = i_entries;
+
+        for( uint32_t j = 0; j < i_entries; j++ )
+        {
+            avi_entry_t *p_entry = &p_index->p_entry[j];
+            p_entry->i_id          = p_data[i++];
+            p_entry->i_flags       = p_data[i++];
+            p_entry->i_pos         = p_data[i++];
+            p_entry->i_length      = p_data[i++];
+            p_entry->i_lengthtotal = p_data[i++];
+        }
+        msg_Dbg( p_demux, "stream[%u] loaded %u cached index entries",
+                 i_stream, i_entries );
+    }
+    if( i != i_count )
+        goto error;
+
+    p_sys->i_movi_lastchunk_pos = p_data[1];
+    free( p_data );
+    return true;
+
+error:
+    msg_Warn( p_demux, "invalid cached index" );
+    for( unsigned i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    {
+        avi_index_Clean( &p_sys->track[i_stream]->idx );
+        avi_index_Init( &p_sys->track[i_stream]->idx );
+    }
+    free( p_data );
+    return false;
+}
+
+static void AVI_IndexCacheStore( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->b_index_cache )
+        return;
+
+    size_t i_count = 2 + p_sys->i_track;
+    for( unsigned i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+        i_count += (size_t)p_sys->track[i_stream]->idx.i_size *
+                   AVI_INDEX_CACHE_ENTRY;
+
+    uint64_t *p_data = vlc_alloc( i_count, sizeof(*p_data) );
+    if( unlikely(p_data == NULL) )
+        return;
+
+    size_t i = 0;
+    p_data[i++] = p_sys->i_track;
+    p_data[i++] = p_sys->i_movi_lastchunk_pos;
+    for( unsigned i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    {
+        const avi_index_t *p_index = &p_sys->track[i_stream]->idx;
+
+        p_data[i++] = p_index->i_size;
+        for( uint32_t j = 0; j < p_index->i_size; j++ )
+        {
+            const avi_entry_t *p_entry = &p_index->p_entry[j];
+            p_data[i++] = p_entry->i_id;
+            p_data[i++] = p_entry->i_flags;
+            p_data[i++] = p_entry->i_pos;
+            p_data[i++] = p_entry->i_length;
+            p_data[i++] = p_entry->i_lengthtotal;
+        }
+    }
+    assert( i == i_count );
+
+    index_cache_Store( VLC_OBJECT(p_demux), p_sys->p_index_key,
+                       p_data, i_count * sizeof(*p_data) );
+    free( p_data );
 }
 
 /* */
@@ -231,12 +231,8 @@ bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresent
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
         if(substream)
         {
-            std::list<Tag *> tagslist = parseEntries(substream);
+            appendSegmentsFromPlaylist(p_obj, substream, rep);
             vlc_stream_Delete(substream);
-
-            parseSegments(p_obj, rep, tagslist);
-
-            releaseTagsList(tagslist);
         }
         block_Release(p_block);
         return true;
@@ -244,6 +240,14 @@ bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresent
     return false;
 }
 
+void M3U8Parser::appendSegmentsFromPlaylist(vlc_object_t *p_obj, stream_t *p_stream,
+                                            HLSRepresentation *rep)
+{
+    std::list<Tag *> tagslist = parseEntries(p_stream);
+    parseSegments(p_obj, rep, tagslist);
+    releaseTagsList(tagslist);
+}
+
 static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
                             CommonEncryption &encryption)
 {
@@ -288,6 +292,17 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
     SegmentList *segmentList = new SegmentList(rep, !b_vod && !b_pdt);
     const Timescale timescale = rep->inheritTimescale();
 
+    /* Live updates merged into relative timings only need the segments
+     * we don't know yet: skip creating the others */
+    const SegmentList *knownList = rep->inheritSegmentList();
+    const bool b_incremental = segmentList->hasRelativeMediaTimes() && knownList &&
+                               knownList->hasRelativeMediaTimes() &&
+                               !knownList->getSegments().empty();
+    const uint64_t lastKnownNumber = b_incremental
+                                   ? knownList->getSegments().back()->getSequenceNumber()
+                                   : 0;
+    uint64_t windowStartNumber = std::numeric_limits<uint64_t>::max();
+
     rep->b_loaded = true;
     rep->b_live = !b_vod;
 
@@ -333,6 +348,26 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
                     break;
                 }
 
+                if(windowStartNumber == std::numeric_limits<uint64_t>::max())
+                    windowStartNumber = sequenceNumber;
+
+                if(b_incremental && sequenceNumber <= lastKnownNumber)
+                {
+                    /* only keep the context for the next segments */
+                    if(ctx_byterange)
+                    {
+                        std::pair<std::size_t,std::size_t> range = ctx_byterange->getValue().getByteRange();
+                        if(range.first == 0)
+                            range.first = prevbyterangeoffset;
+                        prevbyterangeoffset = range.first + range.second;
+                    }
+                    ++sequenceNumber;
+                    ctx_extinf = nullptr;
+                    ctx_byterange = nullptr;
+                    discontinuity = false;
+                    break;
+                }
+
                 HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber++);
                 if(!segment)
                     break;
@@ -455,6 +490,10 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
         segmentList->addSegment(seg);
     segmentstoappend.clear();
 
+    /* so that the merge still expires what left the window */
+    if(b_incremental && windowStartNumber != std::numeric_limits<uint64_t>::max())
+        segmentList->addAttribute(new StartnumberAttr(windowStartNumber));
+
     if(rep->isLive())
     {
         rep->getPlaylist()->duration.Set(0);
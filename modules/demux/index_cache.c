@@ -0,0 +1,234 @@
+/*****************************************************************************
+ * index_cache.c: persistent seek index cache
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+
+#include "index_cache.h"
+
+/* Amount of data hashed at the start of the file */
+#define INDEX_CACHE_PREFIX (64 * 1024)
+/* Refuse to load anything bigger (256 MiB) */
+#define INDEX_CACHE_MAX_SIZE (UINT64_C(256) << 20)
+
+#define INDEX_CACHE_MAGIC   VLC_FOURCC('V','I','D','X')
+/* Also detects byte order, as the payload is in host order */
+#define INDEX_CACHE_VERSION 1
+
+typedef struct
+{
+    uint32_t i_magic;
+    uint32_t i_version;
+    uint8_t  p_key[INDEX_CACHE_KEY_SIZE];
+    uint64_t i_size;
+} index_cache_header_t;
+
+int index_cache_Key( vlc_object_t *p_obj, stream_t *s, const char *psz_tag,
+                     uint8_t p_key[INDEX_CACHE_KEY_SIZE] )
+{
+    uint64_t i_size;
+    if( vlc_stream_GetSize( s, &i_size ) || i_size == 0 )
+        return VLC_EGENERIC;
+
+    int64_t i_mtime = 0;
+    if( s->psz_filepath != NULL )
+    {
+        struct stat st;
+        if( vlc_stat( s->psz_filepath, &st ) == 0 )
+            i_mtime = st.st_mtime;
+    }
+
+    uint8_t *p_prefix = malloc( INDEX_CACHE_PREFIX );
+    if( unlikely(p_prefix == NULL) )
+        return VLC_ENOMEM;
+
+    const uint64_t i_pos = vlc_stream_Tell( s );
+    ssize_t i_read = -1;
+    if( vlc_stream_Seek( s, 0 ) == VLC_SUCCESS )
+        i_read = vlc_stream_Read( s, p_prefix, INDEX_CACHE_PREFIX );
+    if( vlc_stream_Seek( s, i_pos ) != VLC_SUCCESS || i_read <= 0 )
+    {
+        free( p_prefix );
+        return VLC_EGENERIC;
+    }
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, psz_tag, strlen( psz_tag ) + 1 );
+    AddMD5( &md5, &i_size, sizeof(i_size) );
+    AddMD5( &md5, &i_mtime, sizeof(i_mtime) );
+    AddMD5( &md5, p_prefix, i_read );
+    EndMD5( &md5 );
+    free( p_prefix );
+
+    memcpy( p_key, md5.buf, INDEX_CACHE_KEY_SIZE );
+    msg_Dbg( p_obj, "index cache key computed from %zd bytes", i_read );
+    return VLC_SUCCESS;
+}
+
+static char *index_cache_Path( const uint8_t p_key[INDEX_CACHE_KEY_SIZE],
+                               bool b_create )
+{
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_cachedir == NULL )
+        return NULL;
+
+    char psz_hex[2 * INDEX_CACHE_KEY_SIZE + 1];
+    for( int i = 0; i < INDEX_CACHE_KEY_SIZE; i++ )
+        sprintf( &psz_hex[2 * i], "%02"PRIx8, p_key[i] );
+
+    char *psz_path;
+    if( asprintf( &psz_path, "%s" DIR_SEP "index", psz_cachedir ) == -1 )
+    {
+        free( psz_cachedir );
+        return NULL;
+    }
+
+    if( b_create )
+    {
+        if( (vlc_mkdir( psz_cachedir, 0700 ) && errno != EEXIST)
+         || (vlc_mkdir( psz_path, 0700 ) && errno != EEXIST) )
+        {
+            free( psz_path );
+            free( psz_cachedir );
+            return NULL;
+        }
+    }
+    free( psz_path );
+
+    if( asprintf( &psz_path, "%s" DIR_SEP "index" DIR_SEP "%s.idx",
+                  psz_cachedir, psz_hex ) == -1 )
+        psz_path = NULL;
+    free( psz_cachedir );
+    return psz_path;
+}
+
+void *index_cache_Load( vlc_object_t *p_obj,
+                        const uint8_t p_key[INDEX_CACHE_KEY_SIZE],
+                        size_t *pi_size )
+{
+    char *psz_path = index_cache_Path( p_key, false );
+    if( psz_path == NULL )
+        return NULL;
+
+    FILE *stream = vlc_fopen( psz_path, "rb" );
+    if( stream == NULL )
+    {
+        free( psz_path );
+        return NULL;
+    }
+
+    void *p_data = NULL;
+    index_cache_header_t hdr;
+    if( fread( &hdr, sizeof(hdr), 1, stream ) != 1
+     || hdr.i_magic != INDEX_CACHE_MAGIC
+     || hdr.i_version != INDEX_CACHE_VERSION
+     || memcmp( hdr.p_key, p_key, INDEX_CACHE_KEY_SIZE )
+     || hdr.i_size == 0 || hdr.i_size > INDEX_CACHE_MAX_SIZE )
+    {
+        msg_Warn( p_obj, "ignoring invalid index cache %s", psz_path );
+        goto end;
+    }
+
+    p_data = malloc( hdr.i_size );
+    if( unlikely(p_data == NULL) )
+        goto end;
+
+    /* A truncated or overlong file is a partial write */
+    if( fread( p_data, hdr.i_size, 1, stream ) != 1
+     || fgetc( stream ) != EOF )
+    {
+        msg_Warn( p_obj, "ignoring truncated index cache %s", psz_path );
+        free( p_data );
+        p_data = NULL;
+        goto end;
+    }
+
+    *pi_size = hdr.i_size;
+    msg_Dbg( p_obj, "loaded %"PRIu64" bytes of index from %s",
+             hdr.i_size, psz_path );
+end:
+    fclose( stream );
+    free( psz_path );
+    return p_data;
+}
+
+int index_cache_Store( vlc_object_t *p_obj,
+                       const uint8_t p_key[INDEX_CACHE_KEY_SIZE],
+                       const void *p_data, size_t i_size )
+{
+    char *psz_path = index_cache_Path( p_key, true );
+    if( psz_path == NULL )
+        return VLC_EGENERIC;
+
+    /* Write aside then rename, so that readers never see a partial entry */
+    char *psz_tmp;
+    if( asprintf( &psz_tmp, "%s.tmp", psz_path ) == -1 )
+    {
+        free( psz_path );
+        return VLC_ENOMEM;
+    }
+
+    int i_ret = VLC_EGENERIC;
+    FILE *stream = vlc_fopen( psz_tmp, "wb" );
+    if( stream == NULL )
+    {
+        msg_Warn( p_obj, "cannot create index cache %s: %s", psz_tmp,
+                  vlc_strerror_c(errno) );
+        goto end;
+    }
+
+    index_cache_header_t hdr;
+    memset( &hdr, 0, sizeof(hdr) );
+    hdr.i_magic = INDEX_CACHE_MAGIC;
+    hdr.i_version = INDEX_CACHE_VERSION;
+    memcpy( hdr.p_key, p_key, INDEX_CACHE_KEY_SIZE );
+    hdr.i_size = i_size;
+
+    bool b_ok = fwrite( &hdr, sizeof(hdr), 1, stream ) == 1
+             && fwrite( p_data, i_size, 1, stream ) == 1;
+    if( fclose( stream ) )
+        b_ok = false;
+
+    if( !b_ok || vlc_rename( psz_tmp, psz_path ) )
+    {
+        msg_Warn( p_obj, "cannot write index cache %s", psz_path );
+        vlc_unlink( psz_tmp );
+        goto end;
+    }
+
+    msg_Dbg( p_obj, "stored %zu bytes of index to %s", i_size, psz_path );
+    i_ret = VLC_SUCCESS;
+end:
+    free( psz_tmp );
+    free( psz_path );
+    return i_ret;
+}
@@ -0,0 +1,67 @@
+/*****************************************************************************
+ * index_cache.h: persistent seek index cache
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_DEMUX_INDEX_CACHE_H
+#define VLC_DEMUX_INDEX_CACHE_H 1
+
+/*
+ * Demuxers that have to scan a whole file to build a seek index can keep the
+ * result in the user cache directory, so that the next open of the same file
+ * does not pay for it again. The payload is opaque to this helper: each
+ * demuxer serializes its own index, in host byte order.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INDEX_CACHE_KEY_SIZE 16
+
+/**
+ * Computes the identity of the file behind a stream, from its size, its
+ * modification time (local files only) and a hash of its first bytes.
+ *
+ * @param psz_tag demuxer specific salt, also versioning the payload layout
+ * @note the stream position is preserved
+ */
+int index_cache_Key( vlc_object_t *, stream_t *, const char *psz_tag,
+                     uint8_t p_key[INDEX_CACHE_KEY_SIZE] );
+
+/**
+ * Loads the cached index matching a key.
+ *
+ * @return a buffer to free(), or NULL if the index is not in the cache
+ */
+void *index_cache_Load( vlc_object_t *,
+                        const uint8_t p_key[INDEX_CACHE_KEY_SIZE],
+                        size_t *pi_size );
+
+/**
+ * Stores an index, replacing any previous entry for the same key.
+ */
+int index_cache_Store( vlc_object_t *,
+                       const uint8_t p_key[INDEX_CACHE_KEY_SIZE],
+                       const void *p_data, size_t i_size );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
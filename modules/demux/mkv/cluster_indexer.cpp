@@ -0,0 +1,267 @@
+/*****************************************************************************
+ * cluster_indexer.cpp : matroska demuxer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "cluster_indexer.hpp"
+
+namespace {
+
+const uint32_t ID_EBML     = 0x1A45DFA3;
+const uint32_t ID_SEGMENT  = 0x18538067;
+const uint32_t ID_CLUSTER  = 0x1F43B675;
+const uint32_t ID_TIMECODE = 0xE7;
+const uint32_t ID_CRC32    = 0xBF;
+const uint32_t ID_VOID     = 0xEC;
+
+const uint64_t SIZE_UNKNOWN = UINT64_MAX;
+
+/* Clusters handed over to the demux thread at once */
+const size_t INDEXER_BATCH = 64;
+/* How far past a position to look for a cluster */
+const uint64_t SYNC_LIMIT = 4 << 20;
+
+/* Parses an element header, returns its length or 0 if invalid */
+size_t ReadHeader( const uint8_t *p, size_t i_peek, uint32_t *pi_id, uint64_t *pi_size )
+{
+    if( i_peek < 1 || p[0] == 0 )
+        return 0;
+
+    size_t i_idlen = 1;
+    while( !( p[0] & ( 0x80 >> ( i_idlen - 1 ) ) ) )
+        i_idlen++;
+    if( i_idlen > 4 || i_peek <= i_idlen || p[i_idlen] == 0 )
+        return 0;
+
+    uint32_t i_id = 0;
+    for( size_t i = 0; i < i_idlen; i++ )
+        i_id = ( i_id << 8 ) | p[i];
+
+    const uint8_t *q = &p[i_idlen];
+    size_t i_sizelen = 1;
+    while( !( q[0] & ( 0x80 >> ( i_sizelen - 1 ) ) ) )
+        i_sizelen++;
+    if( i_peek < i_idlen + i_sizelen )
+        return 0;
+
+    uint64_t i_size = q[0] & ( 0xFF >> i_sizelen );
+    bool b_unknown = i_size == ( 0xFFu >> i_sizelen );
+    for( size_t i = 1; i < i_sizelen; i++ )
+    {
+        i_size = ( i_size << 8 ) | q[i];
+        b_unknown = b_unknown && q[i] == 0xFF;
+    }
+
+    *pi_id = i_id;
+    *pi_size = b_unknown ? SIZE_UNKNOWN : i_size;
+    return i_idlen + i_sizelen;
+}
+
+/* Reads the timecode of the cluster at the current position of s */
+bool ReadCluster( stream_t *s, uint64_t i_timescale, ClusterIndexer::Cluster & out )
+{
+    const uint64_t i_pos = vlc_stream_Tell( s );
+    const uint8_t *p;
+    ssize_t i_peek = vlc_stream_Peek( s, &p, 64 );
+    if( i_peek <= 0 )
+        return false;
+
+    uint32_t i_id;
+    uint64_t i_size;
+    size_t i_hdr = ReadHeader( p, i_peek, &i_id, &i_size );
+    if( i_hdr == 0 || i_id != ID_CLUSTER )
+        return false;
+
+    /* The timecode comes first, possibly after a CRC or some padding */
+    for( size_t i_off = i_hdr, i_child = 0; i_child < 3; i_child++ )
+    {
+        uint32_t i_cid;
+        uint64_t i_csize;
+        size_t i_chdr = ReadHeader( &p[i_off], i_peek - i_off, &i_cid, &i_csize );
+        if( i_chdr == 0 || i_csize == SIZE_UNKNOWN ||
+            i_csize > size_t( i_peek ) - i_off - i_chdr )
+            return false;
+
+        if( i_cid == ID_TIMECODE )
+        {
+            if( i_csize > 8 )
+                return false;
+
+            uint64_t i_timecode = 0;
+            for( size_t i = 0; i < i_csize; i++ )
+                i_timecode = ( i_timecode << 8 ) | p[i_off + i_chdr + i];
+
+            out.fpos     = i_pos;
+            out.pts      = vlc_tick_t( i_timecode * i_timescale / 1000 );
+            out.duration = -1;
+            out.size     = i_size == SIZE_UNKNOWN ? SIZE_UNKNOWN : i_hdr + i_size;
+            return true;
+        }
+
+        if( i_cid != ID_CRC32 && i_cid != ID_VOID )
+            return false;
+        i_off += i_chdr + i_csize;
+    }
+    return false;
+}
+
+} // namespace
+
+ClusterIndexer::ClusterIndexer( demux_t *p_demux_, uint64_t i_timescale_,
+                                uint64_t i_start_, uint64_t i_end_ )
+    : p_demux( p_demux_ )
+    , s( NULL )
+    , i_timescale( i_timescale_ )
+    , i_start( i_start_ )
+    , i_end( i_end_ )
+    , b_started( false )
+    , b_stop( false )
+    , b_done( false )
+{
+    vlc_mutex_init( &lock );
+}
+
+ClusterIndexer::~ClusterIndexer()
+{
+    if( b_started )
+    {
+        b_stop = true;
+        vlc_join( thread, NULL );
+    }
+    if( s )
+        vlc_stream_Delete( s );
+    vlc_mutex_destroy( &lock );
+}
+
+bool ClusterIndexer::Start( const char *psz_url )
+{
+    s = vlc_stream_NewURL( p_demux, psz_url );
+    if( s == NULL )
+        return false;
+
+    b_started = !vlc_clone( &thread, Run, this, VLC_THREAD_PRIORITY_LOW );
+    return b_started;
+}
+
+bool ClusterIndexer::Fetch( clusters_t & out )
+{
+    vlc_mutex_locker locker( &lock );
+
+    out.insert( out.end(), pending.begin(), pending.end() );
+    pending.clear();
+    return b_done;
+}
+
+void *ClusterIndexer::Run( void *data )
+{
+    ClusterIndexer *p_this = static_cast<ClusterIndexer*>( data );
+    stream_t *s = p_this->s;
+
+    clusters_t batch;
+    size_t i_count = 0;
+    bool b_complete = false;
+    uint64_t i_pos = p_this->i_start;
+
+    while( !p_this->b_stop )
+    {
+        const uint8_t *p;
+        ssize_t i_peek;
+        uint32_t i_id = 0;
+        uint64_t i_size = SIZE_UNKNOWN;
+        size_t i_hdr = 0;
+        bool b_next = i_pos < p_this->i_end;
+
+        if( b_next )
+            b_next = vlc_stream_Seek( s, i_pos ) == VLC_SUCCESS &&
+                     ( i_peek = vlc_stream_Peek( s, &p, 16 ) ) > 0 &&
+                     ( i_hdr = ReadHeader( p, i_peek, &i_id, &i_size ) ) != 0 &&
+                     i_id != ID_SEGMENT && i_id != ID_EBML;
+
+        if( b_next && i_id == ID_CLUSTER )
+        {
+            Cluster cluster;
+            b_next = ReadCluster( s, p_this->i_timescale, cluster );
+            if( b_next )
+                batch.push_back( cluster );
+        }
+
+        /* elements of unknown size cannot be skipped without parsing them */
+        if( b_next && i_size != SIZE_UNKNOWN )
+            i_pos += i_hdr + i_size;
+        else
+            b_complete = true;
+
+        if( b_complete || batch.size() >= INDEXER_BATCH )
+        {
+            vlc_mutex_locker locker( &p_this->lock );
+
+            i_count += batch.size();
+            p_this->pending.insert( p_this->pending.end(), batch.begin(), batch.end() );
+            p_this->b_done = b_complete;
+            batch.clear();
+        }
+
+        if( b_complete )
+            break;
+    }
+
+    msg_Dbg( p_this->p_demux, "background indexing %s after %zu clusters",
+             b_complete ? "completed" : "stopped", i_count );
+    return NULL;
+}
+
+bool ClusterIndexer::FindCluster( stream_t *s, uint64_t i_timescale,
+                                  uint64_t i_pos, uint64_t i_end,
+                                  Cluster & out )
+{
+    const uint64_t i_limit = std::min( i_end, i_pos + SYNC_LIMIT );
+
+    while( i_pos < i_limit )
+    {
+        const uint8_t *p;
+        if( vlc_stream_Seek( s, i_pos ) )
+            return false;
+        ssize_t i_peek = vlc_stream_Peek( s, &p, 65536 );
+        if( i_peek < 4 )
+            return false;
+
+        uint64_t i_candidate = UINT64_MAX;
+        for( ssize_t i = 0; i + 4 <= i_peek; i++ )
+        {
+            if( p[i] == 0x1F && GetDWBE( &p[i] ) == ID_CLUSTER )
+            {
+                i_candidate = i_pos + i;
+                break;
+            }
+        }
+
+        if( i_candidate == UINT64_MAX )
+        {
+            i_pos += i_peek - 3;
+            continue;
+        }
+
+        if( vlc_stream_Seek( s, i_candidate ) == VLC_SUCCESS &&
+            ReadCluster( s, i_timescale, out ) )
+            return true;
+
+        /* that was a false positive in the payload */
+        i_pos = i_candidate + 1;
+    }
+    return false;
+}
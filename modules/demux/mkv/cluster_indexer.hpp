@@ -0,0 +1,73 @@
+/*****************************************************************************
+ * cluster_indexer.hpp : matroska demuxer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MKV_CLUSTER_INDEXER_HPP_
+#define MKV_CLUSTER_INDEXER_HPP_
+
+#include "mkv.hpp"
+#include "matroska_segment_seeker.hpp"
+
+#include <atomic>
+#include <vector>
+
+/* Finds the clusters of a segment without cues, from a thread with its own
+ * stream, so that playback does not wait and seeks can jump close to their
+ * target. Only the cluster headers are read, with a minimal EBML parser. */
+class ClusterIndexer
+{
+    public:
+        typedef SegmentSeeker::Cluster Cluster;
+        typedef std::vector<Cluster> clusters_t;
+
+        ClusterIndexer( demux_t *, uint64_t i_timescale,
+                        uint64_t i_start, uint64_t i_end );
+        ~ClusterIndexer();
+
+        bool Start( const char *psz_url );
+
+        /* Moves the clusters found since the last call to out,
+         * returns true once the whole segment was scanned */
+        bool Fetch( clusters_t & out );
+
+        /* Reads the cluster starting at, or following, a position, using
+         * the given stream (whose position is not preserved) */
+        static bool FindCluster( stream_t *, uint64_t i_timescale,
+                                 uint64_t i_pos, uint64_t i_end,
+                                 Cluster & out );
+
+    private:
+        static void *Run( void * );
+
+        demux_t       *p_demux;
+        stream_t      *s;
+        uint64_t      i_timescale;
+        uint64_t      i_start;
+        uint64_t      i_end;
+
+        vlc_thread_t  thread;
+        bool          b_started;
+        std::atomic<bool> b_stop;
+
+        vlc_mutex_t   lock;
+        clusters_t    pending;
+        bool          b_done;
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include "util.hpp"
 #include "Ebml_parser.hpp"
 #include "Ebml_dispatcher.hpp"
+#include "stream_io_callback.hpp"
 
 #include <new>
 #include <iterator>
@@ -62,11 +63,18 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,ep( EbmlParser(&estream, p_seg, &demuxer.demuxer ))
     ,b_preloaded(false)
     ,b_ref_external_segments(false)
+    ,b_index_cache(false)
+    ,i_index_cache_size(0)
+    ,p_indexer(NULL)
 {
 }
 
 matroska_segment_c::~matroska_segment_c()
 {
+    IndexBackgroundMerge();
+    delete p_indexer;
+    IndexCacheStore();
+
     free( psz_writing_application );
     free( psz_muxing_application );
     free( psz_segment_filename );
@@ -483,6 +491,149 @@ void matroska_segment_c::IndexAppendCluster( KaxCluster *cluster )
     _seeker.add_cluster( cluster );
 }
 
+void matroska_segment_c::IndexBackgroundStart()
+{
+    if( !var_InheritBool( &sys.demuxer, "mkv-index-background" ) )
+        return;
+
+    /* the thread reads with its own stream, only worth it on local files */
+    stream_t *s = static_cast<vlc_stream_io_callback&>( es.I_O() ).GetStream();
+    bool b_fastseekable;
+    if( s->psz_url == NULL ||
+        vlc_stream_Control( s, STREAM_CAN_FASTSEEK, &b_fastseekable ) ||
+        !b_fastseekable )
+        return;
+
+    uint64_t i_end = segment->IsFiniteSize() ? segment->GetEndPosition()
+                                             : stream_Size( s );
+
+    p_indexer = new (std::nothrow) ClusterIndexer( &sys.demuxer, i_timescale,
+                                                   cluster->GetElementPosition(),
+                                                   i_end );
+    if( p_indexer && !p_indexer->Start( s->psz_url ) )
+    {
+        delete p_indexer;
+        p_indexer = NULL;
+    }
+}
+
+void matroska_segment_c::IndexBackgroundMerge()
+{
+    if( p_indexer == NULL )
+        return;
+
+    ClusterIndexer::clusters_t clusters;
+    bool b_done = p_indexer->Fetch( clusters );
+
+    for( ClusterIndexer::clusters_t::const_iterator it = clusters.begin();
+         it != clusters.end(); ++it )
+        _seeker.add_cluster( *it );
+
+    if( b_done )
+    {
+        msg_Dbg( &sys.demuxer, "background indexing done, %zu clusters known",
+                 _seeker._clusters.size() );
+        delete p_indexer;
+        p_indexer = NULL;
+    }
+}
+
+/* Bisects the part of the segment the indexer has not reached yet for the
+ * last cluster starting before a date */
+void matroska_segment_c::IndexBisect( vlc_tick_t i_mk_date )
+{
+    static const uint64_t i_min_range = 1 << 20;
+
+    if( _seeker._clusters.empty() )
+        return;
+
+    const SegmentSeeker::Cluster last = _seeker._clusters.rbegin()->second;
+    if( last.pts >= i_mk_date || last.size == UINT64_MAX )
+        return;
+
+    stream_t *s = static_cast<vlc_stream_io_callback&>( es.I_O() ).GetStream();
+    const uint64_t i_pos = vlc_stream_Tell( s );
+
+    uint64_t i_low = last.fpos + last.size;
+    uint64_t i_high = segment->IsFiniteSize() ? segment->GetEndPosition()
+                                              : stream_Size( s );
+    unsigned i_found = 0;
+
+    while( i_high > i_low && i_high - i_low > i_min_range )
+    {
+        const uint64_t i_middle = i_low + ( i_high - i_low ) / 2;
+        SegmentSeeker::Cluster found;
+
+        if( !ClusterIndexer::FindCluster( s, i_timescale, i_middle, i_high, found ) )
+        {
+            i_high = i_middle;
+            continue;
+        }
+
+        _seeker.add_cluster( found );
+        i_found++;
+
+        if( found.pts <= i_mk_date )
+            i_low = found.fpos + 1;
+        else
+            i_high = i_middle;
+    }
+
+    vlc_stream_Seek( s, i_pos );
+    msg_Dbg( &sys.demuxer, "bisection found %u clusters", i_found );
+}
+
+void matroska_segment_c::IndexCacheLoad()
+{
+    if( !var_InheritBool( &sys.demuxer, "mkv-index-cache" ) )
+        return;
+
+    /* Several segments can share a file */
+    char psz_tag[32];
+    snprintf( psz_tag, sizeof(psz_tag), "mkv@%" PRIu64,
+              static_cast<uint64_t>( segment->GetElementPosition() ) );
+
+    stream_t *s = static_cast<vlc_stream_io_callback&>( es.I_O() ).GetStream();
+    if( index_cache_Key( VLC_OBJECT(&sys.demuxer), s, psz_tag,
+                         p_index_key ) != VLC_SUCCESS )
+        return;
+    b_index_cache = true;
+
+    size_t i_size;
+    uint64_t *p_data = static_cast<uint64_t*>(
+        index_cache_Load( VLC_OBJECT(&sys.demuxer), p_index_key, &i_size ) );
+    if( p_data == NULL )
+        return;
+
+    if( i_size % sizeof(*p_data) == 0 &&
+        _seeker.load_index( p_data, i_size / sizeof(*p_data) ) )
+    {
+        msg_Dbg( &sys.demuxer, "loaded %zu clusters from the index cache",
+                 _seeker._clusters.size() );
+        i_index_cache_size = i_size;
+    }
+    else
+        msg_Warn( &sys.demuxer, "invalid cached index" );
+    free( p_data );
+}
+
+void matroska_segment_c::IndexCacheStore()
+{
+    if( !b_index_cache || b_cues || segment == NULL )
+        return;
+
+    std::vector<uint64_t> data;
+    _seeker.save_index( data );
+
+    /* Nothing learnt since the index was loaded */
+    const size_t i_size = data.size() * sizeof(data[0]);
+    if( i_size == i_index_cache_size )
+        return;
+
+    index_cache_Store( VLC_OBJECT(&sys.demuxer), p_index_key,
+                       data.data(), i_size );
+}
+
 bool matroska_segment_c::PreloadClusters(uint64 i_cluster_pos)
 {
     struct ClusterHandlerPayload
@@ -696,6 +847,13 @@ bool matroska_segment_c::Preload( )
 
     ComputeTrackPriority();
 
+    if( !b_cues )
+    {
+        IndexCacheLoad();
+        if( cluster )
+            IndexBackgroundStart();
+    }
+
     b_preloaded = true;
 
     if( cluster )
@@ -849,6 +1007,10 @@ bool matroska_segment_c::Seek( demux_t &demuxer, vlc_tick_t i_absolute_mk_date,
 
     // find appropriate seekpoints //
 
+    IndexBackgroundMerge();
+    if( p_indexer )
+        IndexBisect( i_mk_date );
+
     try {
         seekpoints = _seeker.get_seekpoints( *this, i_mk_date, priority, selected_tracks );
     }
@@ -1259,7 +1421,8 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
             }
 
             vars.simpleblock = &ksblock;
-            vars.simpleblock->ReadData( vars.obj->es.I_O() );
+            /* the frames are read by BlockDecode, see SimpleBlockFrames */
+            vars.simpleblock->ReadData( vars.obj->es.I_O(), SCOPE_PARTIAL_DATA );
             vars.simpleblock->SetParent( *vars.obj->cluster );
 
             if( ksblock.IsKeyframe() )
@@ -27,6 +27,8 @@
 
 #include "mkv.hpp"
 #include "matroska_segment_seeker.hpp"
+#include "cluster_indexer.hpp"
+#include "../index_cache.h"
 #include <vector>
 #include <string>
 
@@ -173,9 +175,22 @@ private:
     bool TrackInit( mkv_track_t * p_tk );
     void ComputeTrackPriority();
     void EnsureDuration();
+    void IndexCacheLoad();
+    void IndexCacheStore();
+    void IndexBackgroundStart();
+    void IndexBackgroundMerge();
+    void IndexBisect( vlc_tick_t i_mk_date );
 
     SegmentSeeker _seeker;
 
+    /* persistent index, for segments without cues */
+    bool    b_index_cache;
+    uint8_t p_index_key[INDEX_CACHE_KEY_SIZE];
+    size_t  i_index_cache_size;
+
+    /* clusters found in the background, for segments without cues */
+    ClusterIndexer *p_indexer;
+
     friend SegmentSeeker;
 };
 
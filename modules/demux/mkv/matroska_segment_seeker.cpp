@@ -73,7 +73,14 @@ SegmentSeeker::add_cluster( KaxCluster * const p_cluster )
             : UINT64_MAX
     };
 
-    add_cluster_position( cinfo.fpos );
+    return add_cluster( cinfo );
+}
+
+SegmentSeeker::cluster_map_t::iterator
+SegmentSeeker::add_cluster( Cluster const& cinfo )
+{
+    if( !std::binary_search( _cluster_positions.begin(), _cluster_positions.end(), cinfo.fpos ) )
+        add_cluster_position( cinfo.fpos );
 
     cluster_map_t::iterator it = _clusters.lower_bound( cinfo.pts );
 
@@ -523,3 +530,119 @@ SegmentSeeker::mkv_jump_to( matroska_segment_c& ms, fptr_t fpos )
     ms.es.I_O().setFilePointer( fpos );
 }
 
+
+/* The index is flattened to 64-bits words: the searched ranges, the cluster
+ * positions, the clusters, then the seekpoints of each track, every list
+ * being prefixed by its length. */
+void
+SegmentSeeker::save_index( std::vector<uint64_t>& out ) const
+{
+    out.push_back( _ranges_searched.size() );
+    for( ranges_t::const_iterator it = _ranges_searched.begin(); it != _ranges_searched.end(); ++it )
+    {
+        out.push_back( it->start );
+        out.push_back( it->end );
+    }
+
+    out.push_back( _cluster_positions.size() );
+    out.insert( out.end(), _cluster_positions.begin(), _cluster_positions.end() );
+
+    out.push_back( _clusters.size() );
+    for( cluster_map_t::const_iterator it = _clusters.begin(); it != _clusters.end(); ++it )
+    {
+        out.push_back( it->second.fpos );
+        out.push_back( it->second.pts );
+        out.push_back( it->second.duration );
+        out.push_back( it->second.size );
+    }
+
+    out.push_back( _tracks_seekpoints.size() );
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin(); it != _tracks_seekpoints.end(); ++it )
+    {
+        out.push_back( it->first );
+        out.push_back( it->second.size() );
+        for( seekpoints_t::const_iterator sp = it->second.begin(); sp != it->second.end(); ++sp )
+        {
+            out.push_back( sp->fpos );
+            out.push_back( sp->pts );
+            out.push_back( sp->trust_level );
+        }
+    }
+}
+
+bool
+SegmentSeeker::load_index( uint64_t const* p_data, size_t i_count )
+{
+    uint64_t const* const p_end = p_data + i_count;
+
+    struct Reader {
+        static bool list( uint64_t const*& p, uint64_t const* end, size_t width, size_t& count )
+        {
+            if( p == end || *p > size_t( end - p - 1 ) / width )
+                return false;
+            count = *p++;
+            return true;
+        }
+    };
+
+    /* validate everything before touching the current index */
+    uint64_t const* p = p_data;
+    size_t count;
+
+    if( !Reader::list( p, p_end, 2, count ) ) return false;
+    uint64_t const* p_ranges = p; size_t i_ranges = count; p += 2 * count;
+
+    if( !Reader::list( p, p_end, 1, count ) ) return false;
+    uint64_t const* p_positions = p; size_t i_positions = count; p += count;
+
+    if( !Reader::list( p, p_end, 4, count ) ) return false;
+    uint64_t const* p_clusters = p; size_t i_clusters = count; p += 4 * count;
+
+    if( !Reader::list( p, p_end, 2, count ) ) return false;
+    uint64_t const* p_tracks = p; size_t i_tracks = count;
+    for( size_t i = 0; i < i_tracks; ++i )
+    {
+        if( p == p_end )
+            return false;
+        ++p; /* track id */
+        if( !Reader::list( p, p_end, 3, count ) )
+            return false;
+        p += 3 * count;
+    }
+    if( p != p_end )
+        return false;
+
+    for( size_t i = 0; i < i_ranges; ++i, p_ranges += 2 )
+        mark_range_as_searched( Range( p_ranges[0], p_ranges[1] ) );
+
+    for( size_t i = 0; i < i_positions; ++i )
+    {
+        if( !std::binary_search( _cluster_positions.begin(), _cluster_positions.end(), p_positions[i] ) )
+            add_cluster_position( p_positions[i] );
+    }
+
+    for( size_t i = 0; i < i_clusters; ++i, p_clusters += 4 )
+    {
+        Cluster cinfo = {
+            /* fpos     */ p_clusters[0],
+            /* pts      */ vlc_tick_t( p_clusters[1] ),
+            /* duration */ vlc_tick_t( p_clusters[2] ),
+            /* size     */ p_clusters[3]
+        };
+        _clusters.insert( cluster_map_t::value_type( cinfo.pts, cinfo ) );
+    }
+
+    for( size_t i = 0; i < i_tracks; ++i )
+    {
+        track_id_t track_id = track_id_t( *p_tracks++ );
+        size_t i_points = *p_tracks++;
+
+        for( size_t j = 0; j < i_points; ++j, p_tracks += 3 )
+        {
+            add_seekpoint( track_id, Seekpoint( p_tracks[0], vlc_tick_t( p_tracks[1] ),
+                           Seekpoint::TrustLevel( int64_t( p_tracks[2] ) ) ) );
+        }
+    }
+
+    return true;
+}
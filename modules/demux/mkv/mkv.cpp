@@ -81,6 +81,14 @@ vlc_module_begin ()
             N_("Preload clusters"),
             N_("Find all cluster positions by jumping cluster-to-cluster before playback"), true );
 
+    add_bool( "mkv-index-background", true,
+            N_("Index in the background"),
+            N_("Look for the clusters of files without cues from a separate thread during playback, so that seeking does not have to read the whole file."), true );
+
+    add_bool( "mkv-index-cache", false,
+            N_("Cache the index"),
+            N_("Keep the clusters and seek points found in files without cues in the cache directory, so that they are known the next time the same file is opened."), true );
+
     add_shortcut( "mka", "mkv" )
 vlc_module_end ()
 
@@ -523,43 +531,73 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
 
     size_t frame_size = 0;
     size_t block_size = 0;
+    unsigned int i_number_frames = 0;
 
+    /* SimpleBlocks are only read up to their header by BlockGet: their frames
+     * are read here straight into block_t, without a libebml copy */
+    block_t *p_frames = NULL;
     if( simpleblock != NULL )
-        block_size = simpleblock->GetSize();
+    {
+        stream_t *s = static_cast<vlc_stream_io_callback&>( p_segment->es.I_O() ).GetStream();
+        p_frames = SimpleBlockFrames( p_demux, s,
+                                      simpleblock->GetElementPosition() + simpleblock->HeadSize(),
+                                      simpleblock->GetSize() );
+        for( block_t *p_frame = p_frames; p_frame != NULL; p_frame = p_frame->p_next )
+            i_number_frames++;
+    }
     else
+    {
         block_size = block->GetSize();
+        i_number_frames = block->NumberFrames();
+    }
 
-    const unsigned int i_number_frames = block != NULL ? block->NumberFrames() :
-            ( simpleblock != NULL ? simpleblock->NumberFrames() : 0 );
+    const bool b_header_stripping =
+            track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
+            track.p_compression_data != NULL &&
+            track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES;
 
     for( unsigned int i_frame = 0; i_frame < i_number_frames; i_frame++ )
     {
         block_t *p_block;
-        DataBuffer *data;
+        size_t extra_data = track.fmt.i_codec == VLC_CODEC_PRORES ? 8 : 0;
+
         if( simpleblock != NULL )
         {
-            data = &simpleblock->GetBuffer(i_frame);
+            block_t *p_frame = p_frames;
+            p_frames = p_frame->p_next;
+            p_frame->p_next = NULL;
+
+            if( unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) && !b_header_stripping )
+            {
+                p_block = packetize_wavpack( track, p_frame->p_buffer, p_frame->i_buffer );
+                block_Release( p_frame );
+            }
+            else
+            {
+                /* room for the stripped header, in the block headroom */
+                if( b_header_stripping )
+                    extra_data += track.p_compression_data->GetSize();
+                p_block = extra_data ? block_Realloc( p_frame, extra_data, p_frame->i_buffer )
+                                     : p_frame;
+            }
         }
         else
         {
-            data = &block->GetBuffer(i_frame);
-        }
-        frame_size += data->Size();
-        if( !data->Buffer() || data->Size() > frame_size || frame_size > block_size  )
-        {
-            msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
-            break;
-        }
-        size_t extra_data = track.fmt.i_codec == VLC_CODEC_PRORES ? 8 : 0;
+            DataBuffer *data = &block->GetBuffer(i_frame);
+            frame_size += data->Size();
+            if( !data->Buffer() || data->Size() > frame_size || frame_size > block_size  )
+            {
+                msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
+                break;
+            }
 
-        if( track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
-            track.p_compression_data != NULL &&
-            track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
-            p_block = MemToBlock( data->Buffer(), data->Size(), track.p_compression_data->GetSize() + extra_data );
-        else if( unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
-            p_block = packetize_wavpack( track, data->Buffer(), data->Size() );
-        else
-            p_block = MemToBlock( data->Buffer(), data->Size(), extra_data );
+            if( b_header_stripping )
+                p_block = MemToBlock( data->Buffer(), data->Size(), track.p_compression_data->GetSize() + extra_data );
+            else if( unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
+                p_block = packetize_wavpack( track, data->Buffer(), data->Size() );
+            else
+                p_block = MemToBlock( data->Buffer(), data->Size(), extra_data );
+        }
 
         if( p_block == NULL )
         {
@@ -663,6 +701,7 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
                 if( p_block->i_size >= sizeof(pci_t))
                     p_sys->p_ev->SetPci( (const pci_t *)&p_block->p_buffer[1]);
                 block_Release( p_block );
+                block_ChainRelease( p_frames );
                 return;
             }
             p_block->i_dts = p_block->i_pts = i_pts;
@@ -700,6 +739,9 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
                  i_pts + ( vlc_tick_t )track.i_default_duration:
                  ( track.fmt.b_packetized ) ? VLC_TICK_INVALID : i_pts + 1;
     }
+
+    /* frames left over after an error */
+    block_ChainRelease( p_frames );
 }
 
 /*****************************************************************************
@@ -163,6 +163,155 @@ block_t *MemToBlock( uint8_t *p_mem, size_t i_mem, size_t offset)
     return p_block;
 }
 
+/* Reads an EBML variable size integer, returns its length or 0 */
+static unsigned ReadVint( const uint8_t *p, const uint8_t *p_end, uint64_t *pi_value )
+{
+    if( p >= p_end || *p == 0 )
+        return 0;
+
+    unsigned i_len = 1;
+    uint8_t i_mask = 0x80;
+    while( !( *p & i_mask ) )
+    {
+        i_mask >>= 1;
+        i_len++;
+    }
+    if( (size_t)( p_end - p ) < i_len )
+        return 0;
+
+    uint64_t i_value = *p & ( i_mask - 1 );
+    for( unsigned i = 1; i < i_len; i++ )
+        i_value = ( i_value << 8 ) | p[i];
+    *pi_value = i_value;
+    return i_len;
+}
+
+/* Reads the payload of a SimpleBlock straight from the stream, and splits it
+ * into one block_t per frame. The block header and the lacing are parsed here,
+ * so libmatroska only has to read the header (SCOPE_PARTIAL_DATA).
+ * The last (or only) frame is the block read from the stream; the laced frames
+ * before it get a copy of their own. */
+block_t *SimpleBlockFrames( demux_t *p_demux, stream_t *s,
+                            uint64_t i_pos, uint64_t i_size )
+{
+    if( i_size < 4 || i_size > SIZE_MAX || vlc_stream_Seek( s, i_pos ) )
+        return NULL;
+
+    block_t *p_data = vlc_stream_Block( s, i_size );
+    if( p_data == NULL || p_data->i_buffer < i_size )
+    {
+        msg_Warn( p_demux, "Cannot read block at %" PRIu64, i_pos );
+        if( p_data )
+            block_Release( p_data );
+        return NULL;
+    }
+
+    const uint8_t *p = p_data->p_buffer;
+    const uint8_t *p_end = p + p_data->i_buffer;
+
+    /* track number, timecode, flags */
+    uint64_t i_track;
+    unsigned i_len = ReadVint( p, p_end, &i_track );
+    if( i_len == 0 || (size_t)( p_end - p ) < i_len + 3 )
+        goto error;
+    p += i_len;
+    {
+        const unsigned i_lacing = ( p[2] >> 1 ) & 0x03;
+        p += 3;
+
+        unsigned i_frames = 1;
+        size_t pi_sizes[256];
+
+        if( i_lacing != 0 )
+        {
+            if( p >= p_end )
+                goto error;
+            i_frames = *p++ + 1;
+
+            switch( i_lacing )
+            {
+            case 1: /* Xiph */
+                for( unsigned i = 0; i < i_frames - 1; i++ )
+                {
+                    uint8_t i_byte;
+                    pi_sizes[i] = 0;
+                    do
+                    {
+                        if( p >= p_end )
+                            goto error;
+                        i_byte = *p++;
+                        pi_sizes[i] += i_byte;
+                    } while( i_byte == 0xFF );
+                }
+                break;
+            case 2: /* fixed */
+                if( ( p_end - p ) % i_frames )
+                    goto error;
+                for( unsigned i = 0; i < i_frames - 1; i++ )
+                    pi_sizes[i] = ( p_end - p ) / i_frames;
+                break;
+            case 3: /* EBML, signed differences after the first size */
+            {
+                int64_t i_frame = 0;
+                for( unsigned i = 0; i < i_frames - 1; i++ )
+                {
+                    uint64_t i_value;
+                    i_len = ReadVint( p, p_end, &i_value );
+                    if( i_len == 0 )
+                        goto error;
+                    p += i_len;
+                    if( i == 0 )
+                        i_frame = i_value;
+                    else
+                        i_frame += (int64_t) i_value
+                                 - ( ( INT64_C(1) << ( 7 * i_len - 1 ) ) - 1 );
+                    if( i_frame < 0 )
+                        goto error;
+                    pi_sizes[i] = i_frame;
+                }
+                break;
+            }
+            }
+        }
+
+        size_t i_total = 0;
+        for( unsigned i = 0; i < i_frames - 1; i++ )
+        {
+            if( pi_sizes[i] > (size_t)( p_end - p ) - i_total )
+                goto error;
+            i_total += pi_sizes[i];
+        }
+
+        block_t *p_chain = NULL;
+        block_t **pp_last = &p_chain;
+        for( unsigned i = 0; i < i_frames - 1; i++ )
+        {
+            block_t *p_frame = block_Alloc( pi_sizes[i] );
+            if( unlikely( p_frame == NULL ) )
+            {
+                block_ChainRelease( p_chain );
+                block_Release( p_data );
+                return NULL;
+            }
+            memcpy( p_frame->p_buffer, p, pi_sizes[i] );
+            p += pi_sizes[i];
+            *pp_last = p_frame;
+            pp_last = &p_frame->p_next;
+        }
+
+        const size_t i_skip = p - p_data->p_buffer;
+        p_data->p_buffer += i_skip;
+        p_data->i_buffer -= i_skip;
+        *pp_last = p_data;
+        return p_chain;
+    }
+
+error:
+    msg_Warn( p_demux, "Invalid block lacing at %" PRIu64, i_pos );
+    block_Release( p_data );
+    return NULL;
+}
+
 
 void handle_real_audio(demux_t * p_demux, mkv_track_t * p_tk, block_t * p_blk, vlc_tick_t i_pts)
 {
@@ -26,6 +26,7 @@
 
 #include <vlc_common.h>
 #include <vlc_stream.h>                               /* vlc_stream_Peek*/
+#include <vlc_access.h>                               /* vlc_access_NewMRL */
 #include <vlc_strings.h>                              /* vlc_ascii_tolower */
 
 #ifdef HAVE_ZLIB_H
@@ -5028,6 +5029,93 @@ MP4_Box_t *MP4_BoxGetNextChunk( stream_t *s )
     return p_fakeroot;
 }
 
+/* Largest tail fetched at once when the moov is after the mdat */
+#define MP4_TAIL_MAX_SIZE (64 << 20)
+
+/*****************************************************************************
+ * MP4_ReadTail : loads the boxes following the mdat, the stream being at the
+ * mdat header
+ *****************************************************************************
+ *  On slow seeking (network) streams, skipping the mdat then coming back to
+ *  it costs a new request each way. Instead, the boxes after the mdat are read
+ *  on a second access, and parsed from memory, while the main stream stays
+ *  (and keeps buffering) at the start of the mdat. The access is opened
+ *  without the stream filters, so that no prefetching starts reading from
+ *  the beginning of the file.
+ *****************************************************************************/
+static bool MP4_ReadTail( stream_t *p_stream, MP4_Box_t *p_vroot )
+{
+    MP4_Box_t mdat = { 0 };
+    if( !MP4_PeekBoxHeader( p_stream, &mdat ) || mdat.i_type != ATOM_mdat
+     || mdat.i_size < 8 || mdat.i_pos + mdat.i_size >= p_vroot->i_size )
+        return false;
+
+    const uint64_t i_tail_pos = mdat.i_pos + mdat.i_size;
+    const uint64_t i_tail_size = p_vroot->i_size - i_tail_pos;
+    if( i_tail_size < 8 || i_tail_size > MP4_TAIL_MAX_SIZE )
+        return false;
+
+    stream_t *p_tail = vlc_access_NewMRL( VLC_OBJECT(p_stream), p_stream->psz_url );
+    if( p_tail == NULL )
+        return false;
+
+    block_t *p_block = NULL;
+    if( MP4_Seek( p_tail, i_tail_pos ) == VLC_SUCCESS )
+        p_block = vlc_stream_Block( p_tail, i_tail_size );
+    vlc_stream_Delete( p_tail );
+
+    if( p_block == NULL || p_block->i_buffer < i_tail_size )
+    {
+        if( p_block )
+            block_Release( p_block );
+        return false;
+    }
+
+    msg_Dbg( p_stream, "fetched %"PRIu64" bytes after mdat @%"PRIu64,
+             i_tail_size, i_tail_pos );
+
+    MP4_Box_t *p_tailroot = MP4_BoxNew( ATOM_root );
+    bool b_ret = false;
+    if( p_tailroot != NULL )
+    {
+        p_tailroot->i_shortsize = 1;
+        p_tailroot->i_size = i_tail_size;
+        MP4_ReadBoxContainerRawInBox( p_stream, p_tailroot, p_block->p_buffer,
+                                      p_block->i_buffer, i_tail_pos );
+        b_ret = MP4_BoxGet( p_tailroot, "moov" ) != NULL
+             || MP4_BoxGet( p_tailroot, "foov" ) != NULL;
+    }
+    block_Release( p_block );
+
+    if( !b_ret )
+    {
+        MP4_BoxFree( p_tailroot );
+        return false;
+    }
+
+    /* Keep the mdat in the tree, as if it had been skipped over */
+    MP4_Box_t *p_mdat = malloc( sizeof(*p_mdat) );
+    if( unlikely(p_mdat == NULL) )
+    {
+        MP4_BoxFree( p_tailroot );
+        return false;
+    }
+    *p_mdat = mdat;
+    MP4_BoxAddChild( p_vroot, p_mdat );
+
+    for( MP4_Box_t *p_box = p_tailroot->p_first; p_box != NULL; )
+    {
+        MP4_Box_t *p_next = p_box->p_next;
+        p_box->p_next = NULL;
+        MP4_BoxAddChild( p_vroot, p_box );
+        p_box = p_next;
+    }
+    p_tailroot->p_first = p_tailroot->p_last = NULL;
+    MP4_BoxFree( p_tailroot );
+
+    return true;
+}
+
 /*****************************************************************************
  * MP4_BoxGetRoot : Parse the entire file, and create all boxes in memory
  *****************************************************************************
@@ -5047,14 +5135,30 @@ MP4_Box_t *MP4_BoxGetRoot( stream_t *p_stream )
     if( vlc_stream_GetSize( p_stream, &i_size ) == 0 )
         p_vroot->i_size = i_size;
 
+    /* On network streams, stop in front of the mdat to try fetching what
+     * follows it at once */
+    bool b_fastseekable, b_tail = false;
+    if( p_stream->psz_url != NULL && p_vroot->i_size > 0
+     && vlc_stream_Control( p_stream, STREAM_CAN_FASTSEEK, &b_fastseekable ) == VLC_SUCCESS
+     && !b_fastseekable )
+    {
+        const uint32_t stoplist[] = { ATOM_moov, 0 };
+        const uint32_t excludelist[] = { ATOM_mdat, 0 };
+        i_result = MP4_ReadBoxContainerRestricted( p_stream, p_vroot,
+                                                   stoplist, excludelist );
+        if( i_result && !MP4_BoxGet( p_vroot, "moov" ) )
+            b_tail = MP4_ReadTail( p_stream, p_vroot );
+    }
+
     /* First get the moov */
+    if( !b_tail && !MP4_BoxGet( p_vroot, "moov" ) )
     {
         const uint32_t stoplist[] = { ATOM_moov, ATOM_mdat, 0 };
         i_result = MP4_ReadBoxContainerChildren( p_stream, p_vroot, stoplist );
     }
 
     /* mdat appeared first */
-    if( i_result && !MP4_BoxGet( p_vroot, "moov" ) )
+    if( !b_tail && i_result && !MP4_BoxGet( p_vroot, "moov" ) )
     {
         bool b_seekable;
         if( vlc_stream_Control( p_stream, STREAM_CAN_SEEK, &b_seekable ) != VLC_SUCCESS || !b_seekable )
@@ -5081,7 +5185,8 @@ MP4_Box_t *MP4_BoxGetRoot( stream_t *p_stream )
         return p_vroot;
     }
 
-    if( vlc_stream_Tell( p_stream ) + 8 < (uint64_t) stream_Size( p_stream ) )
+    if( !b_tail &&
+        vlc_stream_Tell( p_stream ) + 8 < (uint64_t) stream_Size( p_stream ) )
     {
         /* Get the rest of the file */
         i_result = MP4_ReadBoxContainerChildren( p_stream, p_vroot, NULL );
@@ -40,25 +40,16 @@ typedef struct
     uint32_t     i_sample; /* index of the next sample to read in this chunk */
     uint32_t     i_virtual_run_number; /* chunks interleaving sequence */
 
-    /* now provide way to calculate pts, dts, and offset without too
-        much memory and with fast access */
-
-    /* with this we can calculate dts/pts without waste memory */
+    /* Timings are not expanded per chunk: the chunk only records where its
+       first sample is in the stts and ctts run-length tables, and sample
+       timings are computed on demand from the box data */
+    uint32_t     i_dts_run;     /* stts entry of the first sample */
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_duration;    /* total duration of all samples */
+    uint32_t     i_dts_skip;    /* samples of that stts entry in previous chunks */
 
-    uint32_t     i_entries_dts;
-    uint32_t     *p_sample_count_dts;
-    uint32_t     *p_sample_delta_dts;   /* dts delta */
-    uint32_t     small_dts_buf[4];
-
-    uint32_t     i_entries_pts;
-    uint32_t     *p_sample_count_pts;
-    uint32_t     *p_sample_offset_pts;  /* pts-dts */
-    uint32_t     small_pts_buf[4];
-
-    /* TODO if needed add pts
-        but quickly *add* support for edts and seeking */
+    uint32_t     i_pts_run;     /* ctts entry of the first sample */
+    uint32_t     i_pts_skip;    /* samples of that ctts entry in previous chunks */
 
 } mp4_chunk_t;
 
@@ -121,8 +112,12 @@ typedef struct
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-//                                    too much time to do sumations each time*/
+    const uint32_t   *p_sample_size; /* stsz box data */
+
+    /* sample to time tables, pointing to the boxes data */
+    const MP4_Box_data_stts_t *p_stts;
+    const MP4_Box_data_ctts_t *p_ctts; /* NULL if pts == dts */
+    int64_t          i_cts_shift;
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
@@ -35,6 +35,7 @@
 #include <vlc_access.h>    /* DVB-specific things */
 #include <vlc_demux.h>
 #include <vlc_input.h>
+#include <vlc_atomic.h>
 
 #include "ts_pid.h"
 #include "ts_streams.h"
@@ -196,6 +197,9 @@ static bool GatherSectionsData( demux_t *p_demux, ts_pid_t *, block_t *, size_t
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, vlc_tick_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static block_t* ReadTSPacketBatched( demux_t *p_demux );
+static void DropTSPacketBatch( demux_sys_t *p_sys );
+static uint64_t TSStreamTell( demux_sys_t *p_sys );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, int64_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, vlc_tick_t );
@@ -404,6 +408,8 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    p_sys->batch.i_count = 0;
+    p_sys->batch.i_next = 0;
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
 
@@ -586,6 +592,8 @@ static void Close( vlc_object_t *p_this )
 
     vlc_mutex_destroy( &p_sys->csa_lock );
 
+    DropTSPacketBatch( p_sys );
+
     /* Release all non default pids */
     ts_pid_list_Release( p_demux, &p_sys->pids );
 
@@ -639,7 +647,7 @@ static int Demux( demux_t *p_demux )
         bool         b_frame = false;
         int          i_header = 0;
         block_t     *p_pkt;
-        if( !(p_pkt = ReadTSPacket( p_demux )) )
+        if( !(p_pkt = ReadTSPacketBatched( p_demux )) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -947,7 +955,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TSStreamTell( p_sys );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -1795,6 +1803,136 @@ static block_t* ReadTSPacket( demux_t *p_demux )
     return p_pkt;
 }
 
+/*
+ * Batched reads: Demux() reads up to TS_READ_BATCH packets with a single
+ * stream read, instead of one vlc_stream_Block() per packet. The packets
+ * share the buffer of that read, which is freed with the last of them.
+ * Only for file-like streams: on live ones, waiting for a whole batch
+ * would delay every packet, PCR included.
+ */
+typedef struct ts_packet_batch_t ts_packet_batch_t;
+
+typedef struct
+{
+    block_t            self;
+    ts_packet_batch_t *p_batch;
+} ts_batch_packet_t;
+
+struct ts_packet_batch_t
+{
+    atomic_uint        i_refs;
+    block_t           *p_data;
+    ts_batch_packet_t  packets[TS_READ_BATCH];
+};
+
+static void BatchPacketRelease( block_t *p_pkt )
+{
+    ts_packet_batch_t *p_batch = ((ts_batch_packet_t *)p_pkt)->p_batch;
+
+    if( atomic_fetch_sub( &p_batch->i_refs, 1 ) == 1 )
+    {
+        block_Release( p_batch->p_data );
+        free( p_batch );
+    }
+}
+
+static bool ReadTSPacketBatch( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const size_t i_size = p_sys->i_packet_size;
+    const uint8_t *p_peek;
+
+    ssize_t i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
+                                      i_size * TS_READ_BATCH );
+    if( i_peek < (ssize_t)i_size )
+        return false;
+
+    /* Stop at the first lost sync, ReadTSPacket() will resync from there */
+    const unsigned i_max = i_peek / i_size;
+    unsigned i_count = 0;
+    while( i_count < i_max &&
+           p_peek[i_count * i_size + p_sys->i_packet_header_size] == 0x47 )
+        i_count++;
+    if( i_count == 0 )
+        return false;
+
+    ts_packet_batch_t *p_batch = malloc( sizeof(*p_batch) );
+    if( unlikely(p_batch == NULL) )
+        return false;
+
+    p_batch->p_data = vlc_stream_Block( p_sys->stream, i_count * i_size );
+    if( p_batch->p_data != NULL )
+        i_count = p_batch->p_data->i_buffer / i_size;
+    if( p_batch->p_data == NULL || i_count == 0 )
+    {
+        if( p_batch->p_data )
+            block_Release( p_batch->p_data );
+        free( p_batch );
+        return false;
+    }
+
+    atomic_init( &p_batch->i_refs, i_count );
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        block_t *p_pkt = &p_batch->packets[i].self;
+
+        block_Init( p_pkt, &p_batch->p_data->p_buffer[i * i_size], i_size );
+        p_pkt->pf_release = BatchPacketRelease;
+        p_batch->packets[i].p_batch = p_batch;
+
+        /* Skip header (BluRay streams), as ReadTSPacket() does */
+        p_pkt->p_buffer += p_sys->i_packet_header_size;
+        p_pkt->i_buffer -= p_sys->i_packet_header_size;
+
+        p_sys->batch.p[i] = p_pkt;
+    }
+    p_sys->batch.i_count = i_count;
+    p_sys->batch.i_next = 0;
+
+    return true;
+}
+
+static block_t* ReadTSPacketBatched( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->batch.i_next == p_sys->batch.i_count )
+    {
+        if( !p_sys->b_canfastseek || !ReadTSPacketBatch( p_demux ) )
+            return ReadTSPacket( p_demux );
+    }
+
+    return p_sys->batch.p[p_sys->batch.i_next++];
+}
+
+static void DropTSPacketBatch( demux_sys_t *p_sys )
+{
+    while( p_sys->batch.i_next < p_sys->batch.i_count )
+        block_Release( p_sys->batch.p[p_sys->batch.i_next++] );
+}
+
+/* Stream position of the next packet Demux() will process */
+static uint64_t TSStreamTell( demux_sys_t *p_sys )
+{
+    return vlc_stream_Tell( p_sys->stream ) - (uint64_t)p_sys->i_packet_size *
+           ( p_sys->batch.i_count - p_sys->batch.i_next );
+}
+
+/* Gives the packets read ahead back to the stream, so that they go through
+ * a stream filter inserted from now on */
+void TsRewindPacketBatch( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->batch.i_next == p_sys->batch.i_count )
+        return;
+
+    const uint64_t i_pos = TSStreamTell( p_sys );
+    DropTSPacketBatch( p_sys );
+    if( vlc_stream_Seek( p_sys->stream, i_pos ) != VLC_SUCCESS )
+        msg_Warn( p_demux, "cannot rewind to packet @%"PRIu64, i_pos );
+}
+
 static vlc_tick_t GetPCR( const block_t *p_pkt )
 {
     const uint8_t *p = p_pkt->p_buffer;
@@ -1867,6 +2005,8 @@ static void ReadyQueuesPostSeek( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    DropTSPacketBatch( p_sys );
+
     ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
     for( int i=0; i< p_pat->programs.i_size; i++ )
     {
@@ -2214,14 +2354,14 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TSStreamTell( p_sys ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TSStreamTell( p_sys );
             }
         }
     }
@@ -29,6 +29,9 @@ typedef struct csa_t csa_t;
 
 #define TS_PSI_PAT_PID 0x00
 
+/* how many TS packets Demux() reads ahead in a single stream read */
+#define TS_READ_BATCH 16
+
 typedef enum ts_standards_e
 {
     TS_STANDARD_AUTO = 0,
@@ -60,6 +63,14 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* packets read ahead by Demux(), not yet processed */
+    struct
+    {
+        block_t *p[TS_READ_BATCH];
+        unsigned i_count;
+        unsigned i_next;
+    } batch;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
@@ -138,6 +149,8 @@ bool ProgramIsSelected( demux_sys_t *, uint16_t i_pgrm );
 
 void UpdatePESFilters( demux_t *p_demux, bool b_all );
 
+void TsRewindPacketBatch( demux_t *p_demux );
+
 int ProbeStart( demux_t *p_demux, int i_program );
 int ProbeEnd( demux_t *p_demux, int i_program );
 
@@ -161,3 +161,69 @@ void ts_dvbpsi_DetachRawDecoder( dvbpsi_t *p_dvbpsi )
         dvbpsi_decoder_delete( p_dvbpsi->p_decoder );
     p_dvbpsi->p_decoder = NULL;
 }
+
+/* Direct mapped: a slot collision only lets a repetition through again */
+#define SECTIONS_CACHE_SIZE 2048
+
+typedef struct
+{
+    uint32_t i_crc;
+    uint16_t i_extension;
+    uint8_t  i_table_id;
+    uint8_t  i_number;
+    uint8_t  i_version;
+    bool     b_used;
+} ts_dvbpsi_sections_cache_entry_t;
+
+struct ts_dvbpsi_sections_cache_t
+{
+    ts_dvbpsi_sections_cache_entry_t entries[SECTIONS_CACHE_SIZE];
+};
+
+ts_dvbpsi_sections_cache_t * ts_dvbpsi_sections_cache_New( void )
+{
+    return calloc( 1, sizeof(ts_dvbpsi_sections_cache_t) );
+}
+
+void ts_dvbpsi_sections_cache_Delete( ts_dvbpsi_sections_cache_t *p_cache )
+{
+    free( p_cache );
+}
+
+void ts_dvbpsi_sections_cache_Reset( ts_dvbpsi_sections_cache_t *p_cache )
+{
+    memset( p_cache->entries, 0, sizeof(p_cache->entries) );
+}
+
+bool ts_dvbpsi_sections_cache_Seen( ts_dvbpsi_sections_cache_t *p_cache,
+                                    const dvbpsi_psi_section_t *p_section )
+{
+    /* Only long sections carry a version and a CRC */
+    if( !p_section->b_syntax_indicator || !p_section->b_current_next ||
+        p_section->i_length < 9 )
+        return false;
+
+    const uint32_t i_crc = GetDWBE( &p_section->p_data[3 + p_section->i_length - 4] );
+
+    const uint32_t i_hash = i_crc ^ ( p_section->i_extension * 0x9E3779B1U )
+                          ^ ( p_section->i_table_id << 8 ) ^ p_section->i_number;
+    ts_dvbpsi_sections_cache_entry_t *p_entry =
+            &p_cache->entries[i_hash % SECTIONS_CACHE_SIZE];
+
+    if( p_entry->b_used &&
+        p_entry->i_crc == i_crc &&
+        p_entry->i_extension == p_section->i_extension &&
+        p_entry->i_table_id == p_section->i_table_id &&
+        p_entry->i_number == p_section->i_number &&
+        p_entry->i_version == p_section->i_version )
+        return true;
+
+    p_entry->i_crc = i_crc;
+    p_entry->i_extension = p_section->i_extension;
+    p_entry->i_table_id = p_section->i_table_id;
+    p_entry->i_number = p_section->i_number;
+    p_entry->i_version = p_section->i_version;
+    p_entry->b_used = true;
+
+    return false;
+}
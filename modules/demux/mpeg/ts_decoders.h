@@ -36,4 +36,17 @@ bool ts_dvbpsi_AttachRawDecoder( dvbpsi_t* p_dvbpsi,
 
 void ts_dvbpsi_DetachRawDecoder( dvbpsi_t *p_dvbpsi );
 
+/* Sections already handed to the table decoders, keyed by table id,
+ * extension, version, section number and CRC. Unchanged repetitions can
+ * then be dropped before libdvbpsi processes them again. */
+typedef struct ts_dvbpsi_sections_cache_t ts_dvbpsi_sections_cache_t;
+
+ts_dvbpsi_sections_cache_t * ts_dvbpsi_sections_cache_New( void );
+void ts_dvbpsi_sections_cache_Delete( ts_dvbpsi_sections_cache_t * );
+void ts_dvbpsi_sections_cache_Reset( ts_dvbpsi_sections_cache_t * );
+
+/* returns true if the section was already seen, records it otherwise */
+bool ts_dvbpsi_sections_cache_Seen( ts_dvbpsi_sections_cache_t *,
+                                    const dvbpsi_psi_section_t *p_section );
+
 #endif
@@ -41,8 +41,10 @@ void ts_pid_list_Init( ts_pid_list_t *p_list )
     p_list->pp_all = NULL;
     p_list->i_all = 0;
     p_list->i_all_alloc = 0;
-    p_list->i_last_pid = 0;
-    p_list->p_last = NULL;
+    memset( p_list->pp_lookup, 0, sizeof(p_list->pp_lookup) );
+    p_list->pp_lookup[0] = &p_list->pat;
+    p_list->pp_lookup[0x1FFB] = &p_list->base_si;
+    p_list->pp_lookup[0x1FFF] = &p_list->dummy;
 }
 
 void ts_pid_list_Release( demux_t *p_demux, ts_pid_list_t *p_list )
@@ -79,22 +81,15 @@ static int ts_bsearch_searchkey_Compare( const void *key, const void *other )
 
 ts_pid_t * ts_pid_Get( ts_pid_list_t *p_list, uint16_t i_pid )
 {
-    switch( i_pid )
-    {
-        case 0:
-            return &p_list->pat;
-        case 0x1FFB:
-            return &p_list->base_si;
-        case 0x1FFF:
-            return &p_list->dummy;
-        default:
-            if( p_list->i_last_pid == i_pid )
-                return p_list->p_last;
-        break;
-    }
+    if( unlikely(i_pid > 0x1FFF) )
+        return &p_list->dummy;
+
+    ts_pid_t *p_pid = p_list->pp_lookup[i_pid];
+    if( likely(p_pid != NULL) )
+        return p_pid;
 
+    /* Not in the table: create it, keeping the list sorted */
     size_t i_index = 0;
-    ts_pid_t *p_pid = NULL;
 
     if( p_list->pp_all )
     {
@@ -151,8 +146,7 @@ ts_pid_t * ts_pid_Get( ts_pid_list_t *p_list, uint16_t i_pid )
 
     }
 
-    p_list->p_last = p_pid;
-    p_list->i_last_pid = i_pid;
+    p_list->pp_lookup[i_pid] = p_pid;
 
     return p_pid;
 }
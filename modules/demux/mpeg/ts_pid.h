@@ -91,9 +91,8 @@ struct ts_pid_list_t
     ts_pid_t **pp_all;
     int        i_all;
     int        i_all_alloc;
-    /* last recently used */
-    uint16_t   i_last_pid;
-    ts_pid_t  *p_last;
+    /* flat lookup table, indexed by pid */
+    ts_pid_t  *pp_lookup[8192];
 
 };
 
@@ -800,6 +800,26 @@ static void SINewTableCallBack( dvbpsi_t *h, uint8_t i_table_id,
     }
 }
 
+/* Drops the repetitions of already decoded sections, before the dvbpsi
+ * demux and table decoders (EIT schedules mostly) process them again */
+static void SIGatherSections( dvbpsi_t *h, dvbpsi_psi_section_t *p_section )
+{
+    dvbpsi_demux_t *p_dvbpsidemux = (dvbpsi_demux_t *) h->p_decoder;
+    ts_pid_t *p_pid = (ts_pid_t *) p_dvbpsidemux->p_new_cb_data;
+    ts_dvbpsi_sections_cache_t *p_cache = p_pid->u.p_si->p_sections_cache;
+
+    /* decoders will reset and need all sections again */
+    if( p_dvbpsidemux->b_discontinuity )
+        ts_dvbpsi_sections_cache_Reset( p_cache );
+    else if( ts_dvbpsi_sections_cache_Seen( p_cache, p_section ) )
+    {
+        dvbpsi_DeletePSISections( p_section );
+        return;
+    }
+
+    dvbpsi_Demux( h, p_section );
+}
+
 bool ts_attach_SI_Tables_Decoders( ts_pid_t *p_pid )
 {
     if( p_pid->type != TYPE_SI )
@@ -808,5 +828,10 @@ bool ts_attach_SI_Tables_Decoders( ts_pid_t *p_pid )
     if( dvbpsi_decoder_present( p_pid->u.p_si->handle ) )
         return true;
 
-    return dvbpsi_AttachDemux( p_pid->u.p_si->handle, SINewTableCallBack, p_pid );
+    if( !dvbpsi_AttachDemux( p_pid->u.p_si->handle, SINewTableCallBack, p_pid ) )
+        return false;
+
+    ts_dvbpsi_sections_cache_Reset( p_pid->u.p_si->p_sections_cache );
+    p_pid->u.p_si->handle->p_decoder->pf_gather = SIGatherSections;
+    return true;
 }
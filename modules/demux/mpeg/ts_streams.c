@@ -47,6 +47,7 @@
 #include "ts.h"
 
 #include "ts_psip.h"
+#include "ts_decoders.h"
 
 static inline bool handle_Init( demux_t *p_demux, dvbpsi_t **handle )
 {
@@ -328,6 +329,14 @@ ts_si_t *ts_si_New( demux_t *p_demux )
         return NULL;
     }
 
+    si->p_sections_cache = ts_dvbpsi_sections_cache_New();
+    if( !si->p_sections_cache )
+    {
+        dvbpsi_delete( si->handle );
+        free( si );
+        return NULL;
+    }
+
     si->i_version  = -1;
     si->eitpid = NULL;
     si->tdtpid = NULL;
@@ -341,6 +350,7 @@ void ts_si_Del( demux_t *p_demux, ts_si_t *si )
     if( dvbpsi_decoder_present( si->handle ) )
         dvbpsi_DetachDemux( si->handle );
     dvbpsi_delete( si->handle );
+    ts_dvbpsi_sections_cache_Delete( si->p_sections_cache );
     if( si->eitpid )
         PIDRelease( p_demux, si->eitpid );
     if( si->tdtpid )
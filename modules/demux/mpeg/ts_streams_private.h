@@ -146,6 +146,8 @@ struct ts_si_t
 {
     dvbpsi_t *handle;
     int       i_version;
+    /* sections already decoded, see ts_decoders.h */
+    struct ts_dvbpsi_sections_cache_t *p_sections_cache;
     /* Track successfully set pid */
     ts_pid_t *eitpid;
     ts_pid_t *tdtpid;
@@ -40,7 +40,7 @@ namespace smooth
                                   uint64_t, uint64_t);
                 virtual ~ForgedInitSegment();
                 virtual SegmentChunk* toChunk(SharedResources *, size_t,
-                                              BaseRepresentation *) override;
+                                              BaseRepresentation *, bool) override;
                 void setWaveFormatEx(const std::string &);
                 void setCodecPrivateData(const std::string &);
                 void setChannels(uint16_t);
@@ -53,6 +53,21 @@
     "\"Fast Start\" files are optimized for downloads and allow the user " \
     "to start previewing the file while it is downloading.")
 
+#define FRAGDURATION_TEXT N_("Fragment duration (ms)")
+#define FRAGDURATION_LONGTEXT N_(\
+    "Target duration of each movie fragment. Fragments are cut on the " \
+    "next keyframe boundary, and only one fragment is held in memory.")
+#define FRAGSIDX_TEXT N_("Write segment index")
+#define FRAGSIDX_LONGTEXT N_(\
+    "Prepend a \"sidx\" segment index box to each fragment so that it " \
+    "can be located and seeked without parsing the whole stream.")
+#define FRAGMFRA_TEXT N_("Write random access index")
+#define FRAGMFRA_LONGTEXT N_(\
+    "Append a \"mfra\" movie fragment random access box at the end of " \
+    "the file. Its index grows with the duration; disable it for endless " \
+    "recordings to keep memory usage constant. Never written when " \
+    "streaming.")
+
 static int  Open   (vlc_object_t *);
 static void Close  (vlc_object_t *);
 static int  OpenFrag   (vlc_object_t *);
@@ -80,6 +95,13 @@ add_submodule ()
     set_shortname("MP4 Frag")
     add_shortcut("mp4frag", "mp4stream")
     set_capability("sout mux", 0)
+    add_integer(SOUT_CFG_PREFIX "frag-duration", 1500,
+                FRAGDURATION_TEXT, FRAGDURATION_LONGTEXT, true)
+        change_integer_range(100, 60000)
+    add_bool(SOUT_CFG_PREFIX "frag-sidx", false,
+             FRAGSIDX_TEXT, FRAGSIDX_LONGTEXT, true)
+    add_bool(SOUT_CFG_PREFIX "frag-mfra", true,
+             FRAGMFRA_TEXT, FRAGMFRA_LONGTEXT, true)
     set_callbacks(OpenFrag, CloseFrag)
 
 vlc_module_end ()
@@ -88,7 +110,7 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "faststart", NULL
+    "faststart", "frag-duration", "frag-sidx", "frag-mfra", NULL
 };
 
 static int Control(sout_mux_t *, int, va_list);
@@ -172,6 +194,9 @@ struct sout_mux_sys_t
 
     /* mp4frag */
     bool           b_fragmented;
+    bool           b_frag_sidx;
+    bool           b_frag_mfra;
+    vlc_tick_t     i_fragment_length;
     vlc_tick_t     i_written_duration;
     uint32_t       i_mfhd_sequence;
 };
@@ -803,7 +828,8 @@ static void box_send(sout_mux_t *p_mux,  bo_t *box)
 /***************************************************************************
     MP4 Live submodule
 ****************************************************************************/
-#define FRAGMENT_LENGTH  (CLOCK_FREQ * 3/2)
+/* version 1 sidx with a single reference */
+#define FRAGMENT_SIDX_BOXSIZE 52
 
 #define ENQUEUE_ENTRY(object, entry) \
     do {\
@@ -1042,7 +1068,7 @@ static bo_t *GetMoofBox(sout_mux_t *p_mux, size_t *pi_mdat_total_size,
                 i_sample++;
 
                 /* Add keyframe entry if needed */
-                if (p_stream->b_hasiframes && (p_entry->p_block->i_flags & BLOCK_FLAG_TYPE_I) &&
+                if (p_sys->b_frag_mfra && p_stream->b_hasiframes && (p_entry->p_block->i_flags & BLOCK_FLAG_TYPE_I) &&
                     (p_stream->mux.fmt.i_cat == VIDEO_ES || p_stream->mux.fmt.i_cat == AUDIO_ES))
                 {
                     AddKeyframeEntry(p_stream, i_write_pos, i_trak, i_sample, i_time);
@@ -1115,6 +1141,61 @@ static void WriteFragmentMDAT(sout_mux_t *p_mux, size_t i_total_size)
     }
 }
 
+/* Creates the sidx box referencing the next moof+mdat pair.
+ * Must be called before the fragment samples are written, as it uses
+ * the towrite queue of the reference track. */
+static bo_t *GetSidxBox(sout_mux_t *p_mux, size_t i_moof_size, size_t i_mdat_size)
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    const mp4_stream_t *p_ref = NULL;
+
+    /* reference track is the first video track, or the first one */
+    for (unsigned int i = 0; i < p_sys->i_nb_streams; i++)
+    {
+        const mp4_stream_t *p_stream = p_sys->pp_streams[i];
+        if (!p_stream->towrite.p_first)
+            continue;
+        if (!p_ref || (p_stream->mux.fmt.i_cat == VIDEO_ES &&
+                       p_ref->mux.fmt.i_cat != VIDEO_ES))
+            p_ref = p_stream;
+    }
+    if (!p_ref)
+        return NULL;
+
+    vlc_tick_t i_duration = 0;
+    for (const mp4_fragentry_t *p_entry = p_ref->towrite.p_first;
+         p_entry; p_entry = p_entry->p_next)
+        i_duration += p_entry->p_block->i_length;
+
+    const block_t *p_first = p_ref->towrite.p_first->p_block;
+    const bool b_sap = !p_ref->b_hasiframes || (p_first->i_flags & BLOCK_FLAG_TYPE_I);
+    const uint64_t i_referenced_size = i_moof_size + 8 + i_mdat_size;
+    if (i_referenced_size >= (UINT64_C(1) << 31))
+        return NULL;
+
+    bo_t *sidx = box_full_new("sidx", 1, 0);
+    if (!sidx)
+        return NULL;
+    bo_add_32be(sidx, p_ref->mux.i_track_id);  // reference ID
+    bo_add_32be(sidx, p_ref->mux.i_timescale);
+    bo_add_64be(sidx, p_ref->i_written_duration * p_ref->mux.i_timescale / CLOCK_FREQ); // earliest pts
+    bo_add_64be(sidx, 0);                      // first offset, moof follows
+    bo_add_16be(sidx, 0);                      // reserved
+    bo_add_16be(sidx, 1);                      // reference count
+    bo_add_32be(sidx, i_referenced_size);      // reference type 0 (media) + size
+    bo_add_32be(sidx, i_duration * p_ref->mux.i_timescale / CLOCK_FREQ);
+    bo_add_32be(sidx, b_sap ? (1U << 31) | (1U << 28) : 0); // SAP type 1, no delta
+    if (!sidx->b)
+    {
+        bo_free(sidx);
+        return NULL;
+    }
+    box_fix(sidx, sidx->b->i_buffer);
+    assert(sidx->b->i_buffer == FRAGMENT_SIDX_BOXSIZE);
+
+    return sidx;
+}
+
 static bo_t *GetMfraBox(sout_mux_t *p_mux)
 {
     sout_mux_sys_t *p_sys = (sout_mux_sys_t*) p_mux->p_sys;
@@ -1226,6 +1307,19 @@ static int OpenFrag(vlc_object_t *p_this)
     p_sys->i_start_dts = VLC_TICK_INVALID;
     p_sys->i_mfhd_sequence = 1;
 
+    config_ChainParse(p_mux, SOUT_CFG_PREFIX, ppsz_sout_options, p_mux->p_cfg);
+    p_sys->i_fragment_length = var_InheritInteger(p_mux, SOUT_CFG_PREFIX "frag-duration")
+                             * (CLOCK_FREQ / 1000);
+    p_sys->b_frag_sidx = var_InheritBool(p_mux, SOUT_CFG_PREFIX "frag-sidx");
+    /* mfra refers to moof by absolute position, so only for non streamed content */
+    p_sys->b_frag_mfra = !strcmp(p_mux->psz_mux, "mp4frag") &&
+                         var_InheritBool(p_mux, SOUT_CFG_PREFIX "frag-mfra");
+
+    msg_Dbg(p_mux, "fragment duration %"PRId64" ms%s%s",
+            p_sys->i_fragment_length / (CLOCK_FREQ / 1000),
+            p_sys->b_frag_sidx ? ", sidx" : "",
+            p_sys->b_frag_mfra ? ", mfra" : "");
+
     return VLC_SUCCESS;
 }
 
@@ -1233,7 +1327,7 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
 {
     sout_mux_sys_t *p_sys = (sout_mux_sys_t*) p_mux->p_sys;
     bo_t *moof = NULL;
-    vlc_tick_t i_barrier_time = p_sys->i_written_duration + FRAGMENT_LENGTH;
+    vlc_tick_t i_barrier_time = p_sys->i_written_duration + p_sys->i_fragment_length;
     size_t i_mdat_size = 0;
     bool b_has_samples = false;
 
@@ -1268,8 +1362,11 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
     if (!p_sys->b_header_sent)
         FlushHeader(p_mux);
 
+    /* sidx has a fixed size and precedes the moof */
+    const uint64_t i_moof_pos = p_sys->i_pos +
+                                (p_sys->b_frag_sidx ? FRAGMENT_SIDX_BOXSIZE : 0);
     if (b_has_samples)
-        moof = GetMoofBox(p_mux, &i_mdat_size, (b_flush)?0:i_barrier_time, p_sys->i_pos);
+        moof = GetMoofBox(p_mux, &i_mdat_size, (b_flush)?0:i_barrier_time, i_moof_pos);
 
     if (moof && i_mdat_size == 0)
     {
@@ -1279,9 +1376,54 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
 
     if (moof)
     {
+        if (p_sys->b_frag_sidx)
+        {
+            bo_t *sidx = GetSidxBox(p_mux, moof->b->i_buffer, i_mdat_size);
+            if (sidx)
+            {
+                /* segment now starts on sidx for http sout */
+                sidx->b->i_flags |= BLOCK_FLAG_TYPE_I;
+                moof->b->i_flags &= ~BLOCK_FLAG_TYPE_I;
+                p_sys->i_pos += sidx->b->i_buffer;
+                box_send(p_mux, sidx);
+            }
+            else /* keep moof offsets consistent */
+            {
+                bo_t *skip = box_new("free");
+                while (skip && skip->b && skip->b->i_buffer < FRAGMENT_SIDX_BOXSIZE)
+                    bo_add_8(skip, 0);
+                if (skip && skip->b)
+                {
+                    box_fix(skip, skip->b->i_buffer);
+                    p_sys->i_pos += skip->b->i_buffer;
+                    box_send(p_mux, skip);
+                }
+                else
+                {
+                    /* no padding: move the index entries of this moof */
+                    msg_Warn(p_mux, "cannot pad the missing sidx");
+                    if (skip)
+                        bo_free(skip);
+                    for (unsigned int i = 0; i < p_sys->i_nb_streams; i++)
+                    {
+                        mp4_stream_t *p_stream = p_sys->pp_streams[i];
+                        for (unsigned int j = p_stream->i_indexentries; j > 0; j--)
+                        {
+                            mp4_fragindex_t *p_entry = &p_stream->p_indexentries[j - 1];
+                            if (p_entry->i_moofoffset != i_moof_pos)
+                                break;
+                            p_entry->i_moofoffset = p_sys->i_pos;
+                        }
+                    }
+                }
+            }
+        }
+        assert(p_sys->i_pos == i_moof_pos ||
+               p_sys->i_pos + FRAGMENT_SIDX_BOXSIZE == i_moof_pos);
+
         msg_Dbg(p_mux, "writing moof @ %"PRId64, p_sys->i_pos);
         p_sys->i_pos += moof->b->i_buffer;
-        assert(moof->b->i_flags & BLOCK_FLAG_TYPE_I); /* http sout */
+        assert(p_sys->b_frag_sidx || (moof->b->i_flags & BLOCK_FLAG_TYPE_I)); /* http sout */
         box_send(p_mux, moof);
         msg_Dbg(p_mux, "writing mdat @ %"PRId64, p_sys->i_pos);
         WriteFragmentMDAT(p_mux, i_mdat_size);
@@ -1380,7 +1522,7 @@ static void CloseFrag(vlc_object_t *p_this)
 
     /* Write indexes, but only for non streamed content
        as they refer to moof by absolute position */
-    if (!strcmp(p_mux->psz_mux, "mp4frag"))
+    if (p_sys->b_frag_mfra)
     {
         bo_t *mfra = GetMfraBox(p_mux);
         if (mfra)
@@ -1446,7 +1588,7 @@ static int MuxFrag(sout_mux_t *p_mux)
         p_stream->p_held_entry = NULL;
 
         if (p_stream->b_hasiframes && (p_heldblock->i_flags & BLOCK_FLAG_TYPE_I) &&
-            p_stream->mux.i_read_duration - p_sys->i_written_duration < FRAGMENT_LENGTH)
+            p_stream->mux.i_read_duration - p_sys->i_written_duration < p_sys->i_fragment_length)
         {
             /* Flag the last iframe time, we'll use it as boundary so it will start
                next fragment */
@@ -1495,7 +1637,8 @@ static int MuxFrag(sout_mux_t *p_mux)
     p_sys->i_written_duration = i_min_written_duration;
 
     /* we have prerolled enough to know all streams, and have enough date to create a fragment */
-    if (p_stream->read.p_first && p_sys->i_read_duration - p_sys->i_written_duration >= FRAGMENT_LENGTH)
+    if (p_stream->read.p_first &&
+        p_sys->i_read_duration - p_sys->i_written_duration >= p_sys->i_fragment_length)
         WriteFragments(p_mux, false);
 
     return VLC_SUCCESS;
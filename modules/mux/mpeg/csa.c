@@ -27,6 +27,9 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include <assert.h>
 
 #include "csa.h"
 
@@ -610,3 +613,125 @@ static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] )
     }
 }
 
+
+/*****************************************************************************
+ * Bitsliced stream cypher
+ *****************************************************************************/
+#define CSA_BS_WORDS  1
+#define CSA_BS_SUFFIX _64
+#define CSA_BS_TARGET
+#include "csa_bitslice.h"
+#undef CSA_BS_TARGET
+#undef CSA_BS_SUFFIX
+#undef CSA_BS_WORDS
+
+#if defined(CAN_COMPILE_SSE2)
+# define CSA_BS_WORDS  2
+# define CSA_BS_SUFFIX _SSE2
+# define CSA_BS_TARGET __attribute__ ((__target__ ("sse2")))
+# include "csa_bitslice.h"
+# undef CSA_BS_TARGET
+# undef CSA_BS_SUFFIX
+# undef CSA_BS_WORDS
+#endif
+
+#if defined(CAN_COMPILE_AVX2)
+# define CSA_BS_WORDS  4
+# define CSA_BS_SUFFIX _AVX2
+# define CSA_BS_TARGET __attribute__ ((__target__ ("avx2")))
+# include "csa_bitslice.h"
+# undef CSA_BS_TARGET
+# undef CSA_BS_SUFFIX
+# undef CSA_BS_WORDS
+#endif
+
+/* Below this, the bitsliced setup costs more than it saves */
+#define CSA_BATCH_MIN 8
+
+/*****************************************************************************
+ * csa_EncryptBatch: scramble several packets with the current key
+ *****************************************************************************
+ * The output is the same as csa_Encrypt() on each packet. The block cypher
+ * chain is done per packet, then the stream cypher runs on 64, 128 or 256
+ * packets at once depending on the CPU.
+ *****************************************************************************/
+void csa_EncryptBatch( csa_t *c, uint8_t **pp_pkt, int i_count, int i_pkt_size )
+{
+    void (*pf_stream)( const uint8_t *, uint8_t **, const int *, const int *,
+                       int, int ) = csa_BsStreamXor_64;
+    int i_lanes = 64;
+
+    if( i_count < CSA_BATCH_MIN )
+    {
+        for( int i = 0; i < i_count; i++ )
+            csa_Encrypt( c, pp_pkt[i], i_pkt_size );
+        return;
+    }
+
+#if defined(CAN_COMPILE_AVX2)
+    if( vlc_CPU_AVX2() )
+    {
+        pf_stream = csa_BsStreamXor_AVX2;
+        i_lanes = 256;
+    }
+    else
+#endif
+#if defined(CAN_COMPILE_SSE2)
+    if( vlc_CPU_SSE2() )
+    {
+        pf_stream = csa_BsStreamXor_SSE2;
+        i_lanes = 128;
+    }
+#endif
+
+    uint8_t *ck = c->use_odd ? c->o_ck : c->e_ck;
+    uint8_t *kk = c->use_odd ? c->o_kk : c->e_kk;
+
+    while( i_count > 0 )
+    {
+        const int i_batch = __MIN( i_count, i_lanes );
+        int pi_hdr[256], pi_blocks[256];
+
+        for( int l = 0; l < i_batch; l++ )
+        {
+            uint8_t *pkt = pp_pkt[l];
+
+            /* set transport scrambling control */
+            pkt[3] |= 0x80;
+            if( c->use_odd )
+                pkt[3] |= 0x40;
+
+            int i_hdr = 4;
+            if( pkt[3]&0x20 )
+            {
+                /* skip adaption field */
+                i_hdr += pkt[4] + 1;
+            }
+            const int n = (i_pkt_size - i_hdr) / 8;
+
+            pi_hdr[l] = i_hdr;
+            pi_blocks[l] = n;
+            if( n <= 0 )
+            {
+                pkt[3] &= 0x3f;
+                continue;
+            }
+
+            /* block cypher chain, from the end, each block being replaced
+             * by its cyphered value */
+            for( int i = n; i > 0; i-- )
+            {
+                uint8_t block[8];
+                uint8_t *p = &pkt[i_hdr+8*(i-1)];
+                for( int j = 0; j < 8; j++ )
+                    block[j] = p[j] ^ ( i < n ? p[8+j] : 0 );
+                csa_BlockCypher( kk, block, p );
+            }
+        }
+
+        pf_stream( ck, pp_pkt, pi_hdr, pi_blocks, i_batch, i_pkt_size );
+
+        pp_pkt += i_batch;
+        i_count -= i_batch;
+    }
+}
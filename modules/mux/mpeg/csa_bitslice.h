@@ -0,0 +1,276 @@
+/*****************************************************************************
+ * csa_bitslice.h: bitsliced CSA stream cypher template
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * This file is included by csa.c once per word size, with:
+ *  CSA_BS_WORDS  number of 64 bits words in a slice (1, 2 or 4)
+ *  CSA_BS_SUFFIX name suffix of the generated functions
+ *  CSA_BS_TARGET function attributes (instruction set)
+ *
+ * Each bit of a slice holds the state of the cypher for one packet, so that
+ * CSA_BS_WORDS * 64 packets are processed at once using only logic
+ * operations. The s-boxes are evaluated as multiplexer trees.
+ */
+
+#define CSA_BS_CAT_(a,b) a##b
+#define CSA_BS_CAT(a,b)  CSA_BS_CAT_(a,b)
+#define CSA_BS(name)     CSA_BS_CAT(name, CSA_BS_SUFFIX)
+#define CSA_BS_LANES     (CSA_BS_WORDS * 64)
+
+typedef uint64_t CSA_BS(csa_slice_t) __attribute__ ((vector_size (CSA_BS_WORDS * 8)));
+
+/* 5 bits in, 2 bits out s-box lookup, in[0] being the most significant bit */
+CSA_BS_TARGET
+static inline void CSA_BS(csa_BsSbox)( const int sbox[0x20],
+                                       const CSA_BS(csa_slice_t) in[5],
+                                       CSA_BS(csa_slice_t) out[2] )
+{
+    const CSA_BS(csa_slice_t) zero = { 0 };
+    const CSA_BS(csa_slice_t) ones = ~zero;
+
+    for( int o = 0; o < 2; o++ )
+    {
+        CSA_BS(csa_slice_t) t[16];
+
+        for( int k = 0; k < 16; k++ )
+        {
+            const int c0 = ( sbox[2*k+0] >> o )&1;
+            const int c1 = ( sbox[2*k+1] >> o )&1;
+            if( c0 == c1 )
+                t[k] = c0 ? ones : zero;
+            else
+                t[k] = c1 ? in[4] : ~in[4];
+        }
+        for( int l = 3, n = 8; l >= 0; l--, n /= 2 )
+        {
+            for( int k = 0; k < n; k++ )
+                t[k] = t[2*k] ^ ( ( t[2*k] ^ t[2*k+1] ) & in[l] );
+        }
+        out[o] = t[0];
+    }
+}
+
+struct CSA_BS(csa_bs_state)
+{
+    CSA_BS(csa_slice_t) A[11][4];
+    CSA_BS(csa_slice_t) B[11][4];
+    CSA_BS(csa_slice_t) X[4], Y[4], Z[4];
+    CSA_BS(csa_slice_t) D[4], E[4], F[4];
+    CSA_BS(csa_slice_t) p, q, r;
+};
+
+/* Runs 4 iterations of the cypher, producing one byte per lane as 8 slices
+ * (msb first). During init, sb holds the 8 slices of the input byte. */
+CSA_BS_TARGET
+static void CSA_BS(csa_BsStreamByte)( struct CSA_BS(csa_bs_state) *s,
+                                      const CSA_BS(csa_slice_t) *sb,
+                                      CSA_BS(csa_slice_t) cb[8] )
+{
+    for( int j = 0; j < 4; j++ )
+    {
+        CSA_BS(csa_slice_t) in[5], s1[2], s2[2], s3[2], s4[2], s5[2], s6[2], s7[2];
+
+#define SBOX(n, a0,b0, a1,b1, a2,b2, a3,b3, a4,b4) \
+        in[0] = s->A[a0][b0]; in[1] = s->A[a1][b1]; in[2] = s->A[a2][b2]; \
+        in[3] = s->A[a3][b3]; in[4] = s->A[a4][b4]; \
+        CSA_BS(csa_BsSbox)( sbox##n, in, s##n )
+
+        SBOX(1, 4,0, 1,2, 6,1, 7,3, 9,0);
+        SBOX(2, 2,1, 3,2, 6,3, 7,0, 9,1);
+        SBOX(3, 1,3, 2,0, 5,1, 5,3, 6,2);
+        SBOX(4, 3,3, 1,1, 2,3, 4,2, 8,0);
+        SBOX(5, 5,2, 4,3, 6,0, 8,1, 9,2);
+        SBOX(6, 3,1, 4,1, 5,0, 7,2, 9,3);
+        SBOX(7, 2,2, 3,0, 7,1, 8,2, 8,3);
+#undef SBOX
+
+        /* 4x4 xor to produce extra nibble for T3 */
+        CSA_BS(csa_slice_t) extra_B[4];
+        extra_B[3] = s->B[3][0] ^ s->B[6][1] ^ s->B[7][2] ^ s->B[9][3];
+        extra_B[2] = s->B[6][0] ^ s->B[8][1] ^ s->B[3][3] ^ s->B[4][2];
+        extra_B[1] = s->B[5][3] ^ s->B[8][2] ^ s->B[4][0] ^ s->B[5][1];
+        extra_B[0] = s->B[9][2] ^ s->B[6][3] ^ s->B[3][1] ^ s->B[8][0];
+
+        /* T1 and T2, the input nibbles are only used during init */
+        CSA_BS(csa_slice_t) next_A1[4], next_B1[4];
+        for( int b = 0; b < 4; b++ )
+        {
+            next_A1[b] = s->A[10][b] ^ s->X[b];
+            next_B1[b] = s->B[7][b] ^ s->B[10][b] ^ s->Y[b];
+            if( sb )
+            {
+                /* in1 is the high nibble, in2 the low one */
+                const CSA_BS(csa_slice_t) in1 = sb[3-b], in2 = sb[7-b];
+                next_A1[b] ^= s->D[b] ^ ( (j % 2) ? in2 : in1 );
+                next_B1[b] ^= (j % 2) ? in1 : in2;
+            }
+        }
+
+        /* if p=1, rotate left */
+        const CSA_BS(csa_slice_t) b3 = next_B1[3];
+        for( int b = 3; b > 0; b-- )
+            next_B1[b] ^= ( next_B1[b] ^ next_B1[b-1] ) & s->p;
+        next_B1[0] ^= ( next_B1[0] ^ b3 ) & s->p;
+
+        /* T3 */
+        for( int b = 0; b < 4; b++ )
+            s->D[b] = s->E[b] ^ s->Z[b] ^ extra_B[b];
+
+        /* T4 = sum, carry of Z + E + r if q=1 */
+        CSA_BS(csa_slice_t) carry = s->r;
+        for( int b = 0; b < 4; b++ )
+        {
+            const CSA_BS(csa_slice_t) next_E = s->F[b];
+            const CSA_BS(csa_slice_t) half = s->Z[b] ^ s->E[b];
+            const CSA_BS(csa_slice_t) sum = half ^ carry;
+            carry = ( s->Z[b] & s->E[b] ) | ( carry & half );
+            s->F[b] = s->E[b] ^ ( ( s->E[b] ^ sum ) & s->q );
+            s->E[b] = next_E;
+        }
+        s->r ^= ( s->r ^ carry ) & s->q;
+
+        memmove( &s->A[2], &s->A[1], 9 * sizeof(s->A[1]) );
+        memmove( &s->B[2], &s->B[1], 9 * sizeof(s->B[1]) );
+        memcpy( s->A[1], next_A1, sizeof(next_A1) );
+        memcpy( s->B[1], next_B1, sizeof(next_B1) );
+
+        s->X[3] = s4[0]; s->X[2] = s3[0]; s->X[1] = s2[1]; s->X[0] = s1[1];
+        s->Y[3] = s6[0]; s->Y[2] = s5[0]; s->Y[1] = s4[1]; s->Y[0] = s3[1];
+        s->Z[3] = s2[0]; s->Z[2] = s1[0]; s->Z[1] = s6[1]; s->Z[0] = s5[1];
+        s->p = s7[1];
+        s->q = s7[0];
+
+        /* 2 output bits are a function of the 4 bits of D */
+        cb[2*j+0] = s->D[2] ^ s->D[3];
+        cb[2*j+1] = s->D[0] ^ s->D[1];
+    }
+}
+
+/* Xors the stream cypher output into up to CSA_BS_LANES packets. Packet i
+ * has i_blocks[i] full blocks from i_hdr[i], the first one being the stream
+ * cypher init input, and a residue up to i_pkt_size. */
+CSA_BS_TARGET
+static void CSA_BS(csa_BsStreamXor)( const uint8_t ck[8], uint8_t **pp_pkt,
+                                     const int *pi_hdr, const int *pi_blocks,
+                                     int i_count, int i_pkt_size )
+{
+    const CSA_BS(csa_slice_t) zero = { 0 };
+    const CSA_BS(csa_slice_t) ones = ~zero;
+    struct CSA_BS(csa_bs_state) s;
+    CSA_BS(csa_slice_t) slices[8][8];
+    uint64_t lanes[CSA_BS_WORDS];
+    int i_steps = 0;
+
+    assert( i_count <= CSA_BS_LANES );
+
+    /* the key is common to all lanes */
+    for( int i = 0; i < 4; i++ )
+    {
+        for( int b = 0; b < 4; b++ )
+        {
+            s.A[1+2*i+0][b] = ( ck[i]   >> (4+b) )&1 ? ones : zero;
+            s.A[1+2*i+1][b] = ( ck[i]   >> b     )&1 ? ones : zero;
+            s.B[1+2*i+0][b] = ( ck[4+i] >> (4+b) )&1 ? ones : zero;
+            s.B[1+2*i+1][b] = ( ck[4+i] >> b     )&1 ? ones : zero;
+        }
+    }
+    for( int b = 0; b < 4; b++ )
+    {
+        s.A[9][b] = s.A[10][b] = zero;
+        s.B[9][b] = s.B[10][b] = zero;
+        s.X[b] = s.Y[b] = s.Z[b] = zero;
+        s.D[b] = s.E[b] = s.F[b] = zero;
+    }
+    s.p = s.q = s.r = zero;
+
+    /* transpose the first block of each packet, msb first */
+    for( int i = 0; i < 8; i++ )
+    {
+        for( int b = 0; b < 8; b++ )
+        {
+            memset( lanes, 0, sizeof(lanes) );
+            for( int l = 0; l < i_count; l++ )
+            {
+                if( pi_blocks[l] <= 0 )
+                    continue;
+                const uint64_t bit = ( pp_pkt[l][pi_hdr[l] + i] >> (7-b) )&1;
+                lanes[l/64] |= bit << (l%64);
+            }
+            memcpy( &slices[i][b], lanes, sizeof(lanes) );
+        }
+    }
+    for( int l = 0; l < i_count; l++ )
+    {
+        int i_residue = (i_pkt_size - pi_hdr[l]) % 8;
+        if( pi_blocks[l] > 0 && pi_blocks[l] - 1 + (i_residue > 0) > i_steps )
+            i_steps = pi_blocks[l] - 1 + (i_residue > 0);
+    }
+
+    /* init */
+    for( int i = 0; i < 8; i++ )
+    {
+        CSA_BS(csa_slice_t) unused[8];
+        CSA_BS(csa_BsStreamByte)( &s, slices[i], unused );
+    }
+
+    /* generate and apply, one 8 bytes block per lane and step */
+    for( int k = 0; k < i_steps; k++ )
+    {
+        uint64_t stream[8][8][CSA_BS_WORDS];
+
+        for( int i = 0; i < 8; i++ )
+            CSA_BS(csa_BsStreamByte)( &s, NULL, slices[i] );
+        memcpy( stream, slices, sizeof(stream) );
+
+        for( int l = 0; l < i_count; l++ )
+        {
+            const int i_hdr = pi_hdr[l];
+            const int n = pi_blocks[l];
+            int i_len;
+            uint8_t *p;
+
+            if( k + 1 < n )
+            {
+                p = &pp_pkt[l][i_hdr + 8*(k+1)];
+                i_len = 8;
+            }
+            else if( k + 1 == n && n > 0 )
+            {
+                i_len = (i_pkt_size - i_hdr) % 8;
+                p = &pp_pkt[l][i_pkt_size - i_len];
+            }
+            else
+                continue;
+
+            for( int i = 0; i < i_len; i++ )
+            {
+                uint8_t byte = 0;
+                for( int b = 0; b < 8; b++ )
+                    byte |= ( ( stream[i][b][l/64] >> (l%64) )&1 ) << (7-b);
+                p[i] ^= byte;
+            }
+        }
+    }
+}
+
+#undef CSA_BS_LANES
+#undef CSA_BS
+#undef CSA_BS_CAT
+#undef CSA_BS_CAT_
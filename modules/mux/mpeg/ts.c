@@ -153,6 +153,19 @@ static const char *const ts_standards_list_text[] =
   "PCRs (Program Clock Reference) will be sent (in milliseconds). " \
   "This value should be below 100ms. (default is 70ms).")
 
+#define MUXRATE_TEXT N_("Constant mux rate (bits/s)")
+#define MUXRATE_LONGTEXT N_("If non-zero, packets are scheduled one at a " \
+  "time on a virtual transmit clock running at this rate, padding with " \
+  "null packets. This produces a constant bitrate stream with bounded PCR " \
+  "intervals and a latency of about one frame instead of the shaping " \
+  "delay, which is then ignored.")
+
+#define CBR_PSI_INTERVAL   (CLOCK_FREQ / 10)
+#define CBR_MAX_GAP        (CLOCK_FREQ)
+/* At least 8 packets per PSI interval, so that tables and PCR leave room
+ * for the payload */
+#define CBR_MIN_MUXRATE    (8 * 188 * 8 * CLOCK_FREQ / CBR_PSI_INTERVAL)
+
 #define BMIN_TEXT N_( "Minimum B (deprecated)")
 #define BMIN_LONGTEXT N_( "This setting is deprecated and not used anymore" )
 
@@ -226,6 +239,8 @@ vlc_module_begin ()
     add_bool(SOUT_CFG_PREFIX "use-key-frames", false, KEYF_TEXT, KEYF_LONGTEXT, true)
 
     add_integer( SOUT_CFG_PREFIX "pcr", 70, PCR_TEXT, PCR_LONGTEXT, true)
+    add_integer( SOUT_CFG_PREFIX "muxrate", 0, MUXRATE_TEXT, MUXRATE_LONGTEXT, true)
+        change_integer_range( 0, INT_MAX )
     add_integer( SOUT_CFG_PREFIX "bmin", 0, BMIN_TEXT, BMIN_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "bmax", 0, BMAX_TEXT, BMAX_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "dts-delay", 400, DTS_TEXT, DTS_LONGTEXT, true)
@@ -247,7 +262,7 @@ static const char *const ppsz_sout_options[] = {
     "standard",
     "pid-video", "pid-audio", "pid-spu", "pid-pmt", "tsid",
     "netid", "sdtdesc",
-    "es-id-pid", "shaping", "pcr", "bmin", "bmax", "use-key-frames",
+    "es-id-pid", "shaping", "pcr", "muxrate", "bmin", "bmax", "use-key-frames",
     "dts-delay", "csa-ck", "csa2-ck", "csa-use", "csa-pkt", "crypt-audio", "crypt-video",
     "muxpmt", "program-pmt", "alignment",
     NULL
@@ -381,6 +396,14 @@ struct sout_mux_sys_t
 
     vlc_tick_t      i_pcr;  /* last PCR emitted */
 
+    /* constant mux rate scheduling */
+    int64_t         i_muxrate;
+    vlc_tick_t      i_tx_start; /* virtual transmit clock origin */
+    uint64_t        i_tx_packets;
+    vlc_tick_t      i_psi_next;
+    bool            b_psi_previous;
+    bool            b_tx_late;
+
     csa_t           *csa;
     int             i_csa_pkt_size;
     bool            b_crypt_audio;
@@ -477,6 +500,9 @@ static void TSSchedule  ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
                           vlc_tick_t i_pcr_length, vlc_tick_t i_pcr_dts );
 static void TSDate      ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
                           vlc_tick_t i_pcr_length, vlc_tick_t i_pcr_dts );
+static void TSWrite     ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+                          vlc_tick_t i_latency );
+static void TSScheduleCBR( sout_mux_t *p_mux, vlc_tick_t i_max_dts );
 static void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 
@@ -545,6 +571,14 @@ static int Open( vlc_object_t *p_this )
 
     config_ChainParse( p_mux, SOUT_CFG_PREFIX, ppsz_sout_options, p_mux->p_cfg );
 
+    const int64_t i_muxrate = var_GetInteger( p_mux, SOUT_CFG_PREFIX "muxrate" );
+    if( i_muxrate > 0 && i_muxrate < CBR_MIN_MUXRATE )
+    {
+        msg_Err( p_mux, "mux rate %"PRId64" bits/s is too low (minimum %d)",
+                 i_muxrate, (int) CBR_MIN_MUXRATE );
+        return VLC_EGENERIC;
+    }
+
     p_sys = calloc( 1, sizeof( sout_mux_sys_t ) );
     if( !p_sys )
         return VLC_ENOMEM;
@@ -733,6 +767,11 @@ static int Open( vlc_object_t *p_this )
     msg_Dbg( p_mux, "shaping=%"PRId64" pcr=%"PRId64" dts_delay=%"PRId64,
              p_sys->i_shaping_delay, p_sys->i_pcr_delay, p_sys->i_dts_delay );
 
+    p_sys->i_muxrate = i_muxrate;
+    p_sys->i_tx_start = VLC_TICK_INVALID;
+    if( p_sys->i_muxrate > 0 )
+        msg_Dbg( p_mux, "constant mux rate %"PRId64" bits/s", p_sys->i_muxrate );
+
     p_sys->b_use_key_frames = var_GetBool( p_mux, SOUT_CFG_PREFIX "use-key-frames" );
 
     p_mux->p_sys        = p_sys;
@@ -1202,6 +1241,10 @@ static bool MuxStreams(sout_mux_t *p_mux )
         ? p_pcr_stream->state.i_pes_length
         : p_sys->i_shaping_delay;
 
+    /* The CBR scheduler does the shaping, only take one PES at a time */
+    if( p_sys->i_muxrate > 0 )
+        i_shaping_delay = 1;
+
     bool b_ok = true;
 
     /* Accumulate enough data in the pcr stream (>i_shaping_delay) */
@@ -1442,7 +1485,8 @@ static bool MuxStreams(sout_mux_t *p_mux )
 
         BufferChainAppend( &p_stream->state.chain_pes, p_data );
 
-        if( p_sys->b_use_key_frames && p_stream == p_pcr_stream
+        if( p_sys->b_use_key_frames && p_sys->i_muxrate == 0
+            && p_stream == p_pcr_stream
             && (p_data->i_flags & BLOCK_FLAG_TYPE_I)
             && !(p_data->i_flags & BLOCK_FLAG_NO_KEYFRAME)
             && (p_stream->state.i_pes_length > 400000) )
@@ -1456,6 +1500,12 @@ static bool MuxStreams(sout_mux_t *p_mux )
     const vlc_tick_t i_pcr_length = p_pcr_stream->state.i_pes_length;
     p_pcr_stream->state.b_key_frame = 0;
 
+    if( p_sys->i_muxrate > 0 )
+    {
+        TSScheduleCBR( p_mux, p_pcr_stream->state.i_pes_dts + i_pcr_length );
+        return false;
+    }
+
     /* msg_Dbg( p_mux, "starting muxing %lldms", i_pcr_length / 1000 ); */
     /* 2: calculate non accurate total size of muxed ts */
     int i_packet_count = 0;
@@ -1788,14 +1838,31 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     }
 
     /* msg_Dbg( p_mux, "real pck=%d", i_packet_count ); */
-    for (int i = 0; i < i_packet_count; i++ )
+    block_t *p_ts = BufferChainPeek( p_chain_ts );
+    for (int i = 0; i < i_packet_count; i++, p_ts = p_ts->p_next )
     {
-        block_t *p_ts = BufferChainGet( p_chain_ts );
         vlc_tick_t i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
 
         p_ts->i_dts    = i_new_dts;
         p_ts->i_length = i_pcr_length / i_packet_count;
+    }
+
+    TSWrite( p_mux, p_chain_ts, p_sys->i_shaping_delay * 3 / 2 );
+}
 
+/* Sets the PCRs, scrambles and sends a chain of dated TS packets */
+static void TSWrite( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+                     vlc_tick_t i_latency )
+{
+    sout_mux_sys_t  *p_sys = p_mux->p_sys;
+    uint8_t **pp_scrambled = NULL;
+    int i_scrambled = 0;
+
+    if( p_sys->csa != NULL && p_chain_ts->i_depth > 0 )
+        pp_scrambled = vlc_alloc( p_chain_ts->i_depth, sizeof(*pp_scrambled) );
+
+    for( block_t *p_ts = BufferChainPeek( p_chain_ts ); p_ts; p_ts = p_ts->p_next )
+    {
         if( p_ts->i_flags & BLOCK_FLAG_CLOCK )
         {
             /* msg_Dbg( p_mux, "pcr=%lld ms", p_ts->i_dts / 1000 ); */
@@ -1803,18 +1870,242 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         }
         if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
         {
-            vlc_mutex_lock( &p_sys->csa_lock );
-            csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
-            vlc_mutex_unlock( &p_sys->csa_lock );
+            if( likely(pp_scrambled) )
+                pp_scrambled[i_scrambled++] = p_ts->p_buffer;
+            else
+            {
+                vlc_mutex_lock( &p_sys->csa_lock );
+                csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
+                vlc_mutex_unlock( &p_sys->csa_lock );
+            }
         }
+    }
+
+    /* scramble all packets at once */
+    if( i_scrambled > 0 )
+    {
+        vlc_mutex_lock( &p_sys->csa_lock );
+        csa_EncryptBatch( p_sys->csa, pp_scrambled, i_scrambled,
+                          p_sys->i_csa_pkt_size );
+        vlc_mutex_unlock( &p_sys->csa_lock );
+    }
+    free( pp_scrambled );
 
+    block_t *p_ts;
+    while( ( p_ts = BufferChainGet( p_chain_ts ) ) )
+    {
         /* latency */
-        p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
+        p_ts->i_dts += i_latency;
 
         sout_AccessOutWrite( p_mux->p_access, p_ts );
     }
 }
 
+/*****************************************************************************
+ * Constant mux rate scheduling
+ *****************************************************************************
+ * Packets are sent one by one on a virtual transmit clock advancing by one
+ * packet duration at the mux rate. Each slot carries, by priority, the PSI
+ * tables, a PCR when the interval is due, the pending packet with the lowest
+ * dts if it is due, or a null packet. Data is only sent up to the most
+ * recent dts, so the latency is about one frame.
+ *****************************************************************************/
+static vlc_tick_t TSTxClock( const sout_mux_sys_t *p_sys )
+{
+    const uint64_t i_bits = p_sys->i_tx_packets * 188 * 8;
+    return p_sys->i_tx_start +
+           CLOCK_FREQ * (i_bits / p_sys->i_muxrate) +
+           CLOCK_FREQ * (i_bits % p_sys->i_muxrate) / p_sys->i_muxrate;
+}
+
+static void TSSendCBR( sout_mux_t *p_mux, sout_buffer_chain_t *c, block_t *p_ts )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+
+    p_ts->i_dts    = TSTxClock( p_sys );
+    p_ts->i_length = CLOCK_FREQ * 188 * 8 / p_sys->i_muxrate;
+    p_sys->i_tx_packets++;
+
+    BufferChainAppend( c, p_ts );
+}
+
+static block_t *TSNewNull( void )
+{
+    block_t *p_ts = block_Alloc( 188 );
+    if( likely(p_ts) )
+    {
+        p_ts->p_buffer[0] = 0x47;
+        p_ts->p_buffer[1] = 0x1f;
+        p_ts->p_buffer[2] = 0xff;
+        p_ts->p_buffer[3] = 0x10;
+        memset( &p_ts->p_buffer[4], 0xff, 184 );
+    }
+    return p_ts;
+}
+
+/* PCR carried in an adaptation field only packet, for when the PCR stream
+ * has no data due */
+static block_t *TSNewPCR( sout_input_sys_t *p_stream )
+{
+    block_t *p_ts = block_Alloc( 188 );
+    if( likely(p_ts) )
+    {
+        p_ts->p_buffer[0] = 0x47;
+        p_ts->p_buffer[1] = ( p_stream->ts.i_pid >> 8 ) & 0x1f;
+        p_ts->p_buffer[2] = p_stream->ts.i_pid & 0xff;
+        /* no payload, continuity counter is not incremented */
+        p_ts->p_buffer[3] = 0x20 | ( ( p_stream->ts.i_continuity_counter + 15 ) % 16 );
+        p_ts->p_buffer[4] = 183;
+        p_ts->p_buffer[5] = 1 << 4; /* PCR_flag */
+        memset( &p_ts->p_buffer[12], 0xff, 188 - 12 );
+        p_ts->i_flags |= BLOCK_FLAG_CLOCK;
+    }
+    return p_ts;
+}
+
+static void TSSendPSICBR( sout_mux_t *p_mux, sout_buffer_chain_t *c, bool b_header )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    sout_buffer_chain_t chain_ts;
+
+    BufferChainInit( &chain_ts );
+    GetPAT( p_mux, &chain_ts );
+    GetPMT( p_mux, &chain_ts );
+    if( b_header && chain_ts.i_depth )
+        SetHeader( &chain_ts, 0 );
+
+    block_t *p_ts;
+    while( ( p_ts = BufferChainGet( &chain_ts ) ) )
+        TSSendCBR( p_mux, c, p_ts );
+
+    p_sys->i_psi_next = TSTxClock( p_sys ) + CBR_PSI_INTERVAL;
+}
+
+static void TSScheduleCBR( sout_mux_t *p_mux, vlc_tick_t i_max_dts )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    sout_input_sys_t *p_pcr_stream = (sout_input_sys_t*)p_sys->p_pcr_input->p_sys;
+    sout_buffer_chain_t chain_ts;
+
+    /* Tables and PCR sent since the last payload or null packet: catching
+     * up on them never takes more than a slot each in a row */
+    unsigned i_overhead = 0;
+
+    BufferChainInit( &chain_ts );
+
+    for (;;)
+    {
+        sout_input_t *p_input = NULL;
+        vlc_tick_t    i_dts = 0;
+
+        /* Select stream (lowest dts) */
+        for (int i = 0; i < p_mux->i_nb_inputs; i++ )
+        {
+            sout_input_sys_t *p_stream = (sout_input_sys_t*)p_mux->pp_inputs[i]->p_sys;
+
+            if( p_stream->state.i_pes_dts == 0 )
+                continue;
+
+            if( p_input == NULL || p_stream->state.i_pes_dts < i_dts )
+            {
+                p_input = p_mux->pp_inputs[i];
+                i_dts = p_stream->state.i_pes_dts;
+            }
+        }
+        if( p_input == NULL || i_dts > i_max_dts )
+            break;
+
+        if( p_sys->i_tx_start == VLC_TICK_INVALID ||
+            i_dts - TSTxClock( p_sys ) > CBR_MAX_GAP )
+        {
+            if( p_sys->i_tx_start != VLC_TICK_INVALID )
+                msg_Warn( p_mux, "resetting transmit clock (gap %"PRId64" us)",
+                          i_dts - TSTxClock( p_sys ) );
+            p_sys->i_tx_start = i_dts;
+            p_sys->i_tx_packets = 0;
+            p_sys->i_psi_next = i_dts;
+            p_sys->i_pcr = i_dts - p_sys->i_pcr_delay;
+        }
+
+        const vlc_tick_t i_tx = TSTxClock( p_sys );
+        sout_input_sys_t *p_stream = (sout_input_sys_t*)p_input->p_sys;
+
+        /* PAT/PMT, periodically or before every keyframe if use-key-frames
+         * is enabled to allow segmenting */
+        const block_t *p_pes = p_stream->state.chain_pes.p_first;
+        const bool b_key_frame = p_sys->b_use_key_frames &&
+            p_input->p_fmt->i_cat == VIDEO_ES && i_dts <= i_tx &&
+            p_stream->state.i_pes_used <= 0 &&
+            (p_pes->i_flags & BLOCK_FLAG_TYPE_I) &&
+            !(p_pes->i_flags & BLOCK_FLAG_NO_KEYFRAME);
+        if( i_overhead < 1 &&
+            ( i_tx >= p_sys->i_psi_next || ( b_key_frame && !p_sys->b_psi_previous ) ) )
+        {
+            TSSendPSICBR( p_mux, &chain_ts, b_key_frame );
+            p_sys->b_psi_previous = b_key_frame;
+            i_overhead++;
+            continue;
+        }
+
+        /* PCR */
+        if( i_overhead < 2 && i_tx >= p_sys->i_pcr + p_sys->i_pcr_delay )
+        {
+            block_t *p_ts;
+            if( p_pcr_stream->state.i_pes_dts != 0 &&
+                p_pcr_stream->state.i_pes_dts <= i_tx )
+            {
+                p_ts = TSNew( p_mux, p_pcr_stream, true );
+                if( p_sys->csa != NULL &&
+                    (p_sys->p_pcr_input->p_fmt->i_cat != AUDIO_ES || p_sys->b_crypt_audio) &&
+                    (p_sys->p_pcr_input->p_fmt->i_cat != VIDEO_ES || p_sys->b_crypt_video) )
+                    p_ts->i_flags |= BLOCK_FLAG_SCRAMBLED;
+                p_sys->b_psi_previous = false;
+            }
+            else
+                p_ts = TSNewPCR( p_pcr_stream );
+            if( unlikely(p_ts == NULL) )
+                break;
+            p_sys->i_pcr = i_tx;
+            TSSendCBR( p_mux, &chain_ts, p_ts );
+            i_overhead = 2;
+            continue;
+        }
+        i_overhead = 0;
+
+        /* Nothing due yet, pad */
+        if( i_dts > i_tx )
+        {
+            block_t *p_null = TSNewNull();
+            if( unlikely(p_null == NULL) )
+                break;
+            TSSendCBR( p_mux, &chain_ts, p_null );
+            continue;
+        }
+
+        if( i_tx - i_dts > p_sys->i_dts_delay )
+        {
+            if( !p_sys->b_tx_late )
+                msg_Warn( p_mux, "mux rate too low, packets are %"PRId64" us late",
+                          i_tx - i_dts );
+            p_sys->b_tx_late = true;
+        }
+        else
+            p_sys->b_tx_late = false;
+
+        block_t *p_ts = TSNew( p_mux, p_stream, false );
+        if( p_sys->csa != NULL &&
+             (p_input->p_fmt->i_cat != AUDIO_ES || p_sys->b_crypt_audio) &&
+             (p_input->p_fmt->i_cat != VIDEO_ES || p_sys->b_crypt_video) )
+        {
+            p_ts->i_flags |= BLOCK_FLAG_SCRAMBLED;
+        }
+        p_sys->b_psi_previous = false;
+        TSSendCBR( p_mux, &chain_ts, p_ts );
+    }
+
+    TSWrite( p_mux, &chain_ts, 0 );
+}
+
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
                        bool b_pcr )
 {
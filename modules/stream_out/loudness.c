@@ -0,0 +1,419 @@
+/*****************************************************************************
+ * loudness.c: EBU R 128 loudness measurement stream output
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_sout.h>
+#include <vlc_block.h>
+#include <vlc_aout.h>
+
+#include <ebur128.h>
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+#define INTERVAL_TEXT N_("Update interval")
+#define INTERVAL_LONGTEXT N_( \
+    "Audio duration between two updates of the loudness variables, in " \
+    "milliseconds." )
+#define QUEUE_TEXT N_("Maximum queue")
+#define QUEUE_LONGTEXT N_( \
+    "Maximum duration of audio waiting to be measured, in milliseconds. " \
+    "Audio beyond that is passed through without being measured, rather " \
+    "than stalling the stream." )
+
+static int  Open    ( vlc_object_t * );
+static void Close   ( vlc_object_t * );
+
+#define SOUT_CFG_PREFIX "sout-loudness-"
+
+vlc_module_begin()
+    set_shortname( N_("Loudness"))
+    set_description( N_("EBU R 128 loudness measurement stream output"))
+    set_capability( "sout stream", 0 )
+    add_shortcut( "loudness" )
+    set_category( CAT_SOUT )
+    set_subcategory( SUBCAT_SOUT_STREAM )
+    set_callbacks( Open, Close )
+    add_integer( SOUT_CFG_PREFIX "interval", 1000, INTERVAL_TEXT,
+                 INTERVAL_LONGTEXT, true )
+        change_integer_range( 100, 60000 )
+    add_integer( SOUT_CFG_PREFIX "queue", 10000, QUEUE_TEXT,
+                 QUEUE_LONGTEXT, true )
+        change_integer_range( 100, 600000 )
+vlc_module_end()
+
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static const char *ppsz_sout_options[] = {
+    "interval", "queue", NULL
+};
+
+static sout_stream_id_sys_t *Add( sout_stream_t *, const es_format_t * );
+static void               Del   ( sout_stream_t *, sout_stream_id_sys_t * );
+static int               Send  ( sout_stream_t *, sout_stream_id_sys_t *, block_t * );
+
+struct sout_stream_sys_t
+{
+    vlc_tick_t i_interval;
+    vlc_tick_t i_queue;
+    /* Only one audio track is measured */
+    sout_stream_id_sys_t *measured;
+};
+
+struct sout_stream_id_sys_t
+{
+    void *next_id;
+
+    /* Measurement, NULL if the track is not measured */
+    ebur128_state *state;
+    vlc_fifo_t *fifo;
+    vlc_thread_t thread;
+    bool b_eos; /* protected by the FIFO lock */
+
+    vlc_fourcc_t i_codec;
+    unsigned i_rate;
+    size_t i_frame_size;
+    size_t i_max_bytes;
+    uint64_t i_interval_frames;
+    uint64_t i_dropped_frames;
+
+    /* Owned by the thread until it is joined */
+    uint64_t i_frames;
+    uint64_t i_next_update;
+};
+
+/*****************************************************************************
+ * Open:
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    sout_stream_t     *p_stream = (sout_stream_t*)p_this;
+    sout_stream_sys_t *p_sys;
+
+    p_sys = calloc( 1, sizeof( sout_stream_sys_t ) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+
+    config_ChainParse( p_stream, SOUT_CFG_PREFIX, ppsz_sout_options,
+                   p_stream->p_cfg );
+
+    p_sys->i_interval = 1000 * var_InheritInteger( p_stream,
+                                                   SOUT_CFG_PREFIX "interval" );
+    p_sys->i_queue = 1000 * var_InheritInteger( p_stream,
+                                                SOUT_CFG_PREFIX "queue" );
+
+    /* Results, in LUFS, updated while the audio is measured */
+    var_Create( p_stream, "loudness-momentary", VLC_VAR_FLOAT );
+    var_Create( p_stream, "loudness-shortterm", VLC_VAR_FLOAT );
+    var_Create( p_stream, "loudness-integrated", VLC_VAR_FLOAT );
+
+    p_stream->p_sys     = p_sys;
+
+    p_stream->pf_add    = Add;
+    p_stream->pf_del    = Del;
+    p_stream->pf_send   = Send;
+
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Close:
+ *****************************************************************************/
+static void Close( vlc_object_t * p_this )
+{
+    sout_stream_t     *p_stream = (sout_stream_t*)p_this;
+    sout_stream_sys_t *p_sys = (sout_stream_sys_t *)p_stream->p_sys;
+
+    var_Destroy( p_stream, "loudness-integrated" );
+    var_Destroy( p_stream, "loudness-shortterm" );
+    var_Destroy( p_stream, "loudness-momentary" );
+    free( p_sys );
+}
+
+/*****************************************************************************
+ * Measurement thread
+ *****************************************************************************/
+static int SetChannels( ebur128_state *state, uint32_t i_physical_channels )
+{
+    unsigned i_channel = 0;
+
+    if( i_physical_channels == 0 )
+        return EBUR128_SUCCESS; /* keep the library defaults */
+
+    for( unsigned i = 0; pi_vlc_chan_order_wg4[i]; i++ )
+    {
+        const uint32_t chan = pi_vlc_chan_order_wg4[i];
+        int value;
+
+        if( !( i_physical_channels & chan ) )
+            continue;
+
+        switch( chan )
+        {
+            case AOUT_CHAN_LEFT:        value = EBUR128_LEFT; break;
+            case AOUT_CHAN_RIGHT:       value = EBUR128_RIGHT; break;
+            case AOUT_CHAN_CENTER:      value = EBUR128_CENTER; break;
+            case AOUT_CHAN_MIDDLELEFT:
+            case AOUT_CHAN_REARLEFT:
+            case AOUT_CHAN_REARCENTER:  value = EBUR128_LEFT_SURROUND; break;
+            case AOUT_CHAN_MIDDLERIGHT:
+            case AOUT_CHAN_REARRIGHT:   value = EBUR128_RIGHT_SURROUND; break;
+            default:                    value = EBUR128_UNUSED; break;
+        }
+
+        int error = ebur128_set_channel( state, i_channel++, value );
+        if( error != EBUR128_SUCCESS )
+            return error;
+    }
+    return EBUR128_SUCCESS;
+}
+
+static int AddFrames( sout_stream_id_sys_t *id, const block_t *p_block,
+                      size_t i_frames )
+{
+    switch( id->i_codec )
+    {
+        case VLC_CODEC_S16N:
+            return ebur128_add_frames_short( id->state,
+                                    (const short *)p_block->p_buffer, i_frames );
+        case VLC_CODEC_S32N:
+            return ebur128_add_frames_int( id->state,
+                                    (const int *)p_block->p_buffer, i_frames );
+        case VLC_CODEC_FL32:
+            return ebur128_add_frames_float( id->state,
+                                    (const float *)p_block->p_buffer, i_frames );
+        case VLC_CODEC_FL64:
+            return ebur128_add_frames_double( id->state,
+                                    (const double *)p_block->p_buffer, i_frames );
+        default:
+            vlc_assert_unreachable();
+    }
+}
+
+static void Update( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+{
+    double momentary, shortterm, integrated;
+
+    if( ebur128_loudness_momentary( id->state, &momentary ) == EBUR128_SUCCESS )
+        var_SetFloat( p_stream, "loudness-momentary", momentary );
+    if( ebur128_loudness_shortterm( id->state, &shortterm ) == EBUR128_SUCCESS )
+        var_SetFloat( p_stream, "loudness-shortterm", shortterm );
+    if( ebur128_loudness_global( id->state, &integrated ) == EBUR128_SUCCESS )
+        var_SetFloat( p_stream, "loudness-integrated", integrated );
+}
+
+static void *Thread( void *data )
+{
+    sout_stream_t *p_stream = data;
+    sout_stream_id_sys_t *id = p_stream->p_sys->measured;
+    vlc_fifo_t *fifo = id->fifo;
+
+    for( ;; )
+    {
+        vlc_fifo_Lock( fifo );
+        while( vlc_fifo_IsEmpty( fifo ) && !id->b_eos )
+            vlc_fifo_Wait( fifo );
+        block_t *p_block = vlc_fifo_DequeueAllUnlocked( fifo );
+        vlc_fifo_Unlock( fifo );
+
+        if( p_block == NULL )
+            break; /* end of stream, and everything is measured */
+
+        while( p_block != NULL )
+        {
+            block_t *p_next = p_block->p_next;
+            size_t i_frames = p_block->i_buffer / id->i_frame_size;
+
+            int error = AddFrames( id, p_block, i_frames );
+            if( error != EBUR128_SUCCESS )
+                msg_Warn( p_stream, "cannot measure loudness (error %d)",
+                          error );
+            id->i_frames += i_frames;
+
+            if( id->i_frames >= id->i_next_update )
+            {
+                Update( p_stream, id );
+                id->i_next_update = id->i_frames + id->i_interval_frames;
+            }
+            block_Release( p_block );
+            p_block = p_next;
+        }
+    }
+
+    Update( p_stream, id );
+    return NULL;
+}
+
+/*****************************************************************************
+ * Add/Del/Send:
+ *****************************************************************************/
+static int StartMeasure( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                         const es_format_t *p_fmt )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const unsigned i_channels = p_fmt->audio.i_channels;
+    const unsigned i_rate = p_fmt->audio.i_rate;
+
+    switch( p_fmt->i_codec )
+    {
+        case VLC_CODEC_S16N:
+        case VLC_CODEC_S32N:
+        case VLC_CODEC_FL32:
+        case VLC_CODEC_FL64:
+            break;
+        default:
+            msg_Dbg( p_stream, "cannot measure %4.4s audio, need decoded "
+                     "samples", (const char *)&p_fmt->i_codec );
+            return VLC_EGENERIC;
+    }
+    if( i_channels == 0 || i_rate == 0 )
+        return VLC_EGENERIC;
+
+    id->state = ebur128_init( i_channels, i_rate,
+                              EBUR128_MODE_S | EBUR128_MODE_I );
+    if( id->state == NULL )
+        return VLC_ENOMEM;
+    if( SetChannels( id->state, p_fmt->audio.i_physical_channels ) )
+        goto error;
+
+    id->fifo = block_FifoNew();
+    if( id->fifo == NULL )
+        goto error;
+
+    id->b_eos = false;
+    id->i_codec = p_fmt->i_codec;
+    id->i_rate = i_rate;
+    id->i_frame_size = i_channels * aout_BitsPerSample( p_fmt->i_codec ) / 8;
+    id->i_max_bytes = p_sys->i_queue * i_rate / CLOCK_FREQ * id->i_frame_size;
+    id->i_interval_frames = p_sys->i_interval * i_rate / CLOCK_FREQ;
+    id->i_next_update = id->i_interval_frames;
+    id->i_frames = 0;
+    id->i_dropped_frames = 0;
+
+    p_sys->measured = id;
+    if( vlc_clone( &id->thread, Thread, p_stream, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        p_sys->measured = NULL;
+        block_FifoRelease( id->fifo );
+        goto error;
+    }
+
+    msg_Dbg( p_stream, "measuring loudness of track %d, %u Hz, %u channels",
+             p_fmt->i_id, i_rate, i_channels );
+    return VLC_SUCCESS;
+
+error:
+    ebur128_destroy( &id->state );
+    return VLC_EGENERIC;
+}
+
+static sout_stream_id_sys_t * Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
+{
+    sout_stream_sys_t *p_sys = (sout_stream_sys_t *)p_stream->p_sys;
+    sout_stream_id_sys_t *id;
+
+    id = malloc( sizeof( sout_stream_id_sys_t ) );
+    if( unlikely( !id ) )
+        return NULL;
+
+    id->state = NULL;
+    id->next_id = NULL;
+
+    if( p_fmt->i_cat == AUDIO_ES && p_sys->measured == NULL )
+        StartMeasure( p_stream, id, p_fmt );
+
+    if( p_stream->p_next )
+        id->next_id = sout_StreamIdAdd( p_stream->p_next, p_fmt );
+
+    return id;
+}
+
+static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+{
+    sout_stream_sys_t *p_sys = (sout_stream_sys_t *)p_stream->p_sys;
+
+    if( id->state != NULL )
+    {
+        /* Let the thread measure what is queued, then stop */
+        vlc_fifo_Lock( id->fifo );
+        id->b_eos = true;
+        vlc_fifo_Signal( id->fifo );
+        vlc_fifo_Unlock( id->fifo );
+        vlc_join( id->thread, NULL );
+
+        double integrated;
+        if( ebur128_loudness_global( id->state, &integrated ) == EBUR128_SUCCESS )
+            msg_Info( p_stream, "integrated loudness: %.1f LUFS over %.1f s",
+                      integrated, (double)id->i_frames / id->i_rate );
+        if( id->i_dropped_frames > 0 )
+            msg_Warn( p_stream, "%.1f s of audio were not measured",
+                      (double)id->i_dropped_frames / id->i_rate );
+
+        block_FifoRelease( id->fifo );
+        ebur128_destroy( &id->state );
+        p_sys->measured = NULL;
+    }
+
+    if( id->next_id ) sout_StreamIdDel( p_stream->p_next, id->next_id );
+    free( id );
+}
+
+static int Send( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                 block_t *p_buffer )
+{
+    if( id->state != NULL )
+    {
+        /* Queue copies: the original blocks go on downstream right away */
+        vlc_fifo_Lock( id->fifo );
+        for( block_t *p_block = p_buffer; p_block; p_block = p_block->p_next )
+        {
+            if( vlc_fifo_GetBytes( id->fifo ) + p_block->i_buffer
+                                                        > id->i_max_bytes )
+            {
+                if( id->i_dropped_frames == 0 )
+                    msg_Warn( p_stream, "loudness measurement is too slow, "
+                              "skipping audio" );
+                id->i_dropped_frames += p_block->i_buffer / id->i_frame_size;
+                continue;
+            }
+
+            block_t *p_copy = block_Duplicate( p_block );
+            if( likely( p_copy != NULL ) )
+                vlc_fifo_QueueUnlocked( id->fifo, p_copy );
+        }
+        vlc_fifo_Unlock( id->fifo );
+    }
+
+    if( p_stream->p_next )
+        return sout_StreamIdSend( p_stream->p_next, id->next_id, p_buffer );
+    else
+        block_ChainRelease( p_buffer );
+    return VLC_SUCCESS;
+}
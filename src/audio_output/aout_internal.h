@@ -44,6 +44,7 @@ struct aout_request_vout
 };
 
 typedef struct aout_volume aout_volume_t;
+typedef struct aout_filters_cache aout_filters_cache_t;
 typedef struct aout_dev aout_dev_t;
 
 typedef struct
@@ -51,6 +52,7 @@ typedef struct
     vlc_mutex_t lock;
     module_t *module; /**< Output plugin (or NULL if inactive) */
     aout_filters_t *filters;
+    aout_filters_cache_t *filters_cache;
     aout_volume_t *volume;
 
     struct
@@ -179,6 +181,16 @@ static inline void aout_SetWavePhysicalChannels(audio_sample_format_t *fmt)
 
 /* From filters.c */
 bool aout_FiltersCanResample (aout_filters_t *filters);
+aout_filters_cache_t *aout_FiltersCacheNew (void);
+void aout_FiltersCacheDelete (vlc_object_t *, aout_filters_cache_t *);
+#define aout_FiltersCacheDelete(o, c) \
+        aout_FiltersCacheDelete(VLC_OBJECT(o), c)
+aout_filters_t *aout_FiltersNewCached (audio_output_t *,
+                                       const audio_sample_format_t *,
+                                       const audio_sample_format_t *,
+                                       const aout_request_vout_t *,
+                                       const aout_filters_cfg_t *,
+                                       aout_filters_cache_t *);
 
 void aout_ChangeViewpoint(audio_output_t *aout,
                           const vlc_viewpoint_t *p_viewpoint);
@@ -93,9 +93,11 @@ int aout_DecNew( audio_output_t *p_aout,
     aout_volume_SetFormat (owner->volume, owner->mixer_format.i_format);
 
     /* Create the audio filtering "input" pipeline */
-    owner->filters = aout_FiltersNew (p_aout, p_format, &owner->mixer_format,
-                                      &owner->request_vout,
-                                      &owner->filters_cfg);
+    owner->filters = aout_FiltersNewCached (p_aout, p_format,
+                                            &owner->mixer_format,
+                                            &owner->request_vout,
+                                            &owner->filters_cfg,
+                                            owner->filters_cache);
     if (owner->filters == NULL)
     {
         aout_OutputDelete (p_aout);
@@ -173,10 +175,11 @@ static int aout_CheckReady (audio_output_t *aout)
 
         if (owner->mixer_format.i_format)
         {
-            owner->filters = aout_FiltersNew (aout, &owner->input_format,
-                                              &owner->mixer_format,
-                                              &owner->request_vout,
-                                              &owner->filters_cfg);
+            owner->filters = aout_FiltersNewCached (aout, &owner->input_format,
+                                                    &owner->mixer_format,
+                                                    &owner->request_vout,
+                                                    &owner->filters_cfg,
+                                                    owner->filters_cache);
             if (owner->filters == NULL)
             {
                 aout_OutputDelete (aout);
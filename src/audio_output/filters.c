@@ -89,37 +89,216 @@ static filter_t *CreateFilter (vlc_object_t *obj, const char *type,
     return filter;
 }
 
+/* Conversion filters (converters, renderers and resamplers) do not depend
+ * on anything but their formats. Rather than destroying them with the chain
+ * that used them, they are flushed and kept, so that a later chain with the
+ * same conversions skips the modules probing. */
+#define AOUT_CACHE_MAX 16
+
+typedef struct
+{
+    filter_t *filter;
+    const char *type;
+    const char *name;
+    audio_sample_format_t infmt;
+    audio_sample_format_t outfmt;
+    bool headphones;
+    bool busy; /**< In use by a filters chain */
+} aout_cached_filter_t;
+
+struct aout_filters_cache
+{
+    unsigned count;
+    aout_cached_filter_t tab[AOUT_CACHE_MAX];
+    unsigned hits; /**< Filters reused */
+    unsigned misses; /**< Filters created */
+};
+
+aout_filters_cache_t *aout_FiltersCacheNew (void)
+{
+    aout_filters_cache_t *cache = malloc (sizeof (*cache));
+    if (likely(cache != NULL))
+    {
+        cache->count = 0;
+        cache->hits = 0;
+        cache->misses = 0;
+    }
+    return cache;
+}
+
+static void aout_FiltersCacheRemove (aout_filters_cache_t *cache, unsigned i)
+{
+    filter_t *filter = cache->tab[i].filter;
+
+    assert (!cache->tab[i].busy);
+    module_unneed (filter, filter->p_module);
+    vlc_object_release (filter);
+
+    cache->count--;
+    memmove (&cache->tab[i], &cache->tab[i + 1],
+             (cache->count - i) * sizeof (cache->tab[0]));
+}
+
+#undef aout_FiltersCacheDelete
+void aout_FiltersCacheDelete (vlc_object_t *obj, aout_filters_cache_t *cache)
+{
+    if (cache == NULL)
+        return;
+
+    msg_Dbg (obj, "conversion filters: %u reused, %u created",
+             cache->hits, cache->misses);
+    while (cache->count > 0)
+        aout_FiltersCacheRemove (cache, cache->count - 1);
+    free (cache);
+}
+
+static filter_t *CacheGet (aout_filters_cache_t *cache, const char *type,
+                           const char *name,
+                           const audio_sample_format_t *infmt,
+                           const audio_sample_format_t *outfmt,
+                           bool headphones)
+{
+    for (unsigned i = 0; i < cache->count; i++)
+    {
+        aout_cached_filter_t *entry = &cache->tab[i];
+
+        if (entry->busy || entry->headphones != headphones
+         || strcmp (entry->type, type)
+         || (entry->name != name && (entry->name == NULL || name == NULL
+                                  || strcmp (entry->name, name)))
+         || !AOUT_FMTS_IDENTICAL (&entry->infmt, infmt)
+         || !AOUT_FMTS_IDENTICAL (&entry->outfmt, outfmt))
+            continue;
+
+        entry->busy = true;
+        cache->hits++;
+        return entry->filter;
+    }
+    return NULL;
+}
+
+static void CachePut (aout_filters_cache_t *cache, filter_t *filter,
+                      const char *type, const char *name, bool headphones)
+{
+    if (cache->count == AOUT_CACHE_MAX)
+    {   /* Evict the oldest unused filter, if any */
+        unsigned i = 0;
+
+        while (i < cache->count && cache->tab[i].busy)
+            i++;
+        if (i == cache->count)
+            return; /* not cached, destroyed after use */
+        aout_FiltersCacheRemove (cache, i);
+    }
+
+    aout_cached_filter_t *entry = &cache->tab[cache->count++];
+
+    entry->filter = filter;
+    entry->type = type;
+    entry->name = name;
+    entry->infmt = filter->fmt_in.audio;
+    entry->outfmt = filter->fmt_out.audio;
+    entry->headphones = headphones;
+    entry->busy = true;
+}
+
+/**
+ * Gives a filter back to the cache.
+ * \return false if the filter is not cached and must be destroyed
+ */
+static bool CacheRelease (aout_filters_cache_t *cache, filter_t *filter)
+{
+    for (unsigned i = 0; i < cache->count; i++)
+    {
+        aout_cached_filter_t *entry = &cache->tab[i];
+
+        if (entry->filter != filter)
+            continue;
+
+        assert (entry->busy);
+        /* Reset the filter state, and its formats that may have been
+         * overridden for rate control. */
+        filter_Flush (filter);
+        filter->fmt_in.audio = entry->infmt;
+        filter->fmt_out.audio = entry->outfmt;
+        entry->busy = false;
+        return true;
+    }
+    return false;
+}
+
+static filter_t *CreateConverter (vlc_object_t *obj,
+                                  aout_filters_cache_t *cache,
+                                  const char *type, const char *name,
+                                  const audio_sample_format_t *infmt,
+                                  const audio_sample_format_t *outfmt,
+                                  bool headphones)
+{
+    filter_t *filter;
+
+    if (cache != NULL)
+    {
+        filter = CacheGet (cache, type, name, infmt, outfmt, headphones);
+        if (filter != NULL)
+        {
+            msg_Dbg (obj, "reusing %s %p", type, (void *)filter);
+            return filter;
+        }
+    }
+
+    config_chain_t *cfg = NULL;
+    if (headphones)
+        config_ChainParseOptions(&cfg, "{headphones=true}");
+    filter = CreateFilter (obj, type, name, NULL, infmt, outfmt, cfg, true);
+    if (cfg)
+        config_ChainDestroy(cfg);
+
+    if (filter != NULL && cache != NULL)
+    {
+        cache->misses++;
+        CachePut (cache, filter, type, name, headphones);
+    }
+    return filter;
+}
+
 static filter_t *FindConverter (vlc_object_t *obj,
+                                aout_filters_cache_t *cache,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
-    return CreateFilter (obj, "audio converter", NULL, NULL, infmt, outfmt,
-                         NULL, true);
+    return CreateConverter (obj, cache, "audio converter", NULL,
+                            infmt, outfmt, false);
 }
 
 static filter_t *FindResampler (vlc_object_t *obj,
+                                aout_filters_cache_t *cache,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
-    return CreateFilter (obj, "audio resampler", "$audio-resampler", NULL,
-                         infmt, outfmt, NULL, true);
+    return CreateConverter (obj, cache, "audio resampler", "$audio-resampler",
+                            infmt, outfmt, false);
 }
 
 /**
  * Destroys a chain of audio filters.
  */
-static void aout_FiltersPipelineDestroy(filter_t *const *filters, unsigned n)
+static void aout_FiltersPipelineDestroy(aout_filters_cache_t *cache,
+                                        filter_t *const *filters, unsigned n)
 {
     for( unsigned i = 0; i < n; i++ )
     {
         filter_t *p_filter = filters[i];
 
+        if( cache != NULL && CacheRelease( cache, p_filter ) )
+            continue;
+
         module_unneed( p_filter, p_filter->p_module );
         vlc_object_release( p_filter );
     }
 }
 
-static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
+static filter_t *TryFormat (vlc_object_t *obj, aout_filters_cache_t *cache,
+                            vlc_fourcc_t codec,
                             audio_sample_format_t *restrict fmt)
 {
     audio_sample_format_t output = *fmt;
@@ -128,7 +307,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
     output.i_format = codec;
     aout_FormatPrepare (&output);
 
-    filter_t *filter = FindConverter (obj, fmt, &output);
+    filter_t *filter = FindConverter (obj, cache, fmt, &output);
     if (filter != NULL)
         *fmt = output;
     return filter;
@@ -137,6 +316,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
 /**
  * Allocates audio format conversion filters
  * @param obj parent VLC object for new filters
+ * @param cache conversion filters cache, or NULL
  * @param filters table of filters [IN/OUT]
  * @param count pointer to the number of filters in the table [IN/OUT]
  * @param max size of filters table [IN]
@@ -144,7 +324,9 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
  * @param outfmt output audio format
  * @return 0 on success, -1 on failure
  */
-static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
+static int aout_FiltersPipelineCreate(vlc_object_t *obj,
+                                      aout_filters_cache_t *cache,
+                                      filter_t **filters,
                                       unsigned *count, unsigned max,
                                  const audio_sample_format_t *restrict infmt,
                                  const audio_sample_format_t *restrict outfmt,
@@ -176,7 +358,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
             if (n == max)
                 goto overflow;
 
-            filter_t *f = TryFormat (obj, VLC_CODEC_FL32, &input);
+            filter_t *f = TryFormat (obj, cache, VLC_CODEC_FL32, &input);
             if (f == NULL)
             {
                 msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -202,13 +384,8 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
             infmt->channel_type != outfmt->channel_type ?
             "audio renderer" : "audio converter";
 
-        config_chain_t *cfg = NULL;
-        if (headphones)
-            config_ChainParseOptions(&cfg, "{headphones=true}");
-        filter_t *f = CreateFilter (obj, filter_type, NULL, NULL,
-                                    &input, &output, cfg, true);
-        if (cfg)
-            config_ChainDestroy(cfg);
+        filter_t *f = CreateConverter (obj, cache, filter_type, NULL,
+                                       &input, &output, headphones);
 
         if (f == NULL)
         {
@@ -230,7 +407,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         audio_sample_format_t output = input;
         output.i_rate = outfmt->i_rate;
 
-        filter_t *f = FindConverter (obj, &input, &output);
+        filter_t *f = FindConverter (obj, cache, &input, &output);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -248,7 +425,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         if (max == 0)
             goto overflow;
 
-        filter_t *f = TryFormat (obj, outfmt->i_format, &input);
+        filter_t *f = TryFormat (obj, cache, outfmt->i_format, &input);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -267,7 +444,7 @@ overflow:
     vlc_dialog_display_error (obj, _("Audio filtering failed"),
         _("The maximum number of filters (%u) was reached."), max);
 error:
-    aout_FiltersPipelineDestroy (filters, n);
+    aout_FiltersPipelineDestroy (cache, filters, n);
     return -1;
 }
 
@@ -343,6 +520,7 @@ static void aout_FiltersPipelineChangeViewpoint(filter_t *const *filters,
 
 struct aout_filters
 {
+    aout_filters_cache_t *cache; /**< Conversion filters cache (or NULL) */
     filter_t *rate_filter; /**< The filter adjusting samples count
         (either the scaletempo filter or a resampler) */
     filter_t *resampler; /**< The resampler */
@@ -419,8 +597,9 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
     }
 
     /* convert to the filter input format if necessary */
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                                    max - 1, infmt, &filter->fmt_in.audio, false))
+    if (aout_FiltersPipelineCreate (obj, filters->cache, filters->tab,
+                                    &filters->count, max - 1, infmt,
+                                    &filter->fmt_in.audio, false))
     {
         msg_Err (filter, "cannot add user %s \"%s\" (skipped)", type, name);
         module_unneed (filter, filter->p_module);
@@ -481,6 +660,13 @@ static int AppendRemapFilter(vlc_object_t *obj, aout_filters_t *restrict filters
     return ret;
 }
 
+static aout_filters_t *FiltersNew (vlc_object_t *obj,
+                                   const audio_sample_format_t *restrict infmt,
+                                   const audio_sample_format_t *restrict outfmt,
+                                   const aout_request_vout_t *request_vout,
+                                   const aout_filters_cfg_t *cfg,
+                                   aout_filters_cache_t *cache);
+
 #undef aout_FiltersNew
 /**
  * Sets a chain of audio filters up.
@@ -502,11 +688,39 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
                                  const audio_sample_format_t *restrict outfmt,
                                  const aout_request_vout_t *request_vout,
                                  const aout_filters_cfg_t *cfg)
+{
+    return FiltersNew (obj, infmt, outfmt, request_vout, cfg, NULL);
+}
+
+/**
+ * Sets a chain of audio filters up, reusing the conversion filters of
+ * previously deleted chains.
+ * The cache must be used with the output lock held and deleted after all
+ * the chains using it.
+ */
+aout_filters_t *aout_FiltersNewCached (audio_output_t *aout,
+                                   const audio_sample_format_t *restrict infmt,
+                                   const audio_sample_format_t *restrict outfmt,
+                                   const aout_request_vout_t *request_vout,
+                                   const aout_filters_cfg_t *cfg,
+                                   aout_filters_cache_t *cache)
+{
+    return FiltersNew (VLC_OBJECT(aout), infmt, outfmt, request_vout, cfg,
+                       cache);
+}
+
+static aout_filters_t *FiltersNew (vlc_object_t *obj,
+                                   const audio_sample_format_t *restrict infmt,
+                                   const audio_sample_format_t *restrict outfmt,
+                                   const aout_request_vout_t *request_vout,
+                                   const aout_filters_cfg_t *cfg,
+                                   aout_filters_cache_t *cache)
 {
     aout_filters_t *filters = malloc (sizeof (*filters));
     if (unlikely(filters == NULL))
         return NULL;
 
+    filters->cache = cache;
     filters->rate_filter = NULL;
     filters->resampler = NULL;
     filters->resampling = 0;
@@ -526,7 +740,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
         if (!AOUT_FMTS_IDENTICAL(infmt, outfmt))
         {
             aout_FormatsPrint (obj, "pass-through:", infmt, outfmt);
-            filters->tab[0] = FindConverter(obj, infmt, outfmt);
+            filters->tab[0] = FindConverter(obj, cache, infmt, outfmt);
             if (filters->tab[0] == NULL)
             {
                 msg_Err (obj, "cannot setup pass-through");
@@ -550,8 +764,9 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
 
         /* convert to the output format (minus resampling) if necessary */
         output_format.i_rate = input_format.i_rate;
-        if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                                  AOUT_MAX_FILTERS, &input_format, &output_format,
+        if (aout_FiltersPipelineCreate (obj, cache, filters->tab,
+                                  &filters->count, AOUT_MAX_FILTERS,
+                                  &input_format, &output_format,
                                   cfg->headphones))
         {
             msg_Warn (obj, "cannot setup audio renderer pipeline");
@@ -574,7 +789,8 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
         audio_sample_format_t input_phys_format = input_format;
         aout_SetWavePhysicalChannels(&input_phys_format);
 
-        filter_t *f = FindConverter (obj, &input_format, &input_phys_format);
+        filter_t *f = FindConverter (obj, cache, &input_format,
+                                     &input_phys_format);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find channel converter");
@@ -634,7 +850,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
 
     /* convert to the output format (minus resampling) if necessary */
     output_format.i_rate = input_format.i_rate;
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
+    if (aout_FiltersPipelineCreate (obj, cache, filters->tab, &filters->count,
                               AOUT_MAX_FILTERS, &input_format, &output_format, false))
     {
         msg_Err (obj, "cannot setup filtering pipeline");
@@ -645,7 +861,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
     /* insert the resampler */
     output_format.i_rate = outfmt->i_rate;
     assert (AOUT_FMTS_IDENTICAL(&output_format, outfmt));
-    filters->resampler = FindResampler (obj, &input_format,
+    filters->resampler = FindResampler (obj, cache, &input_format,
                                         &output_format);
     if (filters->resampler == NULL && input_format.i_rate != outfmt->i_rate)
     {
@@ -658,7 +874,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
     return filters;
 
 error:
-    aout_FiltersPipelineDestroy (filters->tab, filters->count);
+    aout_FiltersPipelineDestroy (cache, filters->tab, filters->count);
     if (request_vout != NULL)
         var_DelCallback (obj, "visual", VisualizationCallback, NULL);
     free (filters);
@@ -677,8 +893,8 @@ error:
 void aout_FiltersDelete (vlc_object_t *obj, aout_filters_t *filters)
 {
     if (filters->resampler != NULL)
-        aout_FiltersPipelineDestroy (&filters->resampler, 1);
-    aout_FiltersPipelineDestroy (filters->tab, filters->count);
+        aout_FiltersPipelineDestroy (filters->cache, &filters->resampler, 1);
+    aout_FiltersPipelineDestroy (filters->cache, filters->tab, filters->count);
     if (obj != NULL)
         var_DelCallback (obj, "visual", VisualizationCallback, NULL);
     free (filters);
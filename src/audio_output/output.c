@@ -226,6 +226,7 @@ audio_output_t *aout_New (vlc_object_t *parent)
     owner->req.device = (char *)unset_str;
     owner->req.volume = -1.f;
     owner->req.mute = -1;
+    owner->filters_cache = aout_FiltersCacheNew ();
 
     vlc_object_set_destructor (aout, aout_Destructor);
 
@@ -383,6 +384,8 @@ void aout_Destroy (audio_output_t *aout)
     aout->volume_set = NULL;
     aout->mute_set = NULL;
     aout->device_select = NULL;
+    aout_FiltersCacheDelete (aout, owner->filters_cache);
+    owner->filters_cache = NULL;
     aout_OutputUnlock (aout);
 
     var_DelCallback (aout, "viewpoint", ViewpointCallback, NULL);
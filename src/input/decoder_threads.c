@@ -0,0 +1,338 @@
+/*****************************************************************************
+ * decoder_threads.c: decoder frame threading helper
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_codec.h>
+
+/* Maximal number of worker threads */
+#define FRAME_THREADS_MAX 32
+
+typedef struct frame_job_t frame_job_t;
+struct frame_job_t
+{
+    frame_job_t *p_next;
+    block_t     *p_block;
+    uint64_t    i_seq;
+};
+
+typedef struct
+{
+    decoder_frame_threads_t *p_owner;
+    vlc_thread_t            thread;
+    void                    *p_sys;
+    uint64_t                i_seq;      /* Unit being decoded */
+} frame_worker_t;
+
+struct decoder_frame_threads_t
+{
+    decoder_t                   *p_dec;
+    decoder_frame_threads_cbs_t cbs;
+
+    unsigned        i_workers;
+    frame_worker_t  *p_workers;
+    unsigned        i_depth;            /* Maximal number of units in flight */
+    vlc_threadvar_t worker_key;
+
+    /* Serializes the output format updates and picture allocations */
+    vlc_mutex_t     alloc_lock;
+
+    /* Lock for all following fields */
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait_job;           /* Signaled when a unit is queued */
+    vlc_cond_t      wait_output;        /* Broadcasted when a unit is output */
+
+    frame_job_t     *p_first;
+    frame_job_t     **pp_last;
+
+    uint64_t        i_seq_next;         /* Sequence number of the next unit */
+    uint64_t        i_seq_output;       /* Sequence number allowed to output */
+    uint64_t        i_seq_flush;        /* Units before this one are dropped */
+    bool            b_exit;
+
+    bool            b_format;           /* Output format set (alloc_lock) */
+};
+
+static frame_job_t *JobPop( decoder_frame_threads_t *p_ft )
+{
+    frame_job_t *p_job = p_ft->p_first;
+
+    p_ft->p_first = p_job->p_next;
+    if( p_ft->p_first == NULL )
+        p_ft->pp_last = &p_ft->p_first;
+    return p_job;
+}
+
+static void *WorkerThread( void *p_data )
+{
+    frame_worker_t *p_worker = p_data;
+    decoder_frame_threads_t *p_ft = p_worker->p_owner;
+    decoder_t *p_dec = p_ft->p_dec;
+
+    vlc_threadvar_set( p_ft->worker_key, p_worker );
+
+    vlc_mutex_lock( &p_ft->lock );
+    for( ;; )
+    {
+        while( !p_ft->b_exit && p_ft->p_first == NULL )
+            vlc_cond_wait( &p_ft->wait_job, &p_ft->lock );
+        if( p_ft->b_exit )
+            break;
+
+        frame_job_t *p_job = JobPop( p_ft );
+        const uint64_t i_seq = p_job->i_seq;
+        bool b_drop = i_seq < p_ft->i_seq_flush;
+        vlc_mutex_unlock( &p_ft->lock );
+
+        picture_t *p_pic = NULL;
+        p_worker->i_seq = i_seq;
+        if( b_drop )
+            block_Release( p_job->p_block );
+        else
+            p_pic = p_ft->cbs.pf_decode( p_dec, p_worker->p_sys, p_job->p_block );
+        free( p_job );
+
+        /* Wait for our turn to keep the submission order */
+        vlc_mutex_lock( &p_ft->lock );
+        while( p_ft->i_seq_output != i_seq )
+            vlc_cond_wait( &p_ft->wait_output, &p_ft->lock );
+        b_drop = i_seq < p_ft->i_seq_flush;
+        vlc_mutex_unlock( &p_ft->lock );
+
+        if( p_pic != NULL )
+        {
+            if( b_drop )
+                picture_Release( p_pic );
+            else
+                decoder_QueueVideo( p_dec, p_pic );
+        }
+
+        vlc_mutex_lock( &p_ft->lock );
+        p_ft->i_seq_output++;
+        vlc_cond_broadcast( &p_ft->wait_output );
+    }
+    vlc_mutex_unlock( &p_ft->lock );
+
+    return NULL;
+}
+
+decoder_frame_threads_t *decoder_FrameThreadsNew( decoder_t *p_dec,
+                                                  const decoder_frame_threads_cbs_t *p_cbs,
+                                                  unsigned i_threads )
+{
+    assert( p_cbs->pf_decode != NULL );
+
+    if( i_threads == 0 )
+        i_threads = vlc_GetCPUCount();
+    i_threads = VLC_CLIP( i_threads, 1, FRAME_THREADS_MAX );
+
+    decoder_frame_threads_t *p_ft = malloc( sizeof(*p_ft) );
+    if( unlikely(p_ft == NULL) )
+        return NULL;
+
+    p_ft->p_workers = vlc_alloc( i_threads, sizeof(*p_ft->p_workers) );
+    if( unlikely(p_ft->p_workers == NULL) ||
+        vlc_threadvar_create( &p_ft->worker_key, NULL ) )
+    {
+        free( p_ft->p_workers );
+        free( p_ft );
+        return NULL;
+    }
+
+    p_ft->p_dec = p_dec;
+    p_ft->cbs = *p_cbs;
+    p_ft->i_workers = 0;
+    /* One unit waiting per worker, so that none of them starves */
+    p_ft->i_depth = 2 * i_threads;
+    vlc_mutex_init( &p_ft->alloc_lock );
+    vlc_mutex_init( &p_ft->lock );
+    vlc_cond_init( &p_ft->wait_job );
+    vlc_cond_init( &p_ft->wait_output );
+    p_ft->p_first = NULL;
+    p_ft->pp_last = &p_ft->p_first;
+    p_ft->i_seq_next = 0;
+    p_ft->i_seq_output = 0;
+    p_ft->i_seq_flush = 0;
+    p_ft->b_exit = false;
+    p_ft->b_format = false;
+
+    for( unsigned i = 0; i < i_threads; i++ )
+    {
+        frame_worker_t *p_worker = &p_ft->p_workers[i];
+
+        p_worker->p_owner = p_ft;
+        p_worker->p_sys = NULL;
+        p_worker->i_seq = 0;
+        if( p_cbs->pf_open != NULL )
+        {
+            p_worker->p_sys = p_cbs->pf_open( p_dec );
+            if( p_worker->p_sys == NULL )
+                break;
+        }
+
+        if( vlc_clone( &p_worker->thread, WorkerThread, p_worker,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+        {
+            if( p_cbs->pf_close != NULL )
+                p_cbs->pf_close( p_dec, p_worker->p_sys );
+            break;
+        }
+        p_ft->i_workers++;
+    }
+
+    if( p_ft->i_workers == 0 )
+    {
+        decoder_FrameThreadsDelete( p_ft );
+        return NULL;
+    }
+
+    /* Each unit in flight holds one picture */
+    p_dec->i_extra_picture_buffers += p_ft->i_depth;
+
+    msg_Dbg( p_dec, "using %u frame decoding threads", p_ft->i_workers );
+    return p_ft;
+}
+
+void decoder_FrameThreadsDelete( decoder_frame_threads_t *p_ft )
+{
+    decoder_FrameThreadsFlush( p_ft );
+
+    vlc_mutex_lock( &p_ft->lock );
+    p_ft->b_exit = true;
+    vlc_cond_broadcast( &p_ft->wait_job );
+    vlc_mutex_unlock( &p_ft->lock );
+
+    for( unsigned i = 0; i < p_ft->i_workers; i++ )
+    {
+        frame_worker_t *p_worker = &p_ft->p_workers[i];
+
+        vlc_join( p_worker->thread, NULL );
+        if( p_ft->cbs.pf_close != NULL )
+            p_ft->cbs.pf_close( p_ft->p_dec, p_worker->p_sys );
+    }
+
+    assert( p_ft->p_first == NULL );
+    vlc_cond_destroy( &p_ft->wait_output );
+    vlc_cond_destroy( &p_ft->wait_job );
+    vlc_mutex_destroy( &p_ft->lock );
+    vlc_mutex_destroy( &p_ft->alloc_lock );
+    vlc_threadvar_delete( &p_ft->worker_key );
+    free( p_ft->p_workers );
+    free( p_ft );
+}
+
+int decoder_FrameThreadsDecode( decoder_frame_threads_t *p_ft, block_t *p_block )
+{
+    vlc_mutex_lock( &p_ft->lock );
+    if( p_block == NULL )
+    {
+        /* Drain */
+        while( p_ft->i_seq_output != p_ft->i_seq_next )
+            vlc_cond_wait( &p_ft->wait_output, &p_ft->lock );
+        vlc_mutex_unlock( &p_ft->lock );
+        return VLCDEC_SUCCESS;
+    }
+
+    frame_job_t *p_job = malloc( sizeof(*p_job) );
+    if( unlikely(p_job == NULL) )
+    {
+        vlc_mutex_unlock( &p_ft->lock );
+        block_Release( p_block );
+        return VLCDEC_SUCCESS;
+    }
+
+    while( p_ft->i_seq_next - p_ft->i_seq_output >= p_ft->i_depth )
+        vlc_cond_wait( &p_ft->wait_output, &p_ft->lock );
+
+    p_job->p_next = NULL;
+    p_job->p_block = p_block;
+    p_job->i_seq = p_ft->i_seq_next++;
+    *p_ft->pp_last = p_job;
+    p_ft->pp_last = &p_job->p_next;
+    vlc_cond_signal( &p_ft->wait_job );
+    vlc_mutex_unlock( &p_ft->lock );
+
+    return VLCDEC_SUCCESS;
+}
+
+void decoder_FrameThreadsFlush( decoder_frame_threads_t *p_ft )
+{
+    vlc_mutex_lock( &p_ft->lock );
+    p_ft->i_seq_flush = p_ft->i_seq_next;
+
+    /* The queued units are not decoded anymore, but they still take their
+     * turn so that the sequence stays contiguous */
+    while( p_ft->i_seq_output != p_ft->i_seq_flush && p_ft->i_workers > 0 )
+        vlc_cond_wait( &p_ft->wait_output, &p_ft->lock );
+
+    while( p_ft->p_first != NULL )
+    {
+        /* No worker left to drop them */
+        frame_job_t *p_job = JobPop( p_ft );
+        block_Release( p_job->p_block );
+        free( p_job );
+    }
+    vlc_mutex_unlock( &p_ft->lock );
+}
+
+picture_t *decoder_FrameThreadsNewPicture( decoder_frame_threads_t *p_ft,
+                                           const video_format_t *p_fmt )
+{
+    decoder_t *p_dec = p_ft->p_dec;
+    frame_worker_t *p_worker = vlc_threadvar_get( p_ft->worker_key );
+
+    assert( p_worker != NULL && p_worker->p_owner == p_ft );
+
+    vlc_mutex_lock( &p_ft->alloc_lock );
+    if( !p_ft->b_format ||
+        p_dec->fmt_out.i_codec != p_fmt->i_chroma ||
+        !video_format_IsSimilar( &p_dec->fmt_out.video, p_fmt ) ||
+        p_dec->fmt_out.video.i_width != p_fmt->i_width ||
+        p_dec->fmt_out.video.i_height != p_fmt->i_height )
+    {
+        /* The previous pictures must reach the video output before it is
+         * reconfigured. Do not hold the allocation lock meanwhile, the
+         * previous units may still need it. */
+        vlc_mutex_unlock( &p_ft->alloc_lock );
+
+        vlc_mutex_lock( &p_ft->lock );
+        while( p_ft->i_seq_output != p_worker->i_seq )
+            vlc_cond_wait( &p_ft->wait_output, &p_ft->lock );
+        vlc_mutex_unlock( &p_ft->lock );
+
+        vlc_mutex_lock( &p_ft->alloc_lock );
+        video_format_Clean( &p_dec->fmt_out.video );
+        video_format_Copy( &p_dec->fmt_out.video, p_fmt );
+        p_dec->fmt_out.i_codec = p_fmt->i_chroma;
+
+        p_ft->b_format = !decoder_UpdateVideoFormat( p_dec );
+    }
+
+    picture_t *p_pic = p_ft->b_format ? decoder_NewPicture( p_dec ) : NULL;
+    vlc_mutex_unlock( &p_ft->alloc_lock );
+
+    return p_pic;
+}
@@ -138,6 +138,71 @@ static const char* DemuxNameFromExtension( char const* ext,
     return result ? result->name : NULL;
 }
 
+/* Peeked once, and shared by all the signatures */
+#define DEMUX_SIGNATURE_PEEK (3 * 188 + 1)
+
+static const char *DemuxNameFromContent( stream_t *s )
+{
+    /* NOTE: like the strong extensions, only unambiguous signatures: the
+     * module is only tried first, the others are still probed on failure */
+    static const struct
+    {
+        struct
+        {
+            uint8_t offset;
+            uint8_t size;
+            char const bytes[8];
+        } sig[2];
+        char const name[8];
+    } signatures[] =
+    {
+        { { { 0, 4, "\x1A\x45\xDF\xA3" } },                    "mkv"  },
+        { { { 0, 4, "OggS" } },                                "ogg"  },
+        { { { 0, 4, "fLaC" } },                                "flac" },
+        { { { 0, 8, "\x30\x26\xB2\x75\x8E\x66\xCF\x11" } },    "asf"  },
+        { { { 4, 4, "ftyp" } },                                "mp4"  },
+        { { { 4, 4, "moov" } },                                "mp4"  },
+        { { { 0, 4, "RIFF" }, { 8, 4, "AVI " } },              "avi"  },
+        { { { 0, 4, "RIFF" }, { 8, 4, "RMID" } },              "smf"  },
+        { { { 0, 4, "MThd" } },                                "smf"  },
+        { { { 0, 4, "FORM" }, { 8, 4, "AIFF" } },              "aiff" },
+        { { { 0, 4, ".snd" } },                                "au"   },
+        { { { 0, 8, "Creative" }, { 9, 8, "Voice Fi" } },      "voc"  },
+        { { { 0, 4, "NSVf" } },                                "nsv"  },
+        { { { 0, 4, "NSVs" } },                                "nsv"  },
+        { { { 0, 4, "\x00\x00\x01\xBA" } },                    "ps"   },
+    };
+
+    const uint8_t *p_peek;
+    ssize_t i_peek = vlc_stream_Peek( s, &p_peek, DEMUX_SIGNATURE_PEEK );
+    if( i_peek < 8 )
+        return NULL;
+
+    for( size_t i = 0; i < ARRAY_SIZE( signatures ); i++ )
+    {
+        bool b_match = true;
+        for( size_t j = 0; j < 2 && signatures[i].sig[j].size && b_match; j++ )
+        {
+            const size_t i_end = signatures[i].sig[j].offset
+                               + signatures[i].sig[j].size;
+            b_match = (size_t)i_peek >= i_end
+                   && !memcmp( &p_peek[signatures[i].sig[j].offset],
+                               signatures[i].sig[j].bytes,
+                               signatures[i].sig[j].size );
+        }
+        if( b_match )
+            return signatures[i].name;
+    }
+
+    /* MPEG-TS: sync bytes of three consecutive packets */
+    if( i_peek >= DEMUX_SIGNATURE_PEEK && p_peek[0] == 0x47
+     && p_peek[188] == 0x47 && p_peek[2 * 188] == 0x47
+     && p_peek[3 * 188] == 0x47 )
+        return "ts";
+
+    return NULL;
+}
+
 /*****************************************************************************
  * demux_New:
  *  if s is NULL then load a access_demux
@@ -258,6 +323,15 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_parent_input,
                 psz_module = DemuxNameFromExtension( psz_ext + 1, b_preparsing );
         }
 
+        /* Peek once to try the likely module first, rather than probing all
+         * of them in priority order for unknown or missing extensions */
+        if( psz_module == NULL && !strcmp( p_demux->psz_demux, "any" ) )
+        {
+            psz_module = DemuxNameFromContent( s );
+            if( psz_module != NULL && !b_preparsing )
+                msg_Dbg( p_obj, "content looks like '%s'", psz_module );
+        }
+
         if( psz_module == NULL )
             psz_module = p_demux->psz_demux;
 
@@ -67,6 +67,7 @@ enum
     C_SEND,
     C_DEL,
     C_CONTROL,
+    C_SKIP, /* Already executed, not replayed after a seek */
 };
 
 typedef struct attribute_packed
@@ -161,6 +162,19 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
+/* Random access point of a storage, used to seek inside the timeshift window */
+typedef struct attribute_packed
+{
+    vlc_tick_t i_date;      /* Date of the indexed command */
+    int        i_cmd;       /* Position of the command in the storage */
+    bool       b_keyframe;
+} ts_index_t;
+
+/* Minimal distance between two non keyframe index entries */
+#define TS_INDEX_INTERVAL (CLOCK_FREQ/2)
+/* Maximal number of entries rewound while looking for a keyframe */
+#define TS_INDEX_KEYFRAME_LOOKBACK (64)
+
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
@@ -174,12 +188,22 @@ struct ts_storage_t
     int64_t i_file_size;/* Current size in bytes */
     FILE    *p_filew;   /* FILE handle for data writing */
     FILE    *p_filer;   /* FILE handle for data reading */
+    bool    b_memory;   /* Blocks are kept as is instead of being written */
 
     /* */
     int      i_cmd_r;
     int      i_cmd_w;
     int      i_cmd_max;
     ts_cmd_t *p_cmd;
+
+    /* */
+    vlc_tick_t i_date_first;
+    vlc_tick_t i_date_last;
+
+    /* Random access index (only filled with a timeshift window) */
+    int        i_index;
+    int        i_index_max;
+    ts_index_t *p_index;
 };
 
 typedef struct
@@ -189,6 +213,8 @@ typedef struct
     es_out_t       *p_out;
     int64_t        i_tmp_size_max;
     const char     *psz_tmp_path;
+    vlc_tick_t     i_window;
+    vlc_tick_t     i_memory;
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -211,8 +237,27 @@ typedef struct
     ts_storage_t   *p_storage_r;
     ts_storage_t   *p_storage_w;
 
+    /* All the storages, oldest first. With a timeshift window, the ones
+     * before p_storage_r are kept to allow seeking back */
+    int            i_storage;
+    ts_storage_t   **pp_storage;
+
     vlc_tick_t     i_cmd_delay;
 
+    /* Last input time received and its date, to map seek requests */
+    vlc_tick_t     i_times_time;
+    vlc_tick_t     i_times_date;
+
+    /* Pending seek (date of the targeted command) */
+    vlc_tick_t     i_seek_date;
+
+    /* The window holds data, "can-seek" was raised */
+    bool           b_window_seekable;
+
+    /* Ids deleted while their commands may still be replayed */
+    int            i_es_dead;
+    es_out_id_t    **pp_es_dead;
+
 } ts_thread_t;
 
 struct es_out_id_t
@@ -228,6 +273,8 @@ struct es_out_sys_t
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
     char           *psz_tmp_path;     /* Path for temporary files */
+    vlc_tick_t     i_window;          /* Duration kept for seeking back (0 disables) */
+    vlc_tick_t     i_memory;          /* Duration kept in memory (0 uses files) */
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -263,16 +310,20 @@ static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, vlc_tick_t i_date );
 static int          TsChangeRate( ts_thread_t *, int i_src_rate, int i_rate );
+static int          TsChangeTime( ts_thread_t *, vlc_tick_t i_time );
+static bool         TsSeekLocked( ts_thread_t * );
 
 static void         *TsRun( void * );
 
-static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
+static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max, bool b_memory );
 static void         TsStorageDelete( ts_storage_t * );
 static void         TsStoragePack( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
-static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
-static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
+static bool         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
+static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush, bool b_retain );
+static void         TsStorageIndexCmd( ts_storage_t *, vlc_tick_t i_date, bool b_keyframe );
+static int          TsStorageIndexFind( ts_storage_t *, vlc_tick_t i_date );
 
 static void CmdClean( ts_cmd_t * );
 static void cmd_cleanup_routine( void *p ) { CmdClean( p ); }
@@ -293,6 +344,8 @@ static int  CmdExecuteSend   ( es_out_t *, ts_cmd_t * );
 static void CmdExecuteDel    ( es_out_t *, ts_cmd_t * );
 static int  CmdExecuteControl( es_out_t *, ts_cmd_t * );
 
+static bool CmdIsReplayable( const ts_cmd_t * );
+
 /* File helpers */
 static int GetTmpFile( char **ppsz_file, const char *psz_path );
 
@@ -344,6 +397,16 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     msg_Dbg( p_input, "using timeshift granularity of %d MiB",
              (int)p_sys->i_tmp_size_max/(1024*1024) );
 
+    const int i_window = var_InheritInteger( p_input, "input-timeshift-window" );
+    p_sys->i_window = __MAX( i_window, 0 ) * CLOCK_FREQ;
+    if( p_sys->i_window > 0 )
+        msg_Dbg( p_input, "using timeshift window of %d s", i_window );
+
+    const int i_memory = var_InheritInteger( p_input, "input-timeshift-memory" );
+    p_sys->i_memory = __MAX( i_memory, 0 ) * CLOCK_FREQ;
+    if( p_sys->i_memory > 0 )
+        msg_Dbg( p_input, "using in-memory timeshift of %d s", i_memory );
+
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32) && !VLC_WINSTORE_APP
     if( p_sys->psz_tmp_path == NULL )
@@ -465,6 +528,11 @@ static int Send( es_out_t *p_out, es_out_id_t *p_es, block_t *p_block )
 
     TsAutoStop( p_out );
 
+    /* With a window, record everything from the start to allow seeking back */
+    if( !p_sys->b_delayed && p_sys->i_window > 0 &&
+        !input_priv(p_sys->p_input)->b_can_pace_control )
+        TsStart( p_out );
+
     CmdInitSend( &cmd, p_es, p_block );
     if( p_sys->b_delayed )
         TsPushCmd( p_sys->p_ts, &cmd );
@@ -609,7 +677,15 @@ static int ControlLockedSetTime( es_out_t *p_out, vlc_tick_t i_date )
     es_out_sys_t *p_sys = p_out->p_sys;
 
     if( !p_sys->b_delayed )
+    {
+        /* Only the timeshift window can seek to a given time */
+        if( i_date >= 0 )
+            return VLC_EGENERIC;
         return es_out_SetTime( p_sys->p_out, i_date );
+    }
+
+    if( i_date >= 0 )
+        return TsChangeTime( p_sys->p_ts, i_date );
 
     /* TODO */
     msg_Err( p_sys->p_input, "EsOutTimeshift does not yet support time change" );
@@ -773,6 +849,11 @@ static int Control( es_out_t *p_out, int i_query, va_list args )
  *****************************************************************************/
 static void TsDestroy( ts_thread_t *p_ts )
 {
+    for( int i = 0; i < p_ts->i_es_dead; i++ )
+        free( p_ts->pp_es_dead[i] );
+    TAB_CLEAN( p_ts->i_es_dead, p_ts->pp_es_dead );
+    TAB_CLEAN( p_ts->i_storage, p_ts->pp_storage );
+
     vlc_cond_destroy( &p_ts->wait );
     vlc_mutex_destroy( &p_ts->lock );
     free( p_ts );
@@ -790,6 +871,8 @@ static int TsStart( es_out_t *p_out )
 
     p_ts->i_tmp_size_max = p_sys->i_tmp_size_max;
     p_ts->psz_tmp_path = p_sys->psz_tmp_path;
+    p_ts->i_window = p_sys->i_window;
+    p_ts->i_memory = p_sys->i_memory;
     p_ts->p_input = p_sys->p_input;
     p_ts->p_out = p_sys->p_out;
     vlc_mutex_init( &p_ts->lock );
@@ -804,6 +887,12 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_cmd_delay = 0;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
+    TAB_INIT( p_ts->i_storage, p_ts->pp_storage );
+    p_ts->i_times_time = -1;
+    p_ts->i_times_date = -1;
+    p_ts->i_seek_date = -1;
+    p_ts->b_window_seekable = false;
+    TAB_INIT( p_ts->i_es_dead, p_ts->pp_es_dead );
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts, VLC_THREAD_PRIORITY_INPUT ) )
@@ -846,8 +935,11 @@ static void TsStop( ts_thread_t *p_ts )
         CmdClean( &cmd );
     }
     assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
-    if( p_ts->p_storage_r )
-        TsStorageDelete( p_ts->p_storage_r );
+    while( p_ts->i_storage > 0 )
+    {
+        TsStorageDelete( p_ts->pp_storage[0] );
+        TAB_ERASE( p_ts->i_storage, p_ts->pp_storage, 0 );
+    }
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
@@ -858,7 +950,8 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 
     if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max,
+                                                p_ts->i_memory > 0 );
 
         if( !p_storage )
         {
@@ -878,33 +971,87 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
             p_ts->p_storage_w->p_next = p_storage;
             p_ts->p_storage_w = p_storage;
         }
+        TAB_APPEND( p_ts->i_storage, p_ts->pp_storage, p_storage );
+    }
+
+    const bool b_index = ( p_ts->i_window > 0 || p_ts->i_memory > 0 ) &&
+                         p_cmd->i_type == C_SEND;
+    const bool b_keyframe = b_index &&
+                            ( p_cmd->u.send.p_block->i_flags & BLOCK_FLAG_TYPE_I );
+    const vlc_tick_t i_date = p_cmd->i_date;
+
+    if( ( p_ts->i_window > 0 || p_ts->i_memory > 0 ) &&
+        p_cmd->i_type == C_CONTROL &&
+        p_cmd->u.control.i_query == ES_OUT_SET_TIMES )
+    {
+        p_ts->i_times_time = p_cmd->u.control.u.times.i_time;
+        p_ts->i_times_date = p_cmd->i_date;
     }
 
     /* TODO return error and warn the user (but only once) */
-    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
+    if( TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w ) &&
+        b_index )
+        TsStorageIndexCmd( p_ts->p_storage_w, i_date, b_keyframe );
+
+    /* Skip the data that stayed in memory for too long (it happens only
+     * when paused or slowed down for longer than the memory duration) */
+    if( p_ts->i_memory > 0 && p_ts->i_seek_date < 0 &&
+        !TsStorageIsEmpty( p_ts->p_storage_r ) &&
+        p_ts->p_storage_r->p_cmd[p_ts->p_storage_r->i_cmd_r].i_date < p_cmd->i_date - p_ts->i_memory )
+    {
+        msg_Warn( p_ts->p_input, "es out timeshift: memory duration exceeded, skipping" );
+        p_ts->i_seek_date = p_cmd->i_date - p_ts->i_memory / 2;
+    }
+
+    /* Drop the already played storages that went out of the window */
+    while( p_ts->i_window > 0 && p_ts->pp_storage[0] != p_ts->p_storage_r &&
+           p_ts->pp_storage[0]->i_date_last < p_cmd->i_date - p_ts->i_window )
+    {
+        TsStorageDelete( p_ts->pp_storage[0] );
+        TAB_ERASE( p_ts->i_storage, p_ts->pp_storage, 0 );
+    }
+
+    /* Live inputs become seekable once the window can serve a seek */
+    const bool b_seekable = !p_ts->b_window_seekable && p_ts->i_window > 0 &&
+                            p_ts->i_times_date >= 0 &&
+                            p_ts->p_storage_w->i_date_last >= 0;
+    if( b_seekable )
+        p_ts->b_window_seekable = true;
 
     vlc_cond_signal( &p_ts->wait );
 
     vlc_mutex_unlock( &p_ts->lock );
+
+    if( b_seekable )
+        var_SetBool( p_ts->p_input, "can-seek", true );
 }
 static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
 {
     vlc_assert_locked( &p_ts->lock );
 
-    if( TsStorageIsEmpty( p_ts->p_storage_r ) )
-        return VLC_EGENERIC;
+    const bool b_retain = p_ts->i_window > 0;
+    do
+    {
+        if( TsStorageIsEmpty( p_ts->p_storage_r ) )
+            return VLC_EGENERIC;
 
-    TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
+        TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush, b_retain );
 
-    while( TsStorageIsEmpty( p_ts->p_storage_r ) )
-    {
-        ts_storage_t *p_next = p_ts->p_storage_r->p_next;
-        if( !p_next )
-            break;
+        while( TsStorageIsEmpty( p_ts->p_storage_r ) )
+        {
+            ts_storage_t *p_next = p_ts->p_storage_r->p_next;
+            if( !p_next )
+                break;
 
-        TsStorageDelete( p_ts->p_storage_r );
-        p_ts->p_storage_r = p_next;
-    }
+            if( !b_retain )
+            {
+                assert( p_ts->pp_storage[0] == p_ts->p_storage_r );
+                TsStorageDelete( p_ts->p_storage_r );
+                TAB_ERASE( p_ts->i_storage, p_ts->pp_storage, 0 );
+            }
+            p_ts->p_storage_r = p_next;
+        }
+    } while( p_cmd->i_type == C_SKIP );
 
     return VLC_SUCCESS;
 }
@@ -923,7 +1070,8 @@ static bool TsIsUnused( ts_thread_t *p_ts )
     bool b_unused;
 
     vlc_mutex_lock( &p_ts->lock );
-    b_unused = !p_ts->b_paused &&
+    b_unused = p_ts->i_window <= 0 &&
+               !p_ts->b_paused &&
                p_ts->i_rate == p_ts->i_rate_source &&
                TsStorageIsEmpty( p_ts->p_storage_r );
     vlc_mutex_unlock( &p_ts->lock );
@@ -979,6 +1127,175 @@ static int TsChangeRate( ts_thread_t *p_ts, int i_src_rate, int i_rate )
 
     return i_ret;
 }
+static int TsChangeTime( ts_thread_t *p_ts, vlc_tick_t i_time )
+{
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_ts->lock );
+    if( p_ts->i_window > 0 && p_ts->i_times_date >= 0 &&
+        p_ts->i_storage > 0 && p_ts->p_storage_w->i_date_last >= 0 )
+    {
+        /* Map the input time to the date the data were received at */
+        const vlc_tick_t i_date = p_ts->i_times_date + i_time - p_ts->i_times_time;
+
+        p_ts->i_seek_date = VLC_CLIP( i_date, p_ts->pp_storage[0]->i_date_first,
+                                      p_ts->p_storage_w->i_date_last );
+        vlc_cond_signal( &p_ts->wait );
+        i_ret = VLC_SUCCESS;
+    }
+    vlc_mutex_unlock( &p_ts->lock );
+
+    return i_ret;
+}
+
+static void TsExecuteDel( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
+{
+    if( p_ts->i_window <= 0 )
+    {
+        CmdExecuteDel( p_ts->p_out, p_cmd );
+        return;
+    }
+
+    /* Retained commands may still refer to this id, release it at the end */
+    es_out_id_t *p_es = p_cmd->u.del.p_es;
+    if( p_es->p_es )
+        es_out_Del( p_ts->p_out, p_es->p_es );
+    p_es->p_es = NULL;
+    TAB_APPEND( p_ts->i_es_dead, p_ts->pp_es_dead, p_es );
+}
+static void TsSkipCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
+{
+    /* Drop the data but keep the ES and program states up to date */
+    switch( p_cmd->i_type )
+    {
+    case C_ADD:
+        CmdExecuteAdd( p_ts->p_out, p_cmd );
+        CmdCleanAdd( p_cmd );
+        break;
+    case C_DEL:
+        TsExecuteDel( p_ts, p_cmd );
+        break;
+    case C_CONTROL:
+        if( !CmdIsReplayable( p_cmd ) )
+            CmdExecuteControl( p_ts->p_out, p_cmd );
+        CmdCleanControl( p_cmd );
+        break;
+    default:
+        CmdClean( p_cmd );
+        break;
+    }
+}
+static int TsIndexFind( ts_thread_t *p_ts, vlc_tick_t i_date,
+                        ts_storage_t **pp_storage, int *pi_cmd )
+{
+    /* Last storage started before the date */
+    int i_low = 0;
+    int i_high = p_ts->i_storage - 1;
+    while( i_low < i_high )
+    {
+        const int i_mid = (i_low + i_high + 1) / 2;
+        if( p_ts->pp_storage[i_mid]->i_date_first <= i_date )
+            i_low = i_mid;
+        else
+            i_high = i_mid - 1;
+    }
+
+    for( int i = i_low; i >= 0; i-- )
+    {
+        ts_storage_t *p_storage = p_ts->pp_storage[i];
+        const int i_entry = TsStorageIndexFind( p_storage, i_date );
+        if( i_entry >= 0 )
+        {
+            *pp_storage = p_storage;
+            *pi_cmd = p_storage->p_index[i_entry].i_cmd;
+            return VLC_SUCCESS;
+        }
+    }
+
+    /* Before the window: use its first random access point */
+    for( int i = 0; i < p_ts->i_storage; i++ )
+    {
+        ts_storage_t *p_storage = p_ts->pp_storage[i];
+        if( p_storage->i_index > 0 )
+        {
+            *pp_storage = p_storage;
+            *pi_cmd = p_storage->p_index[0].i_cmd;
+            return VLC_SUCCESS;
+        }
+    }
+    return VLC_EGENERIC;
+}
+static bool TsSeekLocked( ts_thread_t *p_ts )
+{
+    vlc_assert_locked( &p_ts->lock );
+
+    const vlc_tick_t i_date = p_ts->i_seek_date;
+    p_ts->i_seek_date = -1;
+
+    ts_storage_t *p_storage;
+    int i_cmd;
+    if( TsIndexFind( p_ts, i_date, &p_storage, &i_cmd ) ||
+        i_cmd >= p_storage->i_cmd_w )
+        return false;
+
+    bool b_backward = false;
+    for( ts_storage_t *p = p_storage; p != NULL; p = p->p_next )
+    {
+        if( p == p_ts->p_storage_r )
+        {
+            b_backward = p != p_storage || i_cmd <= p->i_cmd_r;
+            break;
+        }
+    }
+
+    const bool b_retain = p_ts->i_window > 0;
+    if( b_backward && !b_retain )
+        return false; /* Already played and released */
+
+    if( b_backward )
+    {
+        /* Everything after the point is still in the storages */
+        p_ts->p_storage_r = p_storage;
+        p_storage->i_cmd_r = i_cmd;
+        for( ts_storage_t *p = p_storage->p_next; p != NULL; p = p->p_next )
+            p->i_cmd_r = 0;
+    }
+    else
+    {
+        while( p_ts->p_storage_r != p_storage || p_storage->i_cmd_r < i_cmd )
+        {
+            if( TsStorageIsEmpty( p_ts->p_storage_r ) )
+            {
+                ts_storage_t *p_next = p_ts->p_storage_r->p_next;
+                if( !b_retain )
+                {
+                    TsStorageDelete( p_ts->p_storage_r );
+                    TAB_ERASE( p_ts->i_storage, p_ts->pp_storage, 0 );
+                }
+                p_ts->p_storage_r = p_next;
+                continue;
+            }
+
+            ts_cmd_t cmd;
+            TsStoragePopCmd( p_ts->p_storage_r, &cmd, true, b_retain );
+            TsSkipCmd( p_ts, &cmd );
+        }
+    }
+    msg_Dbg( p_ts->p_input, "es out timeshift: seek %s",
+             b_backward ? "backward" : "forward" );
+
+    /* Restart the decoders and the clock from the random access point */
+    es_out_SetTime( p_ts->p_out, -1 );
+
+    const vlc_tick_t i_now = mdate();
+    p_ts->i_cmd_delay = i_now - p_storage->p_cmd[i_cmd].i_date;
+    p_ts->i_rate_date = -1;
+    p_ts->i_rate_delay = 0;
+    p_ts->i_buffering_delay = 0;
+    if( p_ts->b_paused )
+        p_ts->i_pause_date = i_now;
+    return true;
+}
 
 static void *TsRun( void *p_data )
 {
@@ -998,6 +1315,9 @@ static void *TsRun( void *p_data )
         for( ;; )
         {
             const int canc = vlc_savecancel();
+            if( p_ts->i_seek_date >= 0 && TsSeekLocked( p_ts ) )
+                i_buffering_date = -1;
+
             b_buffering = es_out_GetBuffering( p_ts->p_out );
 
             if( ( !p_ts->b_paused || b_buffering ) && !TsPopCmdLocked( p_ts, &cmd, false ) )
@@ -1087,7 +1407,7 @@ static void *TsRun( void *p_data )
             CmdCleanControl( &cmd );
             break;
         case C_DEL:
-            CmdExecuteDel( p_ts->p_out, &cmd );
+            TsExecuteDel( p_ts, &cmd );
             break;
         default:
             vlc_assert_unreachable();
@@ -1102,12 +1422,23 @@ static void *TsRun( void *p_data )
 /*****************************************************************************
  *
  *****************************************************************************/
-static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
+static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max, bool b_memory )
 {
     ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
     if( unlikely(p_storage == NULL) )
         return NULL;
 
+    p_storage->b_memory = b_memory;
+    if( b_memory )
+    {
+        p_storage->p_filew = NULL;
+        p_storage->p_filer = NULL;
+#ifdef _WIN32
+        p_storage->psz_file = NULL;
+#endif
+        goto init;
+    }
+
     char *psz_file;
     int fd = GetTmpFile( &psz_file, psz_tmp_path );
     if( fd == -1 )
@@ -1138,6 +1469,7 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
 #else
     p_storage->psz_file = psz_file;
 #endif
+init:
     p_storage->p_next = NULL;
 
     /* */
@@ -1147,6 +1479,11 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     /* */
     p_storage->i_cmd_w = 0;
     p_storage->i_cmd_r = 0;
+    p_storage->i_date_first = -1;
+    p_storage->i_date_last = -1;
+    p_storage->i_index = 0;
+    p_storage->i_index_max = 0;
+    p_storage->p_index = NULL;
     p_storage->i_cmd_max = 30000;
     p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
     //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
@@ -1169,23 +1506,45 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     {
         ts_cmd_t cmd;
 
-        TsStoragePopCmd( p_storage, &cmd, true );
+        TsStoragePopCmd( p_storage, &cmd, true, false );
 
         CmdClean( &cmd );
     }
+    if( p_storage->b_memory )
+    {
+        /* Played blocks kept for seeking back */
+        for( int i = 0; i < p_storage->i_cmd_r; i++ )
+        {
+            if( p_storage->p_cmd[i].i_type == C_SEND )
+                CmdCleanSend( &p_storage->p_cmd[i] );
+        }
+    }
     free( p_storage->p_cmd );
+    free( p_storage->p_index );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
+    if( !p_storage->b_memory )
+    {
+        fclose( p_storage->p_filer );
+        if( p_storage->p_filew )
+            fclose( p_storage->p_filew );
 #ifdef _WIN32
-    vlc_unlink( p_storage->psz_file );
-    free( p_storage->psz_file );
+        vlc_unlink( p_storage->psz_file );
+        free( p_storage->psz_file );
 #endif
+    }
     free( p_storage );
 }
 
 static void TsStoragePack( ts_storage_t *p_storage )
 {
+    /* Nothing is written anymore, only keep the read handle: the storages
+     * retained for the timeshift window would hold two descriptors each */
+    if( p_storage->p_filew )
+    {
+        fclose( p_storage->p_filew );
+        p_storage->p_filew = NULL;
+    }
+
     /* Try to release a bit of memory */
     if( p_storage->i_cmd_w >= p_storage->i_cmd_max )
         return;
@@ -1211,13 +1570,18 @@ static bool TsStorageIsEmpty( ts_storage_t *p_storage )
 {
     return !p_storage || p_storage->i_cmd_r >= p_storage->i_cmd_w;
 }
-static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
+static bool TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
 {
     ts_cmd_t cmd = *p_cmd;
 
     assert( !TsStorageIsFull( p_storage, p_cmd ) );
 
-    if( cmd.i_type == C_SEND )
+    if( cmd.i_type == C_SEND && p_storage->b_memory )
+    {
+        /* The block itself is queued */
+        p_storage->i_file_size += sizeof(block_t) + cmd.u.send.p_block->i_buffer;
+    }
+    else if( cmd.i_type == C_SEND )
     {
         block_t *p_block = cmd.u.send.p_block;
 
@@ -1227,7 +1591,7 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
         if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
         {
             block_Release( p_block );
-            return;
+            return false;
         }
         p_storage->i_file_size += sizeof(*p_block);
         if( p_block->i_buffer > 0 )
@@ -1235,7 +1599,7 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
             if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
             {
                 block_Release( p_block );
-                return;
+                return false;
             }
         }
         p_storage->i_file_size += p_block->i_buffer;
@@ -1244,14 +1608,40 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
         if( b_flush )
             fflush( p_storage->p_filew );
     }
+    if( p_storage->i_cmd_w == 0 )
+        p_storage->i_date_first = cmd.i_date;
+    p_storage->i_date_last = cmd.i_date;
     p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
+    return true;
 }
-static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
+static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush, bool b_retain )
 {
     assert( !TsStorageIsEmpty( p_storage ) );
 
-    *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
-    if( p_cmd->i_type == C_SEND )
+    ts_cmd_t *p_slot = &p_storage->p_cmd[p_storage->i_cmd_r++];
+
+    *p_cmd = *p_slot;
+    /* The caller owns the resources of the command now, only the ones
+     * that can be replayed (data and clock) are kept */
+    if( b_retain && !CmdIsReplayable( p_slot ) )
+        p_slot->i_type = C_SKIP;
+
+    if( p_cmd->i_type == C_SEND && p_storage->b_memory )
+    {
+        /* Hand over the queued block, or a copy when it is kept for
+         * seeking back. The copy cannot be avoided: the block belongs to
+         * the decoder once sent, and packetizers and decoders may modify
+         * or reuse its buffer in place. Combined with a window, every
+         * played block is thus copied once, which still beats the write
+         * and read back of the file storages. */
+        if( !b_retain )
+            p_slot->u.send.p_block = NULL;
+        else if( !b_flush )
+            p_cmd->u.send.p_block = block_Duplicate( p_slot->u.send.p_block );
+        else
+            p_cmd->u.send.p_block = NULL;
+    }
+    else if( p_cmd->i_type == C_SEND )
     {
         block_t block;
 
@@ -1279,6 +1669,52 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
     }
 }
 
+/* Indexes the last stored command */
+static void TsStorageIndexCmd( ts_storage_t *p_storage, vlc_tick_t i_date, bool b_keyframe )
+{
+    if( !b_keyframe && p_storage->i_index > 0 &&
+        i_date < p_storage->p_index[p_storage->i_index-1].i_date + TS_INDEX_INTERVAL )
+        return;
+
+    if( p_storage->i_index >= p_storage->i_index_max )
+    {
+        const int i_max = __MAX( 2 * p_storage->i_index_max, 256 );
+        ts_index_t *p_new = realloc( p_storage->p_index, i_max * sizeof(*p_new) );
+        if( !p_new )
+            return;
+        p_storage->p_index = p_new;
+        p_storage->i_index_max = i_max;
+    }
+
+    ts_index_t *p_entry = &p_storage->p_index[p_storage->i_index++];
+    p_entry->i_date = i_date;
+    p_entry->i_cmd = p_storage->i_cmd_w - 1;
+    p_entry->b_keyframe = b_keyframe;
+}
+static int TsStorageIndexFind( ts_storage_t *p_storage, vlc_tick_t i_date )
+{
+    /* Last entry not after the date */
+    int i_low = 0;
+    int i_high = p_storage->i_index;
+    while( i_low < i_high )
+    {
+        const int i_mid = (i_low + i_high) / 2;
+        if( p_storage->p_index[i_mid].i_date <= i_date )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    const int i_entry = i_low - 1;
+
+    /* Prefer to restart on a keyframe when the demuxer flags them */
+    for( int i = i_entry; i >= 0 && i > i_entry - TS_INDEX_KEYFRAME_LOOKBACK; i-- )
+    {
+        if( p_storage->p_index[i].b_keyframe )
+            return i;
+    }
+    return i_entry;
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
@@ -1296,12 +1732,31 @@ static void CmdClean( ts_cmd_t *p_cmd )
         CmdCleanControl( p_cmd );
         break;
     case C_DEL:
+    case C_SKIP:
         break;
     default:
         vlc_assert_unreachable();
         break;
     }
 }
+static bool CmdIsReplayable( const ts_cmd_t *p_cmd )
+{
+    if( p_cmd->i_type == C_SEND )
+        return true;
+    if( p_cmd->i_type != C_CONTROL )
+        return false;
+
+    switch( p_cmd->u.control.i_query )
+    {
+    case ES_OUT_SET_PCR:
+    case ES_OUT_SET_GROUP_PCR:
+    case ES_OUT_RESET_PCR:
+    case ES_OUT_SET_TIMES:
+        return true;
+    default:
+        return false;
+    }
+}
 
 static int CmdInitAdd( ts_cmd_t *p_cmd, es_out_id_t *p_es, const es_format_t *p_fmt, bool b_copy )
 {
@@ -2080,6 +2080,11 @@ static bool Control( input_thread_t *p_input,
                 }
             }
             if( i_ret )
+            {
+                /* Seek inside the timeshift window of a live stream */
+                i_ret = es_out_SetTime( input_priv(p_input)->p_es_out, i_time );
+            }
+            if( i_ret )
             {
                 msg_Warn( p_input, "INPUT_CONTROL_SET_TIME %"PRId64
                          " failed or not possible", i_time );
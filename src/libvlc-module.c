@@ -475,6 +475,12 @@ static const char *const ppsz_pos_descriptions[] =
     "This drops frames that are late (arrive to the video output after " \
     "their intended display date)." )
 
+#define LATEST_FRAME_TEXT N_("Display only the latest frame")
+#define LATEST_FRAME_LONGTEXT N_( \
+    "Hand decoded frames over to the video output through a single slot: " \
+    "a new frame replaces the pending one, which is dropped. This lowers " \
+    "the display latency at the cost of smoothness, for live sources." )
+
 #define QUIET_SYNCHRO_TEXT N_("Quiet synchro")
 #define QUIET_SYNCHRO_LONGTEXT N_( \
     "This avoids flooding the message log with debug output from the " \
@@ -686,6 +692,17 @@ static const char *const ppsz_prefres[] = {
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_TIMESHIFT_WINDOW_TEXT N_("Timeshift window")
+#define INPUT_TIMESHIFT_WINDOW_LONGTEXT N_( \
+    "Duration in seconds of the already played part of live streams " \
+    "that is kept and indexed to allow seeking back (0 to disable)." )
+
+#define INPUT_TIMESHIFT_MEMORY_TEXT N_("In-memory timeshift")
+#define INPUT_TIMESHIFT_MEMORY_LONGTEXT N_( \
+    "Keep the timeshifted streams in memory instead of temporary files, " \
+    "up to this duration in seconds (0 to use temporary files). With a " \
+    "timeshift window, the played data is copied when sent to the decoders." )
+
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
     "$a: Artist<br>$b: Album<br>$c: Copyright<br>$t: Title<br>$g: Genre<br>"  \
@@ -1563,6 +1580,8 @@ vlc_module_begin ()
         change_private ()
     add_bool( "drop-late-frames", 1, DROP_LATE_FRAMES_TEXT,
               DROP_LATE_FRAMES_LONGTEXT, true )
+    add_bool( "video-latest-frame", false, LATEST_FRAME_TEXT,
+              LATEST_FRAME_LONGTEXT, true )
     /* Used in vout_synchro */
     add_bool( "skip-frames", 1, SKIP_FRAMES_TEXT,
               SKIP_FRAMES_LONGTEXT, true )
@@ -1927,6 +1946,12 @@ vlc_module_begin ()
                 INPUT_TIMESHIFT_PATH_LONGTEXT, true )
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer( "input-timeshift-window", 0, INPUT_TIMESHIFT_WINDOW_TEXT,
+                 INPUT_TIMESHIFT_WINDOW_LONGTEXT, true )
+        change_integer_range( 0, 86400 )
+    add_integer( "input-timeshift-memory", 0, INPUT_TIMESHIFT_MEMORY_TEXT,
+                 INPUT_TIMESHIFT_MEMORY_LONGTEXT, true )
+        change_integer_range( 0, 86400 )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
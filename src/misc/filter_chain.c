@@ -31,6 +31,7 @@
 #include <vlc_spu.h>
 #include <libvlc.h>
 #include <assert.h>
+#include "picture.h"
 
 typedef struct chained_filter_t
 {
@@ -48,6 +49,35 @@ static inline chained_filter_t *chained(filter_t *filter)
     return container_of(filter, chained_filter_t, filter);
 }
 
+/* Pictures allocated for the intermediate filters of a video chain are
+ * recycled, keyed by format, instead of being freed on release. The arena
+ * is reference counted as pictures may outlive the chain. */
+#define ARENA_BUCKETS  4
+#define ARENA_MAX_FREE 16
+
+typedef struct
+{
+    video_format_t key; /**< Requested format */
+    video_format_t fmt; /**< Format of the pictures (as set up) */
+    picture_t *free; /**< Recycled pictures, linked through p_next */
+    unsigned free_count;
+    uint64_t last_use;
+} filter_arena_bucket_t;
+
+typedef struct
+{
+    vlc_mutex_t lock;
+    atomic_uint refs; /**< Chain and pending pictures references */
+    bool dead; /**< The chain was deleted */
+    uint64_t use_count;
+    unsigned bucket_count;
+    filter_arena_bucket_t bucket[ARENA_BUCKETS];
+    void (*destroy)(picture_t *); /**< Pictures original destructor */
+
+    uint64_t allocated; /**< Pictures allocated from the heap */
+    uint64_t recycled; /**< Pictures served from the arena */
+} filter_arena_t;
+
 /* */
 struct filter_chain_t
 {
@@ -61,6 +91,7 @@ struct filter_chain_t
     bool b_allow_fmt_out_change; /**< Can the output format be changed? */
     const char *filter_cap; /**< Filter modules capability */
     const char *conv_cap; /**< Converter modules capability */
+    filter_arena_t *arena; /**< Intermediate pictures (video only) */
 };
 
 /**
@@ -89,6 +120,7 @@ static filter_chain_t *filter_chain_NewInner( const filter_owner_t *callbacks,
     chain->b_allow_fmt_out_change = fmt_out_change;
     chain->filter_cap = cap;
     chain->conv_cap = conv_cap;
+    chain->arena = NULL;
     return chain;
 }
 
@@ -106,12 +138,207 @@ filter_chain_t *filter_chain_New( vlc_object_t *obj, const char *cap,
     return filter_chain_NewInner( &callbacks, cap, NULL, false, NULL, cat );
 }
 
+static filter_arena_t *ArenaNew( void )
+{
+    filter_arena_t *arena = malloc( sizeof (*arena) );
+    if( unlikely(arena == NULL) )
+        return NULL;
+
+    vlc_mutex_init( &arena->lock );
+    atomic_init( &arena->refs, 1 );
+    arena->dead = false;
+    arena->use_count = 0;
+    arena->bucket_count = 0;
+    arena->destroy = NULL;
+    arena->allocated = 0;
+    arena->recycled = 0;
+    return arena;
+}
+
+/** Hands a picture back to its original allocator */
+static void ArenaDestroyPicture( filter_arena_t *arena, picture_t *pic )
+{
+    picture_priv_t *priv = (picture_priv_t *)pic;
+
+    assert( arena->destroy != NULL );
+    priv->gc.destroy = arena->destroy;
+    priv->gc.opaque = NULL;
+    priv->gc.destroy( pic );
+}
+
+static void ArenaBucketClean( filter_arena_t *arena,
+                              filter_arena_bucket_t *bucket )
+{
+    picture_t *pic = bucket->free;
+
+    while( pic != NULL )
+    {
+        picture_t *next = pic->p_next;
+
+        ArenaDestroyPicture( arena, pic );
+        pic = next;
+    }
+    bucket->free = NULL;
+    bucket->free_count = 0;
+}
+
+static void ArenaRelease( filter_arena_t *arena )
+{
+    if( atomic_fetch_sub( &arena->refs, 1 ) != 1 )
+        return;
+
+    for( unsigned i = 0; i < arena->bucket_count; i++ )
+        ArenaBucketClean( arena, &arena->bucket[i] );
+    vlc_mutex_destroy( &arena->lock );
+    free( arena );
+}
+
+static bool ArenaFormatMatch( const video_format_t *a, const video_format_t *b )
+{
+    return a->i_chroma == b->i_chroma
+        && a->i_width == b->i_width && a->i_height == b->i_height
+        && a->i_x_offset == b->i_x_offset && a->i_y_offset == b->i_y_offset
+        && a->i_visible_width == b->i_visible_width
+        && a->i_visible_height == b->i_visible_height
+        && a->i_sar_num == b->i_sar_num && a->i_sar_den == b->i_sar_den;
+}
+
+/** Finds the bucket of a format, the arena lock must be held */
+static filter_arena_bucket_t *ArenaFind( filter_arena_t *arena,
+                                         const video_format_t *fmt )
+{
+    for( unsigned i = 0; i < arena->bucket_count; i++ )
+        if( ArenaFormatMatch( &arena->bucket[i].key, fmt ) )
+            return &arena->bucket[i];
+    return NULL;
+}
+
+/** Finds a bucket with the same planes layout, the arena lock must be held.
+ * The picture format itself may have been altered by its users. */
+static filter_arena_bucket_t *ArenaFindLayout( filter_arena_t *arena,
+                                               const video_format_t *fmt )
+{
+    for( unsigned i = 0; i < arena->bucket_count; i++ )
+    {
+        const video_format_t *ref = &arena->bucket[i].fmt;
+
+        if( ref->i_chroma == fmt->i_chroma
+         && ref->i_width == fmt->i_width && ref->i_height == fmt->i_height )
+            return &arena->bucket[i];
+    }
+    return NULL;
+}
+
+static void ArenaRecyclePicture( picture_t *pic )
+{
+    picture_priv_t *priv = (picture_priv_t *)pic;
+    filter_arena_t *arena = priv->gc.opaque;
+
+    vlc_mutex_lock( &arena->lock );
+    filter_arena_bucket_t *bucket = arena->dead ? NULL
+                                  : ArenaFindLayout( arena, &pic->format );
+    if( bucket != NULL && bucket->free_count < ARENA_MAX_FREE )
+    {
+        pic->p_next = bucket->free;
+        bucket->free = pic;
+        bucket->free_count++;
+        pic = NULL;
+    }
+    vlc_mutex_unlock( &arena->lock );
+
+    if( pic != NULL ) /* Format no longer in use, or too many spares */
+        ArenaDestroyPicture( arena, pic );
+    ArenaRelease( arena );
+}
+
+/** Gets a picture from the arena, or allocates one */
+static picture_t *ArenaGetPicture( filter_arena_t *arena,
+                                   const video_format_t *fmt )
+{
+    picture_t *pic = NULL;
+
+    vlc_mutex_lock( &arena->lock );
+    filter_arena_bucket_t *bucket = ArenaFind( arena, fmt );
+    if( bucket != NULL )
+    {
+        pic = bucket->free;
+        if( pic != NULL )
+        {
+            bucket->free = pic->p_next;
+            bucket->free_count--;
+            /* Only the planes layout is shared with the bucket format, the
+             * other properties (colorimetry, orientation...) must be the
+             * requested ones, as picture_NewFromFormat() would set them */
+            pic->format = *fmt;
+            pic->format.i_chroma = bucket->fmt.i_chroma;
+            pic->format.i_bits_per_pixel = bucket->fmt.i_bits_per_pixel;
+            pic->format.i_sar_num = bucket->fmt.i_sar_num;
+            pic->format.i_sar_den = bucket->fmt.i_sar_den;
+            arena->recycled++;
+        }
+        bucket->last_use = ++arena->use_count;
+    }
+    vlc_mutex_unlock( &arena->lock );
+
+    if( pic != NULL )
+    {
+        picture_priv_t *priv = (picture_priv_t *)pic;
+
+        picture_Reset( pic );
+        pic->p_next = NULL;
+        atomic_store( &priv->gc.refs, 1 );
+        atomic_fetch_add( &arena->refs, 1 );
+        return pic;
+    }
+
+    pic = picture_NewFromFormat( fmt );
+    if( pic == NULL )
+        return NULL;
+
+    picture_priv_t *priv = (picture_priv_t *)pic;
+    assert( priv->gc.opaque == NULL );
+
+    vlc_mutex_lock( &arena->lock );
+    /* All pictures come from picture_NewFromFormat(), so they share the
+     * same destructor */
+    assert( arena->destroy == NULL || arena->destroy == priv->gc.destroy );
+    arena->destroy = priv->gc.destroy;
+    arena->allocated++;
+    if( ArenaFind( arena, fmt ) == NULL )
+    {
+        if( arena->bucket_count < ARENA_BUCKETS )
+            bucket = &arena->bucket[arena->bucket_count++];
+        else
+        {   /* Evict the least recently used format */
+            bucket = &arena->bucket[0];
+            for( unsigned i = 1; i < ARENA_BUCKETS; i++ )
+                if( arena->bucket[i].last_use < bucket->last_use )
+                    bucket = &arena->bucket[i];
+            ArenaBucketClean( arena, bucket );
+        }
+        bucket->key = *fmt;
+        bucket->fmt = pic->format;
+        bucket->free = NULL;
+        bucket->free_count = 0;
+        bucket->last_use = ++arena->use_count;
+    }
+    vlc_mutex_unlock( &arena->lock );
+
+    /* Released pictures come back to the arena instead of being freed */
+    priv->gc.destroy = ArenaRecyclePicture;
+    priv->gc.opaque = arena;
+    atomic_fetch_add( &arena->refs, 1 );
+    return pic;
+}
+
 /** Chained filter picture allocator function */
 static picture_t *filter_chain_VideoBufferNew( filter_t *filter )
 {
     if( chained(filter)->next != NULL )
     {
-        picture_t *pic = picture_NewFromFormat( &filter->fmt_out.video );
+        filter_chain_t *chain = filter->owner.sys;
+        picture_t *pic = ArenaGetPicture( chain->arena,
+                                          &filter->fmt_out.video );
         if( pic == NULL )
             msg_Err( filter, "Failed to allocate picture" );
         return pic;
@@ -139,8 +366,19 @@ filter_chain_t *filter_chain_NewVideo( vlc_object_t *obj, bool allow_change,
         },
     };
 
-    return filter_chain_NewInner( &callbacks, "video filter",
+    filter_arena_t *arena = ArenaNew();
+    if( unlikely(arena == NULL) )
+        return NULL;
+
+    filter_chain_t *chain = filter_chain_NewInner( &callbacks, "video filter",
                                   "video converter", allow_change, owner, VIDEO_ES );
+    if( unlikely(chain == NULL) )
+    {
+        ArenaRelease( arena );
+        return NULL;
+    }
+    chain->arena = arena;
+    return chain;
 }
 
 /**
@@ -154,6 +392,20 @@ void filter_chain_Delete( filter_chain_t *p_chain )
     es_format_Clean( &p_chain->fmt_in );
     es_format_Clean( &p_chain->fmt_out );
 
+    filter_arena_t *arena = p_chain->arena;
+    if( arena != NULL )
+    {
+        vlc_mutex_lock( &arena->lock );
+        msg_Dbg( (vlc_object_t *)p_chain->callbacks.sys,
+                 "filter chain pictures: %"PRIu64" allocated, "
+                 "%"PRIu64" recycled", arena->allocated, arena->recycled );
+        arena->dead = true;
+        for( unsigned i = 0; i < arena->bucket_count; i++ )
+            ArenaBucketClean( arena, &arena->bucket[i] );
+        vlc_mutex_unlock( &arena->lock );
+        ArenaRelease( arena );
+    }
+
     free( p_chain );
 }
 /**
@@ -26,7 +26,7 @@
 # include "config.h"
 #endif
 #include <assert.h>
-#include <limits.h>
+#include <stdalign.h>
 #include <stdlib.h>
 
 #include <vlc_common.h>
@@ -34,21 +34,42 @@
 #include <vlc_atomic.h>
 #include "picture.h"
 
-#define POOL_MAX (CHAR_BIT * sizeof (unsigned long long))
+/* Free pictures are kept in a lock-free LIFO of slot indexes. The list head
+ * packs a modification tag (high half) with the 1-based index of the first
+ * free slot (low half, 0 meaning empty), so that concurrent pops cannot
+ * suffer from the ABA problem. */
+#define POOL_INDEX_MASK 0xffffffffULL
+#define POOL_TAG_ONE    (POOL_INDEX_MASK + 1)
 
-static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
+/* Keep the contended atomic variables away from each other */
+#define POOL_CACHE_LINE 64
+
+typedef struct
+{
+    picture_t      *picture;
+    picture_pool_t *pool;
+    atomic_uint     next; /**< 1-based index of the next free slot */
+} picture_pool_slot_t;
 
 struct picture_pool_t {
     int       (*pic_lock)(picture_t *);
     void      (*pic_unlock)(picture_t *);
     vlc_mutex_t lock;
     vlc_cond_t  wait;
+    unsigned    picture_count;
+    atomic_bool canceled;
+
+    alignas (POOL_CACHE_LINE) atomic_ullong free_head;
+    atomic_uint   waiters;
+
+    alignas (POOL_CACHE_LINE) atomic_uint refs;
+    atomic_uint   in_use;
+    atomic_uint   peak;
+    atomic_ulong  gets;
+    atomic_ulong  misses;
+    atomic_ulong  waits;
 
-    bool               canceled;
-    unsigned long long available;
-    atomic_ushort      refs;
-    unsigned short     picture_count;
-    picture_t  *picture[];
+    alignas (POOL_CACHE_LINE) picture_pool_slot_t slot[];
 };
 
 static void picture_pool_Destroy(picture_pool_t *pool)
@@ -64,17 +85,65 @@ static void picture_pool_Destroy(picture_pool_t *pool)
 void picture_pool_Release(picture_pool_t *pool)
 {
     for (unsigned i = 0; i < pool->picture_count; i++)
-        picture_Release(pool->picture[i]);
+        picture_Release(pool->slot[i].picture);
     picture_pool_Destroy(pool);
 }
 
+/** Takes a free slot, returns its offset or -1 if there is none */
+static int picture_pool_Pop(picture_pool_t *pool)
+{
+    unsigned long long head = atomic_load(&pool->free_head);
+    unsigned long long next;
+    unsigned index;
+
+    do
+    {
+        index = head & POOL_INDEX_MASK;
+        if (index == 0)
+            return -1;
+        next = ((head & ~POOL_INDEX_MASK) + POOL_TAG_ONE)
+             | atomic_load(&pool->slot[index - 1].next);
+    }
+    while (!atomic_compare_exchange_weak(&pool->free_head, &head, next));
+
+    return index - 1;
+}
+
+/** Gives a slot back to the free list */
+static void picture_pool_Push(picture_pool_t *pool, unsigned offset)
+{
+    unsigned long long head = atomic_load(&pool->free_head);
+    unsigned long long next;
+
+    do
+    {
+        atomic_store(&pool->slot[offset].next, head & POOL_INDEX_MASK);
+        next = ((head & ~POOL_INDEX_MASK) + POOL_TAG_ONE) | (offset + 1);
+    }
+    while (!atomic_compare_exchange_weak(&pool->free_head, &head, next));
+}
+
+/** Gives a slot back and wakes up picture_pool_Wait() if needed */
+static void picture_pool_PushSignal(picture_pool_t *pool, unsigned offset)
+{
+    picture_pool_Push(pool, offset);
+
+    /* Waiters register under the lock before checking the free list again,
+     * so either they see the slot or we see them. */
+    if (atomic_load(&pool->waiters) > 0)
+    {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
+
 static void picture_pool_ReleasePicture(picture_t *clone)
 {
     picture_priv_t *priv = (picture_priv_t *)clone;
-    uintptr_t sys = (uintptr_t)priv->gc.opaque;
-    picture_pool_t *pool = (void *)(sys & ~(POOL_MAX - 1));
-    unsigned offset = sys & (POOL_MAX - 1);
-    picture_t *picture = pool->picture[offset];
+    picture_pool_slot_t *slot = priv->gc.opaque;
+    picture_pool_t *pool = slot->pool;
+    picture_t *picture = slot->picture;
 
     free(clone);
 
@@ -82,11 +151,8 @@ static void picture_pool_ReleasePicture(picture_t *clone)
         pool->pic_unlock(picture);
     picture_Release(picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
+    atomic_fetch_sub(&pool->in_use, 1);
+    picture_pool_PushSignal(pool, slot - pool->slot);
 
     picture_pool_Destroy(pool);
 }
@@ -94,8 +160,8 @@ static void picture_pool_ReleasePicture(picture_t *clone)
 static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
                                             unsigned offset)
 {
-    picture_t *picture = pool->picture[offset];
-    uintptr_t sys = ((uintptr_t)pool) + offset;
+    picture_pool_slot_t *slot = &pool->slot[offset];
+    picture_t *picture = slot->picture;
     picture_resource_t res = {
         .p_sys = picture->p_sys,
         .pf_destroy = picture_pool_ReleasePicture,
@@ -109,22 +175,42 @@ static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
 
     picture_t *clone = picture_NewFromResource(&picture->format, &res);
     if (likely(clone != NULL)) {
-        ((picture_priv_t *)clone)->gc.opaque = (void *)sys;
+        ((picture_priv_t *)clone)->gc.opaque = slot;
         picture_Hold(picture);
     }
     return clone;
 }
 
+/** Turns a free slot into a picture handed out to the caller */
+static picture_t *picture_pool_Take(picture_pool_t *pool, unsigned offset)
+{
+    picture_t *clone = picture_pool_ClonePicture(pool, offset);
+    if (unlikely(clone == NULL)) {
+        picture_pool_PushSignal(pool, offset);
+        return NULL;
+    }
+    assert(clone->p_next == NULL);
+    atomic_fetch_add(&pool->refs, 1);
+    atomic_fetch_add(&pool->gets, 1);
+
+    unsigned in_use = atomic_fetch_add(&pool->in_use, 1) + 1;
+    unsigned peak = atomic_load(&pool->peak);
+    while (in_use > peak
+        && !atomic_compare_exchange_weak(&pool->peak, &peak, in_use));
+    return clone;
+}
+
 picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg)
 {
-    if (unlikely(cfg->picture_count > POOL_MAX))
+    if (unlikely(cfg->picture_count >= POOL_INDEX_MASK))
         return NULL;
 
     picture_pool_t *pool;
-    size_t size = sizeof (*pool) + cfg->picture_count * sizeof (picture_t *);
+    size_t size = sizeof (*pool)
+                + cfg->picture_count * sizeof (picture_pool_slot_t);
 
-    size += (-size) & (POOL_MAX - 1);
-    pool = aligned_alloc(POOL_MAX, size);
+    size += (-size) & (POOL_CACHE_LINE - 1);
+    pool = aligned_alloc(POOL_CACHE_LINE, size);
     if (unlikely(pool == NULL))
         return NULL;
 
@@ -132,15 +218,24 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
     pool->pic_unlock = cfg->unlock;
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
-    if (cfg->picture_count == POOL_MAX)
-        pool->available = ~0ULL;
-    else
-        pool->available = (1ULL << cfg->picture_count) - 1;
-    atomic_init(&pool->refs,  1);
     pool->picture_count = cfg->picture_count;
-    memcpy(pool->picture, cfg->picture,
-           cfg->picture_count * sizeof (picture_t *));
-    pool->canceled = false;
+    atomic_init(&pool->canceled, false);
+    atomic_init(&pool->waiters, 0);
+    atomic_init(&pool->refs,  1);
+    atomic_init(&pool->in_use, 0);
+    atomic_init(&pool->peak, 0);
+    atomic_init(&pool->gets, 0);
+    atomic_init(&pool->misses, 0);
+    atomic_init(&pool->waits, 0);
+
+    /* Chain all slots in order, so that pictures come out first to last */
+    for (unsigned i = 0; i < cfg->picture_count; i++) {
+        pool->slot[i].picture = cfg->picture[i];
+        pool->slot[i].pool = pool;
+        atomic_init(&pool->slot[i].next,
+                    (i + 1 < cfg->picture_count) ? i + 2 : 0);
+    }
+    atomic_init(&pool->free_head, cfg->picture_count > 0 ? 1 : 0);
     return pool;
 }
 
@@ -201,96 +296,85 @@ error:
     return NULL;
 }
 
-/** Find next (bit) set */
-static int fnsll(unsigned long long x, unsigned i)
-{
-    if (i >= CHAR_BIT * sizeof (x))
-        return 0;
-    return ffsll(x & ~((1ULL << i) - 1));
-}
-
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    if (pool->canceled)
-    {
-        vlc_mutex_unlock(&pool->lock);
+    if (atomic_load(&pool->canceled))
         return NULL;
-    }
 
-    for (unsigned i = ffsll(pool->available); i; i = fnsll(pool->available, i))
-    {
-        pool->available &= ~(1ULL << (i - 1));
-        vlc_mutex_unlock(&pool->lock);
+    /* Slots whose picture could not be locked are kept aside, so that the
+     * other free pictures get tried, then given back. */
+    unsigned busy = 0;
+    picture_t *clone = NULL;
+    int offset;
 
-        picture_t *picture = pool->picture[i - 1];
+    while ((offset = picture_pool_Pop(pool)) >= 0)
+    {
+        picture_t *picture = pool->slot[offset].picture;
 
         if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-            vlc_mutex_lock(&pool->lock);
-            pool->available |= 1ULL << (i - 1);
+            atomic_store(&pool->slot[offset].next, busy);
+            busy = offset + 1;
             continue;
         }
 
-        picture_t *clone = picture_pool_ClonePicture(pool, i - 1);
-        if (clone != NULL) {
-            assert(clone->p_next == NULL);
-            atomic_fetch_add(&pool->refs, 1);
-        }
-        return clone;
+        clone = picture_pool_Take(pool, offset);
+        break;
     }
 
-    vlc_mutex_unlock(&pool->lock);
-    return NULL;
+    while (busy != 0)
+    {
+        unsigned next = atomic_load(&pool->slot[busy - 1].next);
+        picture_pool_PushSignal(pool, busy - 1);
+        busy = next;
+    }
+
+    if (offset < 0)
+        atomic_fetch_add(&pool->misses, 1);
+    return clone;
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    unsigned i;
+    assert(atomic_load(&pool->refs) > 0);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-
-    while (pool->available == 0)
+    int offset = picture_pool_Pop(pool);
+    if (offset < 0)
     {
-        if (pool->canceled)
+        atomic_fetch_add(&pool->waits, 1);
+
+        vlc_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->waiters, 1);
+        while ((offset = picture_pool_Pop(pool)) < 0)
         {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
+            if (atomic_load(&pool->canceled))
+                break;
+            vlc_cond_wait(&pool->wait, &pool->lock);
         }
-        vlc_cond_wait(&pool->wait, &pool->lock);
-    }
+        atomic_fetch_sub(&pool->waiters, 1);
+        vlc_mutex_unlock(&pool->lock);
 
-    i = ffsll(pool->available);
-    assert(i > 0);
-    pool->available &= ~(1ULL << (i - 1));
-    vlc_mutex_unlock(&pool->lock);
+        if (offset < 0)
+            return NULL;
+    }
 
-    picture_t *picture = pool->picture[i - 1];
+    picture_t *picture = pool->slot[offset].picture;
 
     if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-        vlc_mutex_lock(&pool->lock);
-        pool->available |= 1ULL << (i - 1);
-        vlc_cond_signal(&pool->wait);
-        vlc_mutex_unlock(&pool->lock);
+        picture_pool_PushSignal(pool, offset);
         return NULL;
     }
 
-    picture_t *clone = picture_pool_ClonePicture(pool, i - 1);
-    if (clone != NULL) {
-        assert(clone->p_next == NULL);
-        atomic_fetch_add(&pool->refs, 1);
-    }
-    return clone;
+    return picture_pool_Take(pool, offset);
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
     vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    pool->canceled = canceled;
+    atomic_store(&pool->canceled, canceled);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
@@ -305,9 +389,8 @@ bool picture_pool_OwnsPic(picture_pool_t *pool, picture_t *pic)
         priv = (picture_priv_t *)pic;
     }
 
-    uintptr_t sys = (uintptr_t)priv->gc.opaque;
-    picture_pool_t *picpool = (void *)(sys & ~(POOL_MAX - 1));
-    return pool == picpool;
+    const picture_pool_slot_t *slot = priv->gc.opaque;
+    return pool == slot->pool;
 }
 
 unsigned picture_pool_GetSize(const picture_pool_t *pool)
@@ -321,5 +404,14 @@ void picture_pool_Enum(picture_pool_t *pool, void (*cb)(void *, picture_t *),
     /* NOTE: So far, the pictures table cannot change after the pool is created
      * so there is no need to lock the pool mutex here. */
     for (unsigned i = 0; i < pool->picture_count; i++)
-        cb(opaque, pool->picture[i]);
+        cb(opaque, pool->slot[i].picture);
+}
+
+void picture_pool_GetStats(picture_pool_t *pool, picture_pool_stats_t *stats)
+{
+    stats->gets   = atomic_load(&pool->gets);
+    stats->misses = atomic_load(&pool->misses);
+    stats->waits  = atomic_load(&pool->waits);
+    stats->in_use = atomic_load(&pool->in_use);
+    stats->peak   = atomic_load(&pool->peak);
 }
@@ -106,6 +106,47 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+static void test_large(void)
+{
+    const unsigned count = 200; /* more than fits in a 64-bits mask */
+    picture_t *pics[count];
+    picture_pool_stats_t stats;
+
+    pool = picture_pool_NewFromFormat(&fmt, count);
+    assert(pool != NULL);
+    assert(picture_pool_GetSize(pool) == count);
+
+    for (unsigned i = 0; i < count; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+
+    picture_pool_GetStats(pool, &stats);
+    assert(stats.gets == count);
+    assert(stats.misses == 1);
+    assert(stats.in_use == count);
+    assert(stats.peak == count);
+
+    for (unsigned i = 0; i < count; i += 2)
+        picture_Release(pics[i]);
+    for (unsigned i = 0; i < count; i += 2) {
+        pics[i] = picture_pool_Wait(pool);
+        assert(pics[i] != NULL);
+    }
+
+    picture_pool_GetStats(pool, &stats);
+    assert(stats.waits == 0);
+    assert(stats.peak == count);
+
+    for (unsigned i = 0; i < count; i++)
+        picture_Release(pics[i]);
+
+    picture_pool_GetStats(pool, &stats);
+    assert(stats.in_use == 0);
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -122,6 +163,7 @@ int main(void)
 
     test(false);
     test(true);
+    test_large();
 
     return 0;
 }
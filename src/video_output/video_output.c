@@ -152,6 +152,9 @@ static vout_thread_t *VoutCreate(vlc_object_t *object,
     /* Initialize subpicture unit */
     vout->p->spu = spu_Create(vout, vout);
 
+    vout->p->is_latest_only = var_InheritBool(vout, "video-latest-frame");
+    atomic_init(&vout->p->decoder_latest, (uintptr_t)NULL);
+
     vout->p->title.show     = var_InheritBool(vout, "video-title-show");
     vout->p->title.timeout  = var_InheritInteger(vout, "video-title-timeout");
     vout->p->title.position = var_InheritInteger(vout, "video-title-position");
@@ -336,6 +339,9 @@ void vout_Flush(vout_thread_t *vout, vlc_tick_t date)
 
 bool vout_IsEmpty(vout_thread_t *vout)
 {
+    if (vout->p->is_latest_only)
+        return atomic_load(&vout->p->decoder_latest) == (uintptr_t)NULL;
+
     picture_t *picture = picture_fifo_Peek(vout->p->decoder_fifo);
     if (picture)
         picture_Release(picture);
@@ -427,7 +433,22 @@ void vout_PutPicture(vout_thread_t *vout, picture_t *picture)
     picture->p_next = NULL;
     if (picture_pool_OwnsPic(vout->p->decoder_pool, picture))
     {
-        picture_fifo_Push(vout->p->decoder_fifo, picture);
+        if (vout->p->is_latest_only)
+        {
+            /* Replace the pending picture, if any: it was never displayed
+             * and is now stale. Only wake the thread when the slot was
+             * empty, it will pick the newest picture up anyway. */
+            picture_t *stale = (picture_t *)
+                atomic_exchange(&vout->p->decoder_latest, (uintptr_t)picture);
+            if (stale != NULL)
+            {
+                picture_Release(stale);
+                vout_statistic_AddLost(&vout->p->statistic, 1);
+                return;
+            }
+        }
+        else
+            picture_fifo_Push(vout->p->decoder_fifo, picture);
 
         vout_control_Wake(&vout->p->control);
     }
@@ -844,6 +865,38 @@ static void ThreadChangeFilters(vout_thread_t *vout,
 }
 
 
+/* The latest-frame mode hands pictures over through a single atomic slot.
+ * The regular mode keeps the locked picture FIFO rather than a lock-free
+ * ring: flushing below/above a date and offsetting the dates on pause
+ * rewrite queued pictures from the vout thread, and vout_IsEmpty() peeks
+ * from the decoder thread, so neither side would be a single producer or
+ * consumer. The FIFO lock only covers a pointer append or removal. */
+static picture_t *ThreadTakeLatest(vout_thread_t *vout)
+{
+    return (picture_t *)atomic_exchange(&vout->p->decoder_latest,
+                                        (uintptr_t)NULL);
+}
+
+static void ThreadPutBackLatest(vout_thread_t *vout, picture_t *picture)
+{
+    uintptr_t expected = (uintptr_t)NULL;
+
+    /* A newer picture may have been published in the meantime */
+    if (!atomic_compare_exchange_strong(&vout->p->decoder_latest, &expected,
+                                        (uintptr_t)picture))
+    {
+        picture_Release(picture);
+        vout_statistic_AddLost(&vout->p->statistic, 1);
+    }
+}
+
+static picture_t *ThreadPopDecoded(vout_thread_t *vout)
+{
+    if (vout->p->is_latest_only)
+        return ThreadTakeLatest(vout);
+    return picture_fifo_Pop(vout->p->decoder_fifo);
+}
+
 /* */
 static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool frame_by_frame)
 {
@@ -859,7 +912,7 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool fra
         if (reuse && vout->p->displayed.decoded) {
             decoded = picture_Hold(vout->p->displayed.decoded);
         } else {
-            decoded = picture_fifo_Pop(vout->p->decoder_fifo);
+            decoded = ThreadPopDecoded(vout);
             if (decoded) {
                 if (is_late_dropped && !decoded->b_force) {
                     vlc_tick_t late_threshold;
@@ -1299,6 +1352,13 @@ static void ThreadChangePause(vout_thread_t *vout, bool is_paused, vlc_tick_t da
         if (vout->p->step.last > VLC_TICK_INVALID)
             vout->p->step.last += duration;
         picture_fifo_OffsetDate(vout->p->decoder_fifo, duration);
+        if (vout->p->is_latest_only) {
+            picture_t *latest = ThreadTakeLatest(vout);
+            if (latest) {
+                latest->date += duration;
+                ThreadPutBackLatest(vout, latest);
+            }
+        }
         if (vout->p->displayed.decoded)
             vout->p->displayed.decoded->date += duration;
         spu_OffsetSubtitleDate(vout->p->spu, duration);
@@ -1336,6 +1396,16 @@ static void ThreadFlush(vout_thread_t *vout, bool below, vlc_tick_t date)
     }
 
     picture_fifo_Flush(vout->p->decoder_fifo, date, below);
+    if (vout->p->is_latest_only) {
+        picture_t *latest = ThreadTakeLatest(vout);
+        if (latest) {
+            if (( below && latest->date <= date) ||
+                (!below && latest->date >= date))
+                picture_Release(latest);
+            else
+                ThreadPutBackLatest(vout, latest);
+        }
+    }
     vout_FilterFlush(vout->p->display.vd);
 }
 
@@ -1591,6 +1661,9 @@ static void ThreadStop(vout_thread_t *vout, vout_display_state_t *state)
 
     if (vout->p->decoder_fifo)
         picture_fifo_Delete(vout->p->decoder_fifo);
+    picture_t *latest = ThreadTakeLatest(vout);
+    if (latest)
+        picture_Release(latest);
     assert(!vout->p->decoder_pool);
 }
 
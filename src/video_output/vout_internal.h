@@ -116,6 +116,7 @@ struct vout_thread_sys_t
 
     /* */
     bool            is_late_dropped;
+    bool            is_latest_only;   /**< only keep the newest decoded picture */
 
     /* Video filter2 chain */
     struct {
@@ -135,6 +136,7 @@ struct vout_thread_sys_t
     picture_pool_t  *display_pool;
     picture_pool_t  *decoder_pool;
     picture_fifo_t  *decoder_fifo;
+    atomic_uintptr_t decoder_latest;  /**< picture_t * handed over lock-free */
     vout_chrono_t   render;           /**< picture render time estimator */
 };
 
@@ -181,6 +181,12 @@ void vout_EndWrapper(vout_thread_t *vout)
 
     assert(vout->p->decoder_pool && vout->p->private_pool);
 
+    picture_pool_stats_t stats;
+    picture_pool_GetStats(sys->decoder_pool, &stats);
+    msg_Dbg(vout, "decoder pool: %lu pictures, %lu misses, %lu waits, "
+            "peak usage %u/%u", stats.gets, stats.misses, stats.waits,
+            stats.peak, picture_pool_GetSize(sys->decoder_pool));
+
     picture_pool_Release(sys->private_pool);
 
     if (sys->decoder_pool != sys->display_pool)
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * channel_matrix.c: channel mixing kernels test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include "../modules/audio_filter/channel_mixer/matrix.h"
+#include "../modules/audio_filter/channel_mixer/matrix.c"
+
+/* One second of 7.1 at 192 kHz */
+#define FRAMES 192000
+#define ROUNDS 10
+
+static void test_kernels( unsigned cpu )
+{
+    float coefs[AOUT_CHAN_MAX * AOUT_CHAN_MAX];
+    float src[37 * AOUT_CHAN_MAX];
+    /* Guard area after the output to catch overflows */
+    float ref[37 * AOUT_CHAN_MAX + 8], out[37 * AOUT_CHAN_MAX + 8];
+
+    for( size_t i = 0; i < ARRAY_SIZE(src); i++ )
+        src[i] = (rand() - RAND_MAX / 2) / (float)RAND_MAX;
+
+    for( unsigned in = 1; in <= AOUT_CHAN_MAX; in++ )
+        for( unsigned o = 1; o <= AOUT_CHAN_MAX; o++ )
+        {
+            /* Sparse weights, as in actual layouts */
+            for( unsigned i = 0; i < in * o; i++ )
+                coefs[i] = (rand() % 3) ? 0.f : rand() / (float)RAND_MAX;
+
+            channel_matrix_t m_ref, m;
+            channel_matrix_Init( &m_ref, coefs, in, o, 0 );
+            channel_matrix_Init( &m, coefs, in, o, cpu );
+
+            for( size_t n = 0; n <= 37; n++ )
+            {
+                for( size_t i = 0; i < ARRAY_SIZE(ref); i++ )
+                    ref[i] = out[i] = -1.f;
+
+                channel_matrix_Mix( &m_ref, ref, src, n );
+                channel_matrix_Mix( &m, out, src, n );
+
+                for( size_t i = 0; i < ARRAY_SIZE(ref); i++ )
+                    if( fabsf( ref[i] - out[i] ) > 1e-5f )
+                    {
+                        fprintf( stderr, "%s: mismatch for %u to %u channels, "
+                                 "%zu frames at %zu\n", m.name, in, o, n, i );
+                        abort();
+                    }
+            }
+        }
+}
+
+static void benchmark( unsigned cpu )
+{
+    /* 7.1 to stereo, as in the simple channel mixer */
+    static const float coefs[2][8] = {
+        { 1.f, 0.f, .25f, 0.f, .25f, 0.f, .7071f, 0.f },
+        { 0.f, 1.f, 0.f, .25f, 0.f, .25f, .7071f, 0.f },
+    };
+    float *src = malloc( FRAMES * 8 * sizeof(*src) );
+    float *dst = malloc( FRAMES * 2 * sizeof(*dst) );
+    assert( src && dst );
+
+    for( size_t i = 0; i < FRAMES * 8; i++ )
+        src[i] = (i % 1001) / 1001.f;
+
+    channel_matrix_t m;
+    channel_matrix_Init( &m, &coefs[0][0], 8, 2, cpu );
+
+    mtime_t i_start = mdate();
+    for( int i = 0; i < ROUNDS; i++ )
+        channel_matrix_Mix( &m, dst, src, FRAMES );
+    mtime_t i_time = (mdate() - i_start) / ROUNDS;
+
+    printf( "channel matrix %s: 1 s of 7.1 at 192 kHz to stereo in "
+            "%"PRId64" us\n", m.name, i_time );
+
+    free( dst );
+    free( src );
+}
+
+int main( void )
+{
+    srand( 42 );
+    test_kernels( vlc_CPU() );
+#if defined(CAN_COMPILE_SSE) && defined(CAN_COMPILE_AVX2)
+    /* Also check the SSE kernels on a more capable CPU */
+    test_kernels( vlc_CPU() & ~VLC_CPU_AVX2 );
+#endif
+
+    benchmark( 0 );
+#if defined(CAN_COMPILE_SSE) && defined(CAN_COMPILE_AVX2)
+    if( vlc_CPU() & VLC_CPU_AVX2 )
+        benchmark( vlc_CPU() & ~VLC_CPU_AVX2 );
+#endif
+    benchmark( vlc_CPU() );
+    return 0;
+}
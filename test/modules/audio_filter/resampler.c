@@ -0,0 +1,178 @@
+/*****************************************************************************
+ * resampler.c: audio resamplers test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHANNELS 2
+#define SECONDS  10
+#define FREQ     1000.
+
+/* Resamples a sine wave, and returns the signal to noise ratio in dB */
+static double test_resampler(vlc_object_t *obj, const char *name,
+                             unsigned in_rate, unsigned out_rate, bool exact)
+{
+    filter_t *filter = vlc_object_create(obj, sizeof (*filter));
+    assert(filter != NULL);
+
+    audio_format_t fmt = {
+        .i_format = VLC_CODEC_FL32,
+        .i_rate = in_rate,
+        .i_physical_channels = AOUT_CHANS_STEREO,
+    };
+    aout_FormatPrepare(&fmt);
+    es_format_Init(&filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_in.audio = fmt;
+    fmt.i_rate = out_rate;
+    es_format_Init(&filter->fmt_out, AUDIO_ES, VLC_CODEC_FL32);
+    filter->fmt_out.audio = fmt;
+
+    filter->p_module = module_need(filter, "audio resampler", name, true);
+    if (filter->p_module == NULL)
+    {
+        printf("%s: not available, skipped\n", name);
+        vlc_object_release(filter);
+        return INFINITY;
+    }
+
+    const size_t in_frames = in_rate * SECONDS;
+    const size_t max_frames = (size_t)out_rate * (SECONDS + 1);
+    float *out = malloc(max_frames * CHANNELS * sizeof (*out));
+    size_t out_frames = 0, done = 0;
+    mtime_t total = 0;
+    assert(out != NULL);
+
+    srand(42);
+    while (done < in_frames)
+    {
+        size_t n = 256 + rand() % 2048;
+        if (n > in_frames - done)
+            n = in_frames - done;
+
+        block_t *block = block_Alloc(n * CHANNELS * sizeof (float));
+        assert(block != NULL);
+        block->i_nb_samples = n;
+        block->i_pts = VLC_TS_0 + done * CLOCK_FREQ / in_rate;
+
+        float *p = (float *)block->p_buffer;
+        for (size_t i = 0; i < n; i++)
+            for (unsigned c = 0; c < CHANNELS; c++)
+                *(p++) = .5 * sin(2. * M_PI * FREQ * (done + i) / in_rate + c);
+        done += n;
+
+        mtime_t start = mdate();
+        block = filter->pf_audio_filter(filter, block);
+        total += mdate() - start;
+        if (block == NULL)
+            continue;
+
+        assert(out_frames + block->i_nb_samples <= max_frames);
+        memcpy(out + out_frames * CHANNELS, block->p_buffer,
+               block->i_nb_samples * CHANNELS * sizeof (float));
+        out_frames += block->i_nb_samples;
+        block_Release(block);
+    }
+
+    /* Allow a few frames of latency */
+    const size_t expected = (uint64_t)in_frames * out_rate / in_rate;
+    assert(!exact || out_frames + out_rate / 100 >= expected);
+    assert(out_frames <= expected + 1);
+
+    /* Skip the edges, and allow one sample of delay either way */
+    double best = 0.;
+    for (int delay = -1; delay <= 1; delay++)
+    {
+        double signal = 0., noise = 0.;
+
+        for (size_t i = out_rate / 10; i < out_frames - out_rate / 10; i++)
+            for (unsigned c = 0; c < CHANNELS; c++)
+            {
+                double ref = .5 * sin(2. * M_PI * FREQ * (double)(i + delay)
+                                      / out_rate + c);
+                double d = out[i * CHANNELS + c] - ref;
+
+                signal += ref * ref;
+                noise += d * d;
+            }
+
+        double snr = 10. * log10(signal / noise);
+        if (snr > best)
+            best = snr;
+    }
+
+    printf("%s: %u to %u Hz, %d s in %"PRId64" us, SNR %.1f dB\n", name,
+           in_rate, out_rate, SECONDS, total, best);
+
+    free(out);
+    module_unneed(filter, filter->p_module);
+    es_format_Clean(&filter->fmt_in);
+    es_format_Clean(&filter->fmt_out);
+    vlc_object_release(filter);
+    return best;
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    const char *argv[] = { "--polyphase-quality=2" };
+    libvlc_instance_t *vlc = libvlc_new(1, argv);
+    assert(vlc != NULL);
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+    static const unsigned rates[][2] = {
+        { 44100, 48000 }, { 48000, 44100 }, { 96000, 44100 }, { 8000, 48000 },
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(rates); i++)
+    {
+        double snr = test_resampler(obj, "polyphase", rates[i][0], rates[i][1],
+                                    true);
+        assert(snr > 70.);
+        /* Always built, unlike the other resamplers. It rounds the output
+         * length of each block down, so it loses frames over time. */
+        double ref = test_resampler(obj, "ugly_resampler",
+                                    rates[i][0], rates[i][1], false);
+        assert(snr > ref);
+        test_resampler(obj, "speex", rates[i][0], rates[i][1], true);
+    }
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*****************************************************************************
+ * amplify.c: audio volume kernels test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include "../modules/audio_mixer/amplify.h"
+#include "../modules/audio_mixer/amplify.c"
+
+/* One second of 7.1 at 192 kHz */
+#define SAMPLES (8 * 192000)
+#define ROUNDS  10
+
+static void test_ops( const amplify_ops_t *ref, const amplify_ops_t *ops )
+{
+    const size_t sizes[] = { 0, 1, 3, 7, 8, 15, 16, 17, 33, 1001 };
+    const float volumes[] = { 0.f, 0.25f, 0.5f, 0.999f, 1.f, 1.5f, 2.f };
+    float f_ref[1001], f_out[1001];
+    double d_ref[1001], d_out[1001];
+    int16_t w_ref[1001], w_out[1001];
+    int32_t l_ref[1001], l_out[1001];
+
+    for( size_t v = 0; v < ARRAY_SIZE(volumes); v++ )
+    {
+        const float vol = volumes[v];
+
+        for( size_t i = 0; i < ARRAY_SIZE(sizes); i++ )
+        {
+            const size_t n = sizes[i];
+
+            for( size_t j = 0; j < n; j++ )
+            {
+                f_ref[j] = f_out[j] = (rand() - RAND_MAX / 2) / (float)RAND_MAX;
+                d_ref[j] = d_out[j] = f_ref[j];
+                w_ref[j] = w_out[j] = rand();
+                l_ref[j] = l_out[j] = ((uint32_t)rand() << 1) ^ j;
+            }
+            /* extreme values */
+            if( n > 2 )
+            {
+                w_ref[0] = w_out[0] = INT16_MIN;
+                w_ref[1] = w_out[1] = INT16_MAX;
+                l_ref[0] = l_out[0] = INT32_MIN;
+                l_ref[1] = l_out[1] = INT32_MAX;
+            }
+
+            ref->fl32( f_ref, n, vol );
+            ops->fl32( f_out, n, vol );
+            ref->fl64( d_ref, n, vol );
+            ops->fl64( d_out, n, vol );
+            ref->s16( w_ref, n, lroundf( vol * 0x1.p8f ) );
+            ops->s16( w_out, n, lroundf( vol * 0x1.p8f ) );
+            ref->s32( l_ref, n, lroundf( vol * 0x1.p24f ) );
+            ops->s32( l_out, n, lroundf( vol * 0x1.p24f ) );
+
+            if( memcmp( f_ref, f_out, n * sizeof(*f_ref) )
+             || memcmp( d_ref, d_out, n * sizeof(*d_ref) )
+             || memcmp( w_ref, w_out, n * sizeof(*w_ref) )
+             || memcmp( l_ref, l_out, n * sizeof(*l_ref) ) )
+            {
+                fprintf( stderr, "%s: mismatch for %zu samples at %f\n",
+                         ops->name, n, vol );
+                abort();
+            }
+        }
+    }
+}
+
+static void benchmark( const amplify_ops_t *ops )
+{
+    float *f = malloc( SAMPLES * sizeof(*f) );
+    int16_t *w = malloc( SAMPLES * sizeof(*w) );
+    int32_t *l = malloc( SAMPLES * sizeof(*l) );
+    assert( f && w && l );
+
+    for( size_t i = 0; i < SAMPLES; i++ )
+    {
+        f[i] = i;
+        w[i] = i;
+        l[i] = i << 8;
+    }
+
+    mtime_t i_start = mdate();
+    for( int i = 0; i < ROUNDS; i++ )
+        ops->fl32( f, SAMPLES, .999f );
+    mtime_t i_fl32 = (mdate() - i_start) / ROUNDS;
+
+    i_start = mdate();
+    for( int i = 0; i < ROUNDS; i++ )
+        ops->s16( w, SAMPLES, 255 );
+    mtime_t i_s16 = (mdate() - i_start) / ROUNDS;
+
+    i_start = mdate();
+    for( int i = 0; i < ROUNDS; i++ )
+        ops->s32( l, SAMPLES, (1 << 24) - 1 );
+    mtime_t i_s32 = (mdate() - i_start) / ROUNDS;
+
+    printf( "amplify %s: 1 s of 7.1 at 192 kHz in FL32 %"PRId64" us, "
+            "S16N %"PRId64" us, S32N %"PRId64" us\n", ops->name,
+            i_fl32, i_s16, i_s32 );
+
+    free( l );
+    free( w );
+    free( f );
+}
+
+int main( void )
+{
+    const amplify_ops_t *ref = amplify_GetOps( 0 );
+    const amplify_ops_t *best = amplify_GetOps( vlc_CPU() );
+
+    srand( 42 );
+    test_ops( ref, best );
+#if defined(CAN_COMPILE_SSE2) && defined(CAN_COMPILE_SSE4_1)
+    /* Also check the intermediate kernels on a more capable CPU */
+    test_ops( ref, amplify_GetOps( vlc_CPU() & (VLC_CPU_SSE2|VLC_CPU_SSE4_1) ) );
+    test_ops( ref, amplify_GetOps( vlc_CPU() & VLC_CPU_SSE2 ) );
+#endif
+
+    benchmark( ref );
+    if( best != ref )
+        benchmark( best );
+    return 0;
+}
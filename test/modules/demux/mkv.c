@@ -0,0 +1,359 @@
+/*****************************************************************************
+ * mkv.c: Matroska demuxer SimpleBlock lacing test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+#include <vlc_boxes.h>
+#include <vlc_modules.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Sizes of the frames the demuxer must output, in order. Every byte of the
+ * n-th frame is n: a frame cut at the wrong place does not go unnoticed. */
+static const size_t frame_sizes[] = {
+    10,                 /* no lacing */
+    300, 5, 7,          /* Xiph lacing, with a size over 255 */
+    100, 90, 120, 20,   /* EBML lacing, with negative and positive deltas */
+    16, 16, 16, 16,     /* fixed lacing */
+    0, 1,               /* Xiph lacing, with an empty frame */
+    42,                 /* no lacing, after the invalid blocks */
+};
+#define FRAME_COUNT ARRAY_SIZE(frame_sizes)
+
+/*****************************************************************************
+ * File generation
+ *****************************************************************************/
+static void ebml_id(bo_t *bo, uint32_t id)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+        if (id >> shift)
+            bo_add_8(bo, id >> shift);
+}
+
+/* Starts an element, with an 8 bytes size fixed up by ebml_end() */
+static size_t ebml_start(bo_t *bo, uint32_t id)
+{
+    ebml_id(bo, id);
+    size_t pos = bo->b->i_buffer;
+    bo_add_64be(bo, 0);
+    return pos;
+}
+
+static void ebml_end(bo_t *bo, size_t pos)
+{
+    uint64_t size = bo->b->i_buffer - pos - 8;
+    bo_set_64be(bo, pos, UINT64_C(0x0100000000000000) | size);
+}
+
+static void ebml_uint(bo_t *bo, uint32_t id, uint32_t value)
+{
+    ebml_id(bo, id);
+    bo_add_8(bo, 0x84);
+    bo_add_32be(bo, value);
+}
+
+static void ebml_string(bo_t *bo, uint32_t id, const char *str)
+{
+    ebml_id(bo, id);
+    bo_add_8(bo, 0x80 | strlen(str));
+    bo_add_mem(bo, strlen(str), str);
+}
+
+static void add_frame(bo_t *bo, unsigned n)
+{
+    for (size_t i = 0; i < frame_sizes[n]; i++)
+        bo_add_8(bo, n);
+}
+
+static void add_xiph_size(bo_t *bo, size_t size)
+{
+    for (; size >= 255; size -= 255)
+        bo_add_8(bo, 255);
+    bo_add_8(bo, size);
+}
+
+/* Starts a SimpleBlock of the track 1 with the given lacing */
+static size_t block_start(bo_t *bo, int16_t timecode, unsigned lacing)
+{
+    size_t pos = ebml_start(bo, 0xA3);
+    bo_add_8(bo, 0x81); /* track number */
+    bo_add_16be(bo, timecode);
+    bo_add_8(bo, 0x80 | (lacing << 1)); /* keyframe */
+    return pos;
+}
+
+static block_t *generate_file(void)
+{
+    bo_t bo;
+    if (!bo_init(&bo, 4096))
+        abort();
+
+    size_t ebml = ebml_start(&bo, 0x1A45DFA3);
+    ebml_string(&bo, 0x4282, "matroska"); /* DocType */
+    ebml_uint(&bo, 0x4287, 2); /* DocTypeVersion */
+    ebml_uint(&bo, 0x4285, 2); /* DocTypeReadVersion */
+    ebml_end(&bo, ebml);
+
+    size_t segment = ebml_start(&bo, 0x18538067);
+
+    size_t info = ebml_start(&bo, 0x1549A966);
+    ebml_uint(&bo, 0x2AD7B1, 1000000); /* TimecodeScale */
+    ebml_end(&bo, info);
+
+    size_t tracks = ebml_start(&bo, 0x1654AE6B);
+    size_t entry = ebml_start(&bo, 0xAE);
+    ebml_uint(&bo, 0xD7, 1); /* TrackNumber */
+    ebml_uint(&bo, 0x73C5, 1); /* TrackUID */
+    ebml_uint(&bo, 0x83, 2); /* TrackType: audio */
+    ebml_string(&bo, 0x86, "A_MPEG/L3");
+    size_t audio = ebml_start(&bo, 0xE1);
+    ebml_id(&bo, 0xB5); /* SamplingFrequency */
+    bo_add_8(&bo, 0x84);
+    bo_add_32be(&bo, 0x473B8000); /* 48000.f */
+    ebml_uint(&bo, 0x9F, 2); /* Channels */
+    ebml_end(&bo, audio);
+    ebml_end(&bo, entry);
+    ebml_end(&bo, tracks);
+
+    size_t cluster = ebml_start(&bo, 0x1F43B675);
+    ebml_uint(&bo, 0xE7, 0); /* Timecode */
+
+    size_t block;
+    unsigned n = 0;
+    int16_t timecode = 0;
+
+    /* No lacing */
+    block = block_start(&bo, timecode++, 0);
+    add_frame(&bo, n++);
+    ebml_end(&bo, block);
+
+    /* Xiph lacing */
+    block = block_start(&bo, timecode++, 1);
+    bo_add_8(&bo, 3 - 1);
+    add_xiph_size(&bo, frame_sizes[n]);
+    add_xiph_size(&bo, frame_sizes[n + 1]);
+    for (unsigned i = 0; i < 3; i++)
+        add_frame(&bo, n++);
+    ebml_end(&bo, block);
+
+    /* EBML lacing: 100, then -10 and +30 (biased by 2^13 - 1) */
+    block = block_start(&bo, timecode++, 3);
+    bo_add_8(&bo, 4 - 1);
+    bo_add_8(&bo, 0x80 | 100);
+    bo_add_16be(&bo, 0x4000 | (0x1FFF - 10));
+    bo_add_16be(&bo, 0x4000 | (0x1FFF + 30));
+    for (unsigned i = 0; i < 4; i++)
+        add_frame(&bo, n++);
+    ebml_end(&bo, block);
+
+    /* Fixed lacing */
+    block = block_start(&bo, timecode++, 2);
+    bo_add_8(&bo, 4 - 1);
+    for (unsigned i = 0; i < 4; i++)
+        add_frame(&bo, n++);
+    ebml_end(&bo, block);
+
+    /* Xiph lacing, with an empty first frame */
+    block = block_start(&bo, timecode++, 1);
+    bo_add_8(&bo, 2 - 1);
+    add_xiph_size(&bo, frame_sizes[n]);
+    for (unsigned i = 0; i < 2; i++)
+        add_frame(&bo, n++);
+    ebml_end(&bo, block);
+
+    /* Invalid blocks, to be dropped whole */
+
+    /* Xiph lace size truncated by the end of the block */
+    block = block_start(&bo, timecode++, 1);
+    bo_add_8(&bo, 2 - 1);
+    bo_add_8(&bo, 255);
+    bo_add_8(&bo, 255);
+    ebml_end(&bo, block);
+
+    /* Xiph lace size larger than the block */
+    block = block_start(&bo, timecode++, 1);
+    bo_add_8(&bo, 2 - 1);
+    bo_add_8(&bo, 200);
+    for (unsigned i = 0; i < 50; i++)
+        bo_add_8(&bo, 0xEE);
+    ebml_end(&bo, block);
+
+    /* EBML lace size truncated by the end of the block */
+    block = block_start(&bo, timecode++, 3);
+    bo_add_8(&bo, 2 - 1);
+    bo_add_8(&bo, 0x40);
+    ebml_end(&bo, block);
+
+    /* EBML lace sizes larger than the block */
+    block = block_start(&bo, timecode++, 3);
+    bo_add_8(&bo, 3 - 1);
+    bo_add_8(&bo, 0x80 | 20);
+    bo_add_8(&bo, 0x80 | (0x3F + 40));
+    for (unsigned i = 0; i < 50; i++)
+        bo_add_8(&bo, 0xEE);
+    ebml_end(&bo, block);
+
+    /* EBML lace size going negative */
+    block = block_start(&bo, timecode++, 3);
+    bo_add_8(&bo, 3 - 1);
+    bo_add_8(&bo, 0x80 | 10);
+    bo_add_8(&bo, 0x80 | (0x3F - 20));
+    for (unsigned i = 0; i < 50; i++)
+        bo_add_8(&bo, 0xEE);
+    ebml_end(&bo, block);
+
+    /* Fixed lacing not dividing the block */
+    block = block_start(&bo, timecode++, 2);
+    bo_add_8(&bo, 4 - 1);
+    for (unsigned i = 0; i < 50; i++)
+        bo_add_8(&bo, 0xEE);
+    ebml_end(&bo, block);
+
+    /* The demuxer goes on after the invalid blocks */
+    block = block_start(&bo, timecode++, 0);
+    add_frame(&bo, n++);
+    ebml_end(&bo, block);
+    assert(n == FRAME_COUNT);
+
+    ebml_end(&bo, cluster);
+    ebml_end(&bo, segment);
+    return bo.b;
+}
+
+/*****************************************************************************
+ * ES output checking the frames
+ *****************************************************************************/
+struct test_es_out
+{
+    es_out_t out;
+    unsigned count;
+};
+
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    (void) out;
+    assert(fmt->i_cat == AUDIO_ES);
+    return (es_out_id_t *)out;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    struct test_es_out *ctx = (struct test_es_out *)out;
+    (void) id;
+
+    unsigned n = ctx->count++;
+    assert(n < FRAME_COUNT);
+    assert(block->i_buffer == frame_sizes[n]);
+    for (size_t i = 0; i < block->i_buffer; i++)
+        assert(block->p_buffer[i] == n);
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    (void) out;
+    switch (query)
+    {
+        case ES_OUT_GET_ES_STATE:
+            va_arg(args, es_out_id_t *);
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_GET_EMPTY:
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_ES_DEFAULT:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void EsOutDestroy(es_out_t *out)
+{
+    (void) out;
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    if (!module_exists("mkv"))
+    {   /* built without libebml and libmatroska */
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    block_t *file = generate_file();
+
+    struct test_es_out ctx = {
+        .out = {
+            .pf_add = EsOutAdd,
+            .pf_send = EsOutSend,
+            .pf_del = EsOutDel,
+            .pf_control = EsOutControl,
+            .pf_destroy = EsOutDestroy,
+        },
+    };
+
+    stream_t *s = vlc_stream_MemoryNew(obj, file->p_buffer, file->i_buffer,
+                                       true);
+    assert(s != NULL);
+
+    demux_t *demux = demux_New(obj, "mkv", "", s, &ctx.out);
+    assert(demux != NULL);
+
+    while (demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+    printf("mkv: %u frames demuxed\n", ctx.count);
+    assert(ctx.count == FRAME_COUNT);
+
+    demux_Delete(demux);
+    vlc_stream_Delete(s);
+    block_Release(file);
+    libvlc_release(vlc);
+    return 0;
+}
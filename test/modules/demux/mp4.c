@@ -0,0 +1,570 @@
+/*****************************************************************************
+ * mp4.c: MP4 demuxer sample tables and boxes loading test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+#include <vlc_boxes.h>
+#include <vlc_url.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Three hours of 25 fps video with B-frames, and of AC-3 at 48 kHz, laid out
+ * as a camera or a muxer would: one video frame per chunk, every single one
+ * with its own composition offset */
+#define HOURS           3
+#define VIDEO_SAMPLES   (HOURS * 3600 * 25)
+#define VIDEO_SCALE     90000
+#define VIDEO_DELTA     3600
+#define AUDIO_SAMPLES   (HOURS * 3600 * 48000 / 1536)
+#define AUDIO_SCALE     48000
+#define AUDIO_DELTA     1536
+#define AUDIO_PER_CHUNK 4
+#define AUDIO_CHUNKS    (AUDIO_SAMPLES / AUDIO_PER_CHUNK)
+#define MAX_SAMPLE_SIZE 256
+
+/* Composition offsets of an I P B B pattern */
+static const uint32_t cts_pattern[4] = { VIDEO_DELTA, 3 * VIDEO_DELTA, 0, 0 };
+
+static uint32_t video_size(uint32_t n)
+{
+    return 100 + n % 100;
+}
+
+/*****************************************************************************
+ * File generation
+ *****************************************************************************/
+static size_t box_start(bo_t *bo, const char *type)
+{
+    size_t pos = bo->b->i_buffer;
+    bo_add_32be(bo, 0);
+    bo_add_fourcc(bo, type);
+    return pos;
+}
+
+static size_t fullbox_start(bo_t *bo, const char *type, uint32_t flags)
+{
+    size_t pos = box_start(bo, type);
+    bo_add_32be(bo, flags);
+    return pos;
+}
+
+static void box_end(bo_t *bo, size_t pos)
+{
+    bo_swap_32be(bo, pos, bo->b->i_buffer - pos);
+}
+
+static void add_zeros(bo_t *bo, size_t count)
+{
+    while (count--)
+        bo_add_8(bo, 0);
+}
+
+static void add_matrix(bo_t *bo)
+{
+    static const uint32_t matrix[9] = {
+        0x10000, 0, 0, 0, 0x10000, 0, 0, 0, 0x40000000,
+    };
+    for (unsigned i = 0; i < 9; i++)
+        bo_add_32be(bo, matrix[i]);
+}
+
+static void write_trak(bo_t *bo, bool video, const uint32_t *offsets,
+                       uint32_t base)
+{
+    const uint32_t samples = video ? VIDEO_SAMPLES : AUDIO_SAMPLES;
+    const uint32_t chunks = video ? VIDEO_SAMPLES : AUDIO_CHUNKS;
+    const uint32_t scale = video ? VIDEO_SCALE : AUDIO_SCALE;
+    const uint32_t delta = video ? VIDEO_DELTA : AUDIO_DELTA;
+
+    size_t trak = box_start(bo, "trak");
+
+    size_t tkhd = fullbox_start(bo, "tkhd", 0x7);
+    bo_add_32be(bo, 0); /* creation time */
+    bo_add_32be(bo, 0); /* modification time */
+    bo_add_32be(bo, video ? 1 : 2); /* track ID */
+    bo_add_32be(bo, 0);
+    bo_add_32be(bo, HOURS * 3600 * 1000); /* duration */
+    add_zeros(bo, 8);
+    bo_add_16be(bo, 0); /* layer */
+    bo_add_16be(bo, 0); /* alternate group */
+    bo_add_16be(bo, video ? 0 : 0x100); /* volume */
+    bo_add_16be(bo, 0);
+    add_matrix(bo);
+    bo_add_32be(bo, video ? 320 << 16 : 0);
+    bo_add_32be(bo, video ? 240 << 16 : 0);
+    box_end(bo, tkhd);
+
+    size_t mdia = box_start(bo, "mdia");
+
+    size_t mdhd = fullbox_start(bo, "mdhd", 0);
+    bo_add_32be(bo, 0);
+    bo_add_32be(bo, 0);
+    bo_add_32be(bo, scale);
+    bo_add_32be(bo, samples * delta);
+    bo_add_16be(bo, 0x55c4); /* und */
+    bo_add_16be(bo, 0);
+    box_end(bo, mdhd);
+
+    size_t hdlr = fullbox_start(bo, "hdlr", 0);
+    bo_add_32be(bo, 0);
+    bo_add_fourcc(bo, video ? "vide" : "soun");
+    add_zeros(bo, 12);
+    bo_add_8(bo, 0); /* name */
+    box_end(bo, hdlr);
+
+    size_t minf = box_start(bo, "minf");
+    if (video)
+    {
+        size_t vmhd = fullbox_start(bo, "vmhd", 1);
+        add_zeros(bo, 8);
+        box_end(bo, vmhd);
+    }
+    else
+    {
+        size_t smhd = fullbox_start(bo, "smhd", 0);
+        add_zeros(bo, 4);
+        box_end(bo, smhd);
+    }
+
+    size_t stbl = box_start(bo, "stbl");
+
+    size_t stsd = fullbox_start(bo, "stsd", 0);
+    bo_add_32be(bo, 1);
+    if (video)
+    {
+        size_t entry = box_start(bo, "jpeg");
+        add_zeros(bo, 6);
+        bo_add_16be(bo, 1); /* data reference index */
+        add_zeros(bo, 16);
+        bo_add_16be(bo, 320);
+        bo_add_16be(bo, 240);
+        bo_add_32be(bo, 0x480000);
+        bo_add_32be(bo, 0x480000);
+        bo_add_32be(bo, 0);
+        bo_add_16be(bo, 1); /* frame count */
+        add_zeros(bo, 32); /* compressor name */
+        bo_add_16be(bo, 0x18);
+        bo_add_16be(bo, 0xffff);
+        box_end(bo, entry);
+    }
+    else
+    {
+        size_t entry = box_start(bo, "ac-3");
+        add_zeros(bo, 6);
+        bo_add_16be(bo, 1); /* data reference index */
+        add_zeros(bo, 8);
+        bo_add_16be(bo, 2); /* channels */
+        bo_add_16be(bo, 16); /* sample size */
+        bo_add_32be(bo, 0);
+        bo_add_32be(bo, 48000 << 16);
+        box_end(bo, entry);
+    }
+    box_end(bo, stsd);
+
+    size_t stts = fullbox_start(bo, "stts", 0);
+    bo_add_32be(bo, 1);
+    bo_add_32be(bo, samples);
+    bo_add_32be(bo, delta);
+    box_end(bo, stts);
+
+    if (video)
+    {
+        /* One entry per run of equal offsets, that is most samples */
+        size_t ctts = fullbox_start(bo, "ctts", 0);
+        size_t count_pos = bo->b->i_buffer;
+        uint32_t entries = 0;
+        bo_add_32be(bo, 0);
+        for (uint32_t n = 0; n < samples; )
+        {
+            uint32_t run = 1;
+            while (n + run < samples &&
+                   cts_pattern[(n + run) % 4] == cts_pattern[n % 4])
+                run++;
+            bo_add_32be(bo, run);
+            bo_add_32be(bo, cts_pattern[n % 4]);
+            entries++;
+            n += run;
+        }
+        bo_swap_32be(bo, count_pos, entries);
+        box_end(bo, ctts);
+
+        /* One sync sample per second */
+        size_t stss = fullbox_start(bo, "stss", 0);
+        bo_add_32be(bo, samples / 25);
+        for (uint32_t n = 0; n < samples; n += 25)
+            bo_add_32be(bo, n + 1);
+        box_end(bo, stss);
+    }
+
+    size_t stsc = fullbox_start(bo, "stsc", 0);
+    bo_add_32be(bo, 1);
+    bo_add_32be(bo, 1); /* first chunk */
+    bo_add_32be(bo, video ? 1 : AUDIO_PER_CHUNK);
+    bo_add_32be(bo, 1); /* sample description index */
+    box_end(bo, stsc);
+
+    size_t stsz = fullbox_start(bo, "stsz", 0);
+    bo_add_32be(bo, 0);
+    bo_add_32be(bo, samples);
+    for (uint32_t n = 0; n < samples; n++)
+        bo_add_32be(bo, video ? video_size(n) : MAX_SAMPLE_SIZE / AUDIO_PER_CHUNK);
+    box_end(bo, stsz);
+
+    size_t stco = fullbox_start(bo, "stco", 0);
+    bo_add_32be(bo, chunks);
+    for (uint32_t n = 0; n < chunks; n++)
+        bo_add_32be(bo, base + offsets[n]);
+    box_end(bo, stco);
+
+    box_end(bo, stbl);
+    box_end(bo, minf);
+    box_end(bo, mdia);
+    box_end(bo, trak);
+}
+
+static block_t *generate_file(void)
+{
+    uint32_t *video_offsets = malloc(VIDEO_SAMPLES * sizeof (uint32_t));
+    uint32_t *audio_offsets = malloc(AUDIO_CHUNKS * sizeof (uint32_t));
+    assert(video_offsets != NULL && audio_offsets != NULL);
+
+    /* Interleave the chunks in time order. Chunks only start one byte
+     * apart, and overlap: the demuxer does not care about the payload. */
+    uint32_t v = 0, a = 0, pos = 0;
+    while (v < VIDEO_SAMPLES || a < AUDIO_CHUNKS)
+    {
+        if (a >= AUDIO_CHUNKS ||
+            (v < VIDEO_SAMPLES &&
+             (uint64_t)v * VIDEO_DELTA * AUDIO_SCALE <=
+             (uint64_t)a * AUDIO_PER_CHUNK * AUDIO_DELTA * VIDEO_SCALE))
+            video_offsets[v++] = pos++;
+        else
+            audio_offsets[a++] = pos++;
+    }
+
+    bo_t bo;
+    /* Large enough not to be reallocated */
+    if (!bo_init(&bo, 16 << 20))
+        abort();
+
+    size_t ftyp = box_start(&bo, "ftyp");
+    bo_add_fourcc(&bo, "isom");
+    bo_add_32be(&bo, 0x200);
+    bo_add_fourcc(&bo, "isom");
+    bo_add_fourcc(&bo, "mp41");
+    box_end(&bo, ftyp);
+
+    size_t mdat = box_start(&bo, "mdat");
+    const uint32_t base = bo.b->i_buffer;
+    for (uint32_t i = 0; i < pos + MAX_SAMPLE_SIZE; i++)
+        bo_add_8(&bo, i);
+    box_end(&bo, mdat);
+
+    size_t moov = box_start(&bo, "moov");
+    size_t mvhd = fullbox_start(&bo, "mvhd", 0);
+    bo_add_32be(&bo, 0);
+    bo_add_32be(&bo, 0);
+    bo_add_32be(&bo, 1000); /* timescale */
+    bo_add_32be(&bo, HOURS * 3600 * 1000);
+    bo_add_32be(&bo, 0x10000); /* rate */
+    bo_add_16be(&bo, 0x100); /* volume */
+    add_zeros(&bo, 10);
+    add_matrix(&bo);
+    add_zeros(&bo, 24);
+    bo_add_32be(&bo, 3); /* next track ID */
+    box_end(&bo, mvhd);
+    write_trak(&bo, true, video_offsets, base);
+    write_trak(&bo, false, audio_offsets, base);
+    box_end(&bo, moov);
+
+    free(audio_offsets);
+    free(video_offsets);
+    return bo.b;
+}
+
+/*****************************************************************************
+ * ES output checking the timestamps
+ *****************************************************************************/
+struct es_out_id_t
+{
+    int i_cat;
+};
+
+struct test_es_out
+{
+    es_out_t out;
+    uint32_t video_count;
+    uint32_t audio_count;
+    bool check; /* expect every sample in order */
+    vlc_tick_t first_video_dts; /* after seeking */
+};
+
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    (void) out;
+    es_out_id_t *id = malloc(sizeof (*id));
+    assert(id != NULL);
+    id->i_cat = fmt->i_cat;
+    return id;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    struct test_es_out *ctx = (struct test_es_out *)out;
+
+    if (id->i_cat == VIDEO_ES)
+    {
+        uint32_t n = ctx->video_count++;
+        if (ctx->check)
+        {
+            assert(block->i_buffer == video_size(n));
+            assert(block->i_dts == VLC_TICK_0 +
+                   (vlc_tick_t)n * VIDEO_DELTA * CLOCK_FREQ / VIDEO_SCALE);
+            assert(block->i_pts == block->i_dts +
+                   (vlc_tick_t)cts_pattern[n % 4] * CLOCK_FREQ / VIDEO_SCALE);
+        }
+        else if (ctx->first_video_dts == VLC_TICK_INVALID)
+            ctx->first_video_dts = block->i_dts;
+    }
+    else if (id->i_cat == AUDIO_ES)
+    {
+        uint32_t n = ctx->audio_count++;
+        if (ctx->check)
+            assert(block->i_dts == VLC_TICK_0 +
+                   (vlc_tick_t)n * AUDIO_DELTA * CLOCK_FREQ / AUDIO_SCALE);
+    }
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void) out;
+    free(id);
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    (void) out;
+    switch (query)
+    {
+        case ES_OUT_GET_ES_STATE:
+            va_arg(args, es_out_id_t *);
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_GET_EMPTY:
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_ES_DEFAULT:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void EsOutDestroy(es_out_t *out)
+{
+    (void) out;
+}
+
+/* Resident memory, in kiB */
+static long resident_memory(void)
+{
+    long rss = -1;
+#ifdef __linux__
+    FILE *stream = fopen("/proc/self/statm", "r");
+    if (stream != NULL)
+    {
+        long size;
+        if (fscanf(stream, "%ld %ld", &size, &rss) != 2)
+            rss = -1;
+        else
+            rss *= sysconf(_SC_PAGESIZE) / 1024;
+        fclose(stream);
+    }
+#endif
+    return rss;
+}
+
+/*****************************************************************************
+ * Stream seeking slowly, as network ones do, backed by a file for the second
+ * access reading the boxes after the mdat
+ *****************************************************************************/
+static int (*memory_seek)(stream_t *, uint64_t);
+static int (*memory_control)(stream_t *, int, va_list);
+static uint64_t max_seek; /* farthest position seeked to */
+
+static int SlowSeek(stream_t *s, uint64_t offset)
+{
+    if (offset > max_seek)
+        max_seek = offset;
+    return memory_seek(s, offset);
+}
+
+static int SlowControl(stream_t *s, int query, va_list args)
+{
+    if (query == STREAM_CAN_FASTSEEK)
+    {
+        *va_arg(args, bool *) = false;
+        return VLC_SUCCESS;
+    }
+    return memory_control(s, query, args);
+}
+
+static void test_tail(vlc_object_t *obj, block_t *file,
+                      struct test_es_out *ctx)
+{
+    char path[] = "/tmp/vlc-test-mp4-XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    assert(write(fd, file->p_buffer, file->i_buffer) == (ssize_t)file->i_buffer);
+    close(fd);
+
+    /* The moov follows the mdat */
+    size_t moov = 0;
+    while (memcmp(&file->p_buffer[moov + 4], "moov", 4))
+        moov++;
+
+    stream_t *s = vlc_stream_MemoryNew(obj, file->p_buffer, file->i_buffer,
+                                       true);
+    assert(s != NULL);
+    s->psz_url = vlc_path2uri(path, "file");
+    assert(s->psz_url != NULL);
+    memory_seek = s->pf_seek;
+    memory_control = s->pf_control;
+    s->pf_seek = SlowSeek;
+    s->pf_control = SlowControl;
+
+    ctx->video_count = ctx->audio_count = 0;
+    ctx->check = true;
+    max_seek = 0;
+
+    mtime_t start = mdate();
+    demux_t *demux = demux_New(obj, "mp4", "", s, &ctx->out);
+    assert(demux != NULL);
+    printf("mp4: opened with the tail fetched in %"PRId64" ms\n",
+           (mdate() - start) / 1000);
+
+    /* The moov was read from the other access */
+    assert(max_seek < moov);
+
+    int64_t length;
+    assert(demux_Control(demux, DEMUX_GET_LENGTH, &length) == VLC_SUCCESS);
+    assert(length == (int64_t)HOURS * 3600 * CLOCK_FREQ);
+    while (ctx->video_count < 1000 &&
+           demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+    assert(ctx->video_count >= 1000);
+
+    demux_Delete(demux);
+    vlc_stream_Delete(s);
+    unlink(path);
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    block_t *file = generate_file();
+    printf("mp4: %d hours, %d + %d samples, %zu bytes file\n",
+           HOURS, VIDEO_SAMPLES, AUDIO_SAMPLES, file->i_buffer);
+
+    struct test_es_out ctx = {
+        .out = {
+            .pf_add = EsOutAdd,
+            .pf_send = EsOutSend,
+            .pf_del = EsOutDel,
+            .pf_control = EsOutControl,
+            .pf_destroy = EsOutDestroy,
+        },
+        .check = true,
+        .first_video_dts = VLC_TICK_INVALID,
+    };
+
+    stream_t *s = vlc_stream_MemoryNew(obj, file->p_buffer, file->i_buffer,
+                                       true);
+    assert(s != NULL);
+
+    /* Open time and memory */
+    long rss = resident_memory();
+    mtime_t start = mdate();
+    demux_t *demux = demux_New(obj, "mp4", "", s, &ctx.out);
+    mtime_t open_time = mdate() - start;
+    assert(demux != NULL);
+    if (rss >= 0)
+        rss = resident_memory() - rss;
+
+    printf("mp4: opened in %"PRId64" ms, using %ld kiB\n",
+           open_time / 1000, rss);
+
+    int64_t length;
+    assert(demux_Control(demux, DEMUX_GET_LENGTH, &length) == VLC_SUCCESS);
+    assert(length == (int64_t)HOURS * 3600 * CLOCK_FREQ);
+
+    /* Read everything in order */
+    start = mdate();
+    while (demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+    printf("mp4: demuxed in %"PRId64" ms\n", (mdate() - start) / 1000);
+    assert(ctx.video_count == VIDEO_SAMPLES);
+    assert(ctx.audio_count == AUDIO_SAMPLES);
+
+    /* Seek to the middle of a second, and land on the previous sync sample */
+    const vlc_tick_t target = CLOCK_FREQ * 3600 + CLOCK_FREQ / 2;
+    ctx.check = false;
+    start = mdate();
+    assert(demux_Control(demux, DEMUX_SET_TIME, target, false) == VLC_SUCCESS);
+    while (ctx.first_video_dts == VLC_TICK_INVALID &&
+           demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+    printf("mp4: seeked in %"PRId64" us\n", mdate() - start);
+    assert(ctx.first_video_dts != VLC_TICK_INVALID);
+    assert(ctx.first_video_dts <= VLC_TICK_0 + target);
+    assert(ctx.first_video_dts > VLC_TICK_0 + target - CLOCK_FREQ);
+
+    demux_Delete(demux);
+    vlc_stream_Delete(s);
+
+    test_tail(obj, file, &ctx);
+
+    block_Release(file);
+    libvlc_release(vlc);
+    return 0;
+}
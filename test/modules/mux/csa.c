@@ -0,0 +1,147 @@
+/*****************************************************************************
+ * csa.c: CSA scrambling test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TS_NO_CSA_CK_MSG
+#include <vlc_common.h>
+#include "../modules/mux/mpeg/csa.h"
+#include "../modules/mux/mpeg/csa.c"
+
+/* csa.c logs, which needs the name defined by vlc_plugin.h in modules */
+const char vlc_module_name[] = "csa";
+
+#define PACKETS 1000
+
+static void fill_packets( uint8_t (*p_pkts)[188], int i_count )
+{
+    for( int i = 0; i < i_count; i++ )
+    {
+        for( int j = 0; j < 188; j++ )
+            p_pkts[i][j] = rand() & 0xff;
+        p_pkts[i][0] = 0x47;
+        p_pkts[i][3] = 0x10;
+        /* adaptation field of various lengths, including no payload
+         * and payloads without a full block */
+        if( i % 3 )
+        {
+            p_pkts[i][3] |= 0x20;
+            p_pkts[i][4] = ( i * 7 ) % 184;
+        }
+    }
+}
+
+static void test_batch( csa_t *c, int i_count, int i_pkt_size )
+{
+    uint8_t (*p_ref)[188] = malloc( i_count * 188 );
+    uint8_t (*p_out)[188] = malloc( i_count * 188 );
+    uint8_t **pp = malloc( i_count * sizeof(*pp) );
+    assert( p_ref && p_out && pp );
+
+    fill_packets( p_ref, i_count );
+    memcpy( p_out, p_ref, i_count * 188 );
+
+    for( int i = 0; i < i_count; i++ )
+    {
+        csa_Encrypt( c, p_ref[i], i_pkt_size );
+        pp[i] = p_out[i];
+    }
+    csa_EncryptBatch( c, pp, i_count, i_pkt_size );
+
+    for( int i = 0; i < i_count; i++ )
+    {
+        if( memcmp( p_ref[i], p_out[i], 188 ) )
+        {
+            fprintf( stderr, "mismatch on packet %d/%d (size %d)\n",
+                     i, i_count, i_pkt_size );
+            abort();
+        }
+    }
+
+    free( pp );
+    free( p_out );
+    free( p_ref );
+}
+
+static void benchmark( csa_t *c )
+{
+    uint8_t (*p_pkts)[188] = malloc( PACKETS * 188 );
+    uint8_t **pp = malloc( PACKETS * sizeof(*pp) );
+    assert( p_pkts && pp );
+    fill_packets( p_pkts, PACKETS );
+    for( int i = 0; i < PACKETS; i++ )
+        pp[i] = p_pkts[i];
+
+    mtime_t i_start = mdate();
+    for( int i = 0; i < PACKETS; i++ )
+        csa_Encrypt( c, p_pkts[i], 188 );
+    mtime_t i_scalar = mdate() - i_start;
+
+    i_start = mdate();
+    csa_EncryptBatch( c, pp, PACKETS, 188 );
+    mtime_t i_batch = mdate() - i_start;
+
+    printf( "csa: %d packets, scalar %"PRId64" us (%.1f Mbit/s), "
+            "batch %"PRId64" us (%.1f Mbit/s)\n", PACKETS,
+            i_scalar, i_scalar ? 188. * 8 * PACKETS / i_scalar : 0.,
+            i_batch, i_batch ? 188. * 8 * PACKETS / i_batch : 0. );
+
+    free( pp );
+    free( p_pkts );
+}
+
+int main( void )
+{
+    char psz_odd[] = "0x0123456789abcdef";
+    char psz_even[] = "fedcba9876543210";
+    csa_t *c = csa_New();
+    assert( c );
+
+    srand( 42 );
+    assert( csa_SetCW( NULL, c, psz_odd, true ) == VLC_SUCCESS );
+    assert( csa_SetCW( NULL, c, psz_even, false ) == VLC_SUCCESS );
+
+    for( int i_key = 0; i_key < 2; i_key++ )
+    {
+        csa_UseKey( NULL, c, i_key );
+        const int counts[] = { 1, 7, 8, 63, 64, 65, 200, 513 };
+        for( size_t i = 0; i < ARRAY_SIZE(counts); i++ )
+        {
+            test_batch( c, counts[i], 188 );
+            test_batch( c, counts[i], 184 );
+        }
+    }
+
+    benchmark( c );
+
+    csa_Delete( c );
+    return 0;
+}